@@ -1,28 +1,40 @@
-uniform vec2  u_center;
-uniform float u_radius;
-uniform vec4  u_color;
-uniform float u_time;
+// Batched bubble shader: one draw covers every body, shine and pop ring
+// (see BubbleBatch). The instance color comes in as the vertex color and the
+// atlas region tells bodies from everything else.
+uniform sampler2D u_texture;
+uniform vec2 u_atlas;   // atlas size in pixels; the body disc is u_atlas.y wide
 
 void main()
 {
-    vec2 p = gl_FragCoord.xy;
-    float dist = length(p - u_center);
+    vec2 uv  = gl_TexCoord[0].xy;
+    vec4 tex = texture2D(u_texture, uv);
+    vec4 col = gl_Color;
 
-    if (dist > u_radius) {
-        discard;
+    float disc = u_atlas.y;
+    vec2 px = uv * u_atlas;
+
+    // shines and rings: plain tinted texture
+    if (px.x >= disc) {
+        gl_FragColor = col * tex;
+        return;
     }
 
-    float x = dist / u_radius; // 0 center -> 1 edge
+    vec2 local = (px - vec2(disc * 0.5)) / (disc * 0.5);
+    float x = length(local); // 0 center -> 1 edge
+
+    if (x > 1.0) {
+        discard;
+    }
 
     float edge  = smoothstep(0.8, 1.0, x);
     float glow  = 1.0 - smoothstep(0.0, 0.6, x);
 
-    vec3 base  = u_color.rgb;
+    vec3 base  = col.rgb;
     vec3 inner = base * 1.4;
     vec3 color = mix(inner, base, x);
 
     color += 0.15 * glow;
 
-    float alpha = u_color.a / 255.0 * (1.0 - 0.6 * edge);
+    float alpha = col.a * (1.0 - 0.6 * edge) * tex.a;
     gl_FragColor = vec4(color, alpha);
 }
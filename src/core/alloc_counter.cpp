@@ -0,0 +1,49 @@
+#include "alloc_counter.hpp"
+
+#ifdef PHYS_COUNT_ALLOCS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::uint64_t> gAllocations(0);
+
+static void* countedAlloc(std::size_t size, std::size_t align) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+
+    void* p = nullptr;
+    if (align <= alignof(std::max_align_t)) {
+        p = std::malloc(size);
+    } else {
+        // aligned_alloc wants size to be a multiple of the alignment
+        p = std::aligned_alloc(align, (size + align - 1) / align * align);
+    }
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size) { return countedAlloc(size, 0); }
+void* operator new[](std::size_t size) { return countedAlloc(size, 0); }
+void* operator new(std::size_t size, std::align_val_t a) { return countedAlloc(size, static_cast<std::size_t>(a)); }
+void* operator new[](std::size_t size, std::align_val_t a) { return countedAlloc(size, static_cast<std::size_t>(a)); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+bool allocationCountingEnabled() { return true; }
+std::uint64_t allocationCount() { return gAllocations.load(std::memory_order_relaxed); }
+
+#else
+
+bool allocationCountingEnabled() { return false; }
+std::uint64_t allocationCount() { return 0; }
+
+#endif
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Test hook for the allocation-free frame loop. Built with
+// -DPHYS_COUNT_ALLOCS, alloc_counter.cpp replaces the global operator new and
+// counts every call; otherwise allocationCountingEnabled() is false and the
+// count stays 0.
+
+bool allocationCountingEnabled();
+std::uint64_t allocationCount();
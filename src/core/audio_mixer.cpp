@@ -0,0 +1,94 @@
+#include "audio_mixer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// mix() works through its output in blocks of this many frames
+const std::size_t kBlockFrames = 512;
+
+} // namespace
+
+AudioEvent popSound(const SimEvent& e, float worldWidth) {
+    AudioEvent a;
+    a.gain = std::min(std::max(e.radius / 25.f, 0.4f), 1.f);
+    a.pan = worldWidth > 0.f ? std::min(std::max(e.x / worldWidth * 2.f - 1.f, -1.f), 1.f) : 0.f;
+    a.pitch = std::min(std::max(std::sqrt(15.f / std::max(e.radius, 1.f)), 0.7f), 1.6f);
+    return a;
+}
+
+PopMixer::PopMixer(const AudioClip& clip, std::size_t voices, std::size_t queue)
+    : clip_(clip), voices_(voices), queue_(queue), accum_(kBlockFrames * kChannels) {}
+
+bool PopMixer::post(const AudioEvent& e) {
+    posted_.fetch_add(1, std::memory_order_relaxed);
+    if (queue_.push(e)) return true;
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void PopMixer::start(const AudioEvent& e) {
+    if (voices_.empty() || clip_.samples.empty()) return;
+
+    Voice* v = nullptr;
+    for (Voice& candidate : voices_) {
+        if (!candidate.active) {
+            v = &candidate;
+            break;
+        }
+    }
+    if (!v) {
+        // all busy: the one with the least left to play
+        const float end = static_cast<float>(clip_.samples.size());
+        v = &*std::min_element(voices_.begin(), voices_.end(), [end](const Voice& a, const Voice& b) {
+            return (end - a.position) / a.step < (end - b.position) / b.step;
+        });
+        stolen_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // constant-power pan
+    const float angle = (e.pan + 1.f) * 0.25f * 3.14159265f;
+    v->position = 0.f;
+    v->step = e.pitch;
+    v->left = e.gain * std::cos(angle);
+    v->right = e.gain * std::sin(angle);
+    v->active = true;
+}
+
+void PopMixer::mix(std::int16_t* out, std::size_t frames) {
+    AudioEvent e;
+    while (queue_.pop(e)) start(e);
+
+    const float* clip = clip_.samples.data();
+    const float last = static_cast<float>(clip_.samples.size()) - 1.f;
+
+    while (frames > 0) {
+        const std::size_t n = std::min(frames, kBlockFrames);
+        std::fill(accum_.begin(), accum_.begin() + n * kChannels, 0.f);
+
+        for (Voice& v : voices_) {
+            if (!v.active) continue;
+            float* a = accum_.data();
+            std::size_t k = 0;
+            for (; k < n && v.position < last; k++, a += kChannels) {
+                // linear interpolation, for pitches other than 1
+                const std::size_t i = static_cast<std::size_t>(v.position);
+                const float t = v.position - static_cast<float>(i);
+                const float s = clip[i] + (clip[i + 1] - clip[i]) * t;
+                a[0] += s * v.left;
+                a[1] += s * v.right;
+                v.position += v.step;
+            }
+            if (k < n) v.active = false;
+        }
+
+        const float gain = masterGain * 32767.f;
+        for (std::size_t k = 0; k < n * kChannels; k++) {
+            const float s = std::min(std::max(accum_[k] * gain, -32768.f), 32767.f);
+            out[k] = static_cast<std::int16_t>(s);
+        }
+        out += n * kChannels;
+        frames -= n;
+    }
+}
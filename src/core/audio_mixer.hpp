@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "spsc_ring.hpp"
+#include "wav.hpp"
+#include "world.hpp"
+
+// Pop sounds mixed in software into one stereo stream, instead of one sound
+// source per pop.
+//
+// The sim thread post()s an event per pop into a lock-free queue; whoever
+// produces the audio (the sound stream's thread in the sims, the step loop
+// in the headless runner) calls mix(), which starts the queued pops and adds
+// every playing voice into one buffer. There is a fixed number of voices:
+// when all are busy, a new pop takes over the voice closest to its end,
+// which is the one that is least audible. Nothing allocates after
+// construction, and neither side ever waits for the other.
+
+struct AudioEvent {
+    float gain = 1.f;   // 0..1
+    float pan = 0.f;    // -1 left .. 1 right
+    float pitch = 1.f;  // playback rate
+};
+
+// How a pop sounds: smaller bubbles pop higher and quieter, and the sound
+// comes from where the bubble was.
+AudioEvent popSound(const SimEvent& e, float worldWidth);
+
+class PopMixer {
+public:
+    static const unsigned int kChannels = 2;
+
+    PopMixer(const AudioClip& clip, std::size_t voices = 32, std::size_t queue = 1024);
+
+    // Sim thread. False if the queue is full and the pop was dropped.
+    bool post(const AudioEvent& e);
+
+    // Audio thread: starts the queued pops and writes `frames` interleaved
+    // stereo frames of everything playing.
+    void mix(std::int16_t* out, std::size_t frames);
+
+    unsigned int sampleRate() const { return clip_.sampleRate; }
+    float masterGain = 0.6f;
+
+    // Readable from any thread.
+    std::uint64_t posted() const { return posted_.load(std::memory_order_relaxed); }
+    std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    std::uint64_t stolen() const { return stolen_.load(std::memory_order_relaxed); }
+
+private:
+    struct Voice {
+        float position = 0.f;   // in clip samples
+        float step = 1.f;
+        float left = 0.f, right = 0.f;
+        bool active = false;
+    };
+
+    void start(const AudioEvent& e);
+
+    const AudioClip& clip_;
+    std::vector<Voice> voices_;
+    SpscRing<AudioEvent> queue_;
+    std::vector<float> accum_;      // one block of stereo frames
+
+    std::atomic<std::uint64_t> posted_{ 0 }, dropped_{ 0 }, stolen_{ 0 };
+};
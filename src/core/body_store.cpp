@@ -0,0 +1,101 @@
+#include "body_store.hpp"
+
+void BodyStore::reserve(std::size_t n) {
+    x.reserve(n);
+    y.reserve(n);
+    px.reserve(n);
+    py.reserve(n);
+    vx.reserve(n);
+    vy.reserve(n);
+    radius.reserve(n);
+    invMass.reserve(n);
+    age.reserve(n);
+    sleepTime.reserve(n);
+    flags.reserve(n);
+    id.reserve(n);
+    color.reserve(n);
+}
+
+void BodyStore::push(const Body& b) {
+    x.push_back(b.x);
+    y.push_back(b.y);
+    px.push_back(b.x);
+    py.push_back(b.y);
+    vx.push_back(b.vx);
+    vy.push_back(b.vy);
+    radius.push_back(b.radius);
+    invMass.push_back(1.f / massOf(b.radius));
+    age.push_back(b.age);
+    sleepTime.push_back(0.f);
+    flags.push_back(b.canMerge ? BodyCanMerge : 0);
+    id.push_back(b.id);
+    color.push_back(b.color);
+}
+
+Body BodyStore::get(std::size_t i) const {
+    Body b;
+    b.x = x[i];
+    b.y = y[i];
+    b.vx = vx[i];
+    b.vy = vy[i];
+    b.radius = radius[i];
+    b.age = age[i];
+    b.canMerge = canMerge(i);
+    b.id = id[i];
+    b.color = color[i];
+    return b;
+}
+
+void BodyStore::set(std::size_t i, const Body& b) {
+    x[i] = b.x;
+    y[i] = b.y;
+    px[i] = b.x;
+    py[i] = b.y;
+    vx[i] = b.vx;
+    vy[i] = b.vy;
+    radius[i] = b.radius;
+    invMass[i] = 1.f / massOf(b.radius);
+    age[i] = b.age;
+    sleepTime[i] = 0.f;
+    flags[i] = b.canMerge ? BodyCanMerge : 0;
+    id[i] = b.id;
+    color[i] = b.color;
+}
+
+void BodyStore::move(std::size_t from, std::size_t to) {
+    x[to] = x[from];
+    y[to] = y[from];
+    px[to] = px[from];
+    py[to] = py[from];
+    vx[to] = vx[from];
+    vy[to] = vy[from];
+    radius[to] = radius[from];
+    invMass[to] = invMass[from];
+    age[to] = age[from];
+    sleepTime[to] = sleepTime[from];
+    flags[to] = flags[from];
+    id[to] = id[from];
+    color[to] = color[from];
+}
+
+void BodyStore::swapRemove(std::size_t i) {
+    std::size_t last = size() - 1;
+    if (i != last) move(last, i);
+    resize(last);
+}
+
+void BodyStore::resize(std::size_t n) {
+    x.resize(n);
+    y.resize(n);
+    px.resize(n);
+    py.resize(n);
+    vx.resize(n);
+    vy.resize(n);
+    radius.resize(n);
+    invMass.resize(n);
+    age.resize(n);
+    sleepTime.resize(n);
+    flags.resize(n);
+    id.resize(n);
+    color.resize(n);
+}
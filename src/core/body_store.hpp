@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// Structure-of-arrays storage for bodies. Each field lives in its own
+// 64-byte aligned array so the integration kernels can stream through
+// exactly the data they touch.
+
+template <class T, std::size_t Align = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <class U> struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() = default;
+    template <class U> AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template <class U> bool operator==(const AlignedAllocator<U, Align>&) const { return true; }
+    template <class U> bool operator!=(const AlignedAllocator<U, Align>&) const { return false; }
+};
+
+template <class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+struct Rgba {
+    std::uint8_t r = 255, g = 255, b = 255, a = 255;
+};
+
+enum BodyFlags : std::uint8_t {
+    BodyCanMerge = 1 << 0,
+    BodyAsleep   = 1 << 1,     // settled: no gravity, no velocity, see WorldConfig::sleeping
+};
+
+// Bodies have unit density, so a body's mass is its area; pi is left out
+// since only mass ratios matter.
+inline float massOf(float radius) { return radius * radius; }
+
+// One body as a plain value, for spawning and for reading a single entry.
+struct Body {
+    float x = 0.f, y = 0.f;     // center
+    float vx = 0.f, vy = 0.f;
+    float radius = 1.f;
+    float age = 0.f;
+    bool canMerge = true;
+    Rgba color;
+    std::uint32_t id = 0;       // assigned by the World, never reused
+};
+
+struct BodyStore {
+    AlignedVector<float> x, y;      // centers
+    AlignedVector<float> px, py;    // centers at the last savePrevious(), for interpolation
+    AlignedVector<float> vx, vy;
+    AlignedVector<float> radius;
+    AlignedVector<float> invMass;   // 1 / massOf(radius)
+    AlignedVector<float> age;
+    AlignedVector<float> sleepTime;     // seconds spent below WorldConfig::sleepSpeed
+    AlignedVector<std::uint8_t> flags;
+    AlignedVector<std::uint32_t> id;
+    std::vector<Rgba> color;        // only the renderer reads this
+
+    std::size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+
+    bool canMerge(std::size_t i) const { return flags[i] & BodyCanMerge; }
+    bool asleep(std::size_t i) const { return flags[i] & BodyAsleep; }
+
+    void wake(std::size_t i) {
+        flags[i] &= ~BodyAsleep;
+        sleepTime[i] = 0.f;
+    }
+
+    void reserve(std::size_t n);
+    void push(const Body& b);
+    Body get(std::size_t i) const;
+    // Overwrites body i with b, as push() would have stored it.
+    void set(std::size_t i, const Body& b);
+
+    // Copies body `from` over slot `to` (used when compacting).
+    void move(std::size_t from, std::size_t to);
+    // Removes body i in O(1); the last body takes its index.
+    void swapRemove(std::size_t i);
+    void resize(std::size_t n);
+    void clear() { resize(0); }
+};
@@ -0,0 +1,255 @@
+#include "ccd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const std::uint32_t kWallX = 0xffffffffu;
+const std::uint32_t kWallY = 0xfffffffeu;
+
+// A body that keeps hitting things within one step is in a pile; after
+// this many impacts it just finishes the step and the discrete contacts
+// take over.
+const std::uint32_t kMaxImpactsPerBody = 16;
+
+// Heap order: earliest impact first, ties broken by body index so the
+// order never depends on how the heap happens to be laid out.
+struct Later {
+    template <class E>
+    bool operator()(const E& x, const E& y) const {
+        if (x.t != y.t) return x.t > y.t;
+        if (x.a != y.a) return x.a > y.a;
+        return x.b > y.b;
+    }
+};
+
+} // namespace
+
+void SweptIntegrator::integrate(BodyStore& s, const IntegrateParams& p, float restitutionBall, SimdLevel simd) {
+    params_ = p;
+    restitutionBall_ = restitutionBall;
+    hits_.clear();
+    heap_.clear();
+
+    const std::size_t n = s.size();
+    if (n == 0) return;
+
+    // age and gravity first, as integrateBodies does before it moves anything
+    const float gdt = p.gravity * p.dt;
+    const std::uint8_t still = p.sleeping ? BodyAsleep : 0;
+    for (std::size_t i = 0; i < n; i++) {
+        s.age[i] += p.dt;
+        if (!(s.flags[i] & still)) s.vy[i] += gdt;
+    }
+
+    time_.assign(n, 0.f);
+    version_.assign(n, 0);
+    impacts_.assign(n, 0);
+
+    buildCandidates(s);
+
+    heap_.reserve(pairA_.size() + n);
+    for (std::uint32_t i = 0; i < n; i++) {
+        scheduleWall(s, i, 0.f);
+    }
+    for (std::size_t k = 0; k < pairA_.size(); k++) {
+        schedulePair(s, pairA_[k], pairB_[k], 0.f);
+    }
+
+    while (!heap_.empty()) {
+        std::pop_heap(heap_.begin(), heap_.end(), Later());
+        Event e = heap_.back();
+        heap_.pop_back();
+
+        const bool wall = e.b >= kWallY;
+        if (e.versionA != version_[e.a]) continue;
+        if (!wall && e.versionB != version_[e.b]) continue;
+
+        resolve(s, e);
+
+        version_[e.a]++;
+        if (++impacts_[e.a] < kMaxImpactsPerBody) schedule(s, e.a, e.t);
+        if (!wall) {
+            version_[e.b]++;
+            if (++impacts_[e.b] < kMaxImpactsPerBody) schedule(s, e.b, e.t);
+        }
+    }
+
+    // finish everyone's step; a body that hit nothing moves by exactly v * dt
+    for (std::uint32_t i = 0; i < n; i++) {
+        advance(s, i, 1.f);
+    }
+
+    // walls as a backstop for bodies that started outside or gave up early:
+    // the regular kernel with nothing left to move
+    IntegrateParams clamp = p;
+    clamp.dt = 0.f;
+    clamp.gravity = 0.f;
+    integrateBodies(s, clamp, simd);
+}
+
+// Pairs whose swept bounds overlap: the only pairs that can touch during
+// the step on their current paths.
+void SweptIntegrator::buildCandidates(const BodyStore& s) {
+    const std::size_t n = s.size();
+    const float half = 0.5f * params_.dt;
+
+    mx_.resize(n);
+    my_.resize(n);
+    reach_.resize(n);
+    float maxReach = 0.f;
+    for (std::size_t i = 0; i < n; i++) {
+        mx_[i] = s.x[i] + s.vx[i] * half;
+        my_[i] = s.y[i] + s.vy[i] * half;
+        reach_[i] = s.radius[i] + std::sqrt(s.vx[i] * s.vx[i] + s.vy[i] * s.vy[i]) * half;
+        maxReach = std::max(maxReach, reach_[i]);
+    }
+    grid_.build(mx_.data(), my_.data(), n, maxReach);
+
+    pairA_.clear();
+    pairB_.clear();
+    grid_.forEachPair([&](std::uint32_t i, std::uint32_t j) {
+        float dx = mx_[j] - mx_[i];
+        float dy = my_[j] - my_[i];
+        float reach = reach_[i] + reach_[j];
+        if (dx * dx + dy * dy < reach * reach) {
+            pairA_.push_back(i);
+            pairB_.push_back(j);
+        }
+    });
+
+    adjStart_.assign(n + 1, 0);
+    for (std::size_t k = 0; k < pairA_.size(); k++) {
+        adjStart_[pairA_[k] + 1]++;
+        adjStart_[pairB_[k] + 1]++;
+    }
+    for (std::size_t i = 1; i <= n; i++) {
+        adjStart_[i] += adjStart_[i - 1];
+    }
+    adj_.resize(adjStart_[n]);
+    cursor_.assign(adjStart_.begin(), adjStart_.end() - 1);
+    for (std::size_t k = 0; k < pairA_.size(); k++) {
+        adj_[cursor_[pairA_[k]]++] = pairB_[k];
+        adj_[cursor_[pairB_[k]]++] = pairA_[k];
+    }
+}
+
+void SweptIntegrator::schedule(const BodyStore& s, std::uint32_t i, float now) {
+    scheduleWall(s, i, now);
+    for (std::uint32_t k = adjStart_[i]; k < adjStart_[i + 1]; k++) {
+        schedulePair(s, i, adj_[k], now);
+    }
+}
+
+// First wall the body reaches after `now`, if any before the step ends.
+// Walls are tested as x + r against W, like the integration kernel.
+void SweptIntegrator::scheduleWall(const BodyStore& s, std::uint32_t i, float now) {
+    const float dt = params_.dt;
+    const float lead = (now - time_[i]) * dt;
+    const float r = s.radius[i];
+
+    float best = 2.f;
+    std::uint32_t axis = kWallX;
+    auto test = [&](float pos, float vel, float limit, std::uint32_t which) {
+        float u;
+        if (vel < 0.f && pos >= r)              u = (r - pos) / (vel * dt);
+        else if (vel > 0.f && pos + r <= limit) u = (limit - r - pos) / (vel * dt);
+        else return;
+        if (now + u < best) {
+            best = now + u;
+            axis = which;
+        }
+    };
+    test(s.x[i] + s.vx[i] * lead, s.vx[i], params_.width, kWallX);
+    test(s.y[i] + s.vy[i] * lead, s.vy[i], params_.height, kWallY);
+
+    if (best <= 1.f) {
+        heap_.push_back({ best, i, axis, version_[i], 0 });
+        std::push_heap(heap_.begin(), heap_.end(), Later());
+    }
+}
+
+// Time the two circles first touch, from where both are at `now`. Pairs
+// that already overlap or are moving apart get nothing.
+void SweptIntegrator::schedulePair(const BodyStore& s, std::uint32_t i, std::uint32_t j, float now) {
+    const float dt = params_.dt;
+    const float leadI = (now - time_[i]) * dt;
+    const float leadJ = (now - time_[j]) * dt;
+
+    float dx = (s.x[j] + s.vx[j] * leadJ) - (s.x[i] + s.vx[i] * leadI);
+    float dy = (s.y[j] + s.vy[j] * leadJ) - (s.y[i] + s.vy[i] * leadI);
+    float wx = (s.vx[j] - s.vx[i]) * dt;
+    float wy = (s.vy[j] - s.vy[i]) * dt;
+    float R = s.radius[i] + s.radius[j];
+
+    float c = dx * dx + dy * dy - R * R;
+    float b = dx * wx + dy * wy;
+    if (c <= 0.f || b >= 0.f) return;
+
+    float a = wx * wx + wy * wy;
+    float disc = b * b - a * c;
+    if (disc < 0.f) return;
+
+    // smaller root of a u^2 + 2 b u + c = 0, in the stable form
+    float u = c / (-b + std::sqrt(disc));
+    if (now + u > 1.f) return;
+
+    std::uint32_t lo = std::min(i, j), hi = std::max(i, j);
+    heap_.push_back({ now + u, lo, hi, version_[lo], version_[hi] });
+    std::push_heap(heap_.begin(), heap_.end(), Later());
+}
+
+void SweptIntegrator::advance(BodyStore& s, std::uint32_t i, float to) {
+    const float step = (to - time_[i]) * params_.dt;
+    s.x[i] += s.vx[i] * step;
+    s.y[i] += s.vy[i] * step;
+    time_[i] = to;
+}
+
+void SweptIntegrator::resolve(BodyStore& s, const Event& e) {
+    const std::uint32_t i = e.a;
+    advance(s, i, e.t);
+
+    if (e.b == kWallX || e.b == kWallY) {
+        const float r = s.radius[i];
+        const float en = params_.restitution;
+        // slow hits stop dead, as under RestingWalls
+        auto bounce = [&](float v) { return std::fabs(v) < params_.restingSpeed ? 0.f : -v * en; };
+        if (e.b == kWallX) {
+            s.x[i] = s.vx[i] < 0.f ? r : params_.width - r;
+            s.vx[i] = bounce(s.vx[i]);
+        } else {
+            s.y[i] = s.vy[i] < 0.f ? r : params_.height - r;
+            s.vy[i] = bounce(s.vy[i]);
+        }
+        return;
+    }
+
+    const std::uint32_t j = e.b;
+    advance(s, j, e.t);
+
+    // a sleeping body that gets hit is moving again
+    if (s.asleep(i)) s.wake(i);
+    if (s.asleep(j)) s.wake(j);
+
+    float dx = s.x[j] - s.x[i];
+    float dy = s.y[j] - s.y[i];
+    float dist = std::sqrt(dx * dx + dy * dy);
+    if (!(dist > 0.f)) return;
+    float nx = dx / dist, ny = dy / dist;
+
+    // same impulse as the contact solver: approaches slower than
+    // restingSpeed don't bounce
+    const float mi = s.invMass[i], mj = s.invMass[j];
+    float velAlongNormal = (s.vx[j] - s.vx[i]) * nx + (s.vy[j] - s.vy[i]) * ny;
+    if (velAlongNormal < 0) {
+        const float e = velAlongNormal < -params_.restingSpeed ? restitutionBall_ : 0.f;
+        float jImpulse = -(1 + e) * velAlongNormal / (mi + mj);
+        s.vx[i] -= jImpulse * nx * mi;
+        s.vy[i] -= jImpulse * ny * mi;
+        s.vx[j] += jImpulse * nx * mj;
+        s.vy[j] += jImpulse * ny * mj;
+    }
+    hits_.push_back({ i, j, nx, ny, 0.f });
+}
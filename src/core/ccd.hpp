@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "body_store.hpp"
+#include "contacts.hpp"
+#include "kernels.hpp"
+#include "uniform_grid.hpp"
+
+// Continuous collision detection: a replacement for integrateBodies() that
+// sweeps each body along its path for the step instead of teleporting it.
+//
+// Candidate pairs come from a grid over each body's swept bounds (the circle
+// around the midpoint of its path that contains the whole path). Times of
+// impact with other bodies and with the walls go into a queue and are
+// handled earliest first: both bodies are advanced to the moment they touch,
+// the impact is resolved with the same impulse the contact solver uses, and
+// their later impacts are recomputed from there. Bodies that already overlap
+// at the start of the step are left to the discrete contacts as before, and
+// an impact a body only reaches through a pair the swept grid didn't list
+// (after a collision sent it somewhere new) falls back to them as well.
+//
+// Results depend only on body order, never on timing or threads.
+class SweptIntegrator {
+public:
+    // Ages, applies gravity and moves every body through p.dt like
+    // integrateBodies, stopping at impacts along the way.
+    void integrate(BodyStore& s, const IntegrateParams& p, float restitutionBall, SimdLevel simd);
+
+    // Body-body impacts of the last integrate(), as contacts with a < b,
+    // the normal at the moment of impact and zero penetration, so rules that
+    // react to touching bodies (pops, merges) still see them.
+    const std::vector<Contact>& hits() const { return hits_; }
+
+private:
+    struct Event {
+        float t;                    // fraction of the step, 0..1
+        std::uint32_t a, b;         // b is kWallX / kWallY for wall hits
+        std::uint32_t versionA, versionB;
+    };
+
+    void buildCandidates(const BodyStore& s);
+    void schedule(const BodyStore& s, std::uint32_t i, float now);
+    void scheduleWall(const BodyStore& s, std::uint32_t i, float now);
+    void schedulePair(const BodyStore& s, std::uint32_t i, std::uint32_t j, float now);
+    void advance(BodyStore& s, std::uint32_t i, float to);
+    void resolve(BodyStore& s, const Event& e);
+
+    IntegrateParams params_;
+    float restitutionBall_ = 1.f;
+    UniformGrid grid_;
+
+    // per body
+    std::vector<float> mx_, my_;        // swept bound centers
+    std::vector<float> reach_;          // swept bound radii
+    std::vector<float> time_;           // how far into the step the body is
+    std::vector<std::uint32_t> version_;    // bumped whenever its velocity changes
+    std::vector<std::uint32_t> impacts_;
+
+    // candidate pairs, as adjacency lists (CSR)
+    std::vector<std::uint32_t> pairA_, pairB_;
+    std::vector<std::uint32_t> adjStart_, adj_, cursor_;
+
+    std::vector<Event> heap_;
+    std::vector<Contact> hits_;
+};
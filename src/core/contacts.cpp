@@ -0,0 +1,448 @@
+#include "contacts.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+// Below these sizes the fork/join costs more than the work. Results do not
+// depend on which path runs.
+const std::size_t kParallelBodies   = 4096;
+const std::size_t kParallelContacts = 2048;
+
+// 64 colors fit in a mask; contacts that need more go to a last, serial bucket.
+const int kMaskColors = ContactSolver::kOverflow;
+const std::uint8_t kSkipped = 0xff;
+
+// Iterative solver: kSlop units of overlap are left alone so resting
+// contacts stay in contact (and warm starting finds them again), and
+// kCorrection of the rest is removed per step.
+const float kSlop = 0.5f;
+const float kCorrection = 0.8f;
+
+void applyContact(BodyStore& s, const Contact& c, float e) {
+    const std::uint32_t i = c.a;
+    const std::uint32_t j = c.b;
+    const float mi = s.invMass[i];
+    const float mj = s.invMass[j];
+    const float share = 1.f / (mi + mj);
+
+    float velAlongNormal = (s.vx[j] - s.vx[i]) * c.nx + (s.vy[j] - s.vy[i]) * c.ny;
+
+    if (velAlongNormal < 0) {
+        float jImpulse = -(1 + e) * velAlongNormal * share;
+        s.vx[i] -= jImpulse * c.nx * mi;
+        s.vy[i] -= jImpulse * c.ny * mi;
+        s.vx[j] += jImpulse * c.nx * mj;
+        s.vy[j] += jImpulse * c.ny * mj;
+    }
+
+    // Positional correction to avoid overlap; the lighter body moves more
+    float correction = c.penetration * share;
+    s.x[i] -= correction * c.nx * mi;
+    s.y[i] -= correction * c.ny * mi;
+    s.x[j] += correction * c.nx * mj;
+    s.y[j] += correction * c.ny * mj;
+}
+
+// A row's impulse, scaled by each side's inverse mass.
+template <class R>
+void applyImpulse(BodyStore& s, const R& r, float p) {
+    s.vx[r.a] -= p * r.nx * r.massA;
+    s.vy[r.a] -= p * r.ny * r.massA;
+    s.vx[r.b] += p * r.nx * r.massB;
+    s.vy[r.b] += p * r.ny * r.massB;
+}
+
+std::uint32_t pairHash(std::uint32_t idA, std::uint32_t idB) {
+    std::uint64_t key = (std::uint64_t(idA) << 32) | idB;
+    return static_cast<std::uint32_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+} // namespace
+
+void Narrowphase::find(const BodyStore& s, const UniformGrid& grid, ThreadPool& pool,
+                       std::vector<Contact>& out, bool skipSleeping) {
+    out.clear();
+    pairTests_ = 0;
+
+    const int rows = grid.rowCount();
+    if (rows == 0) return;
+
+    // a few strips per thread so one crowded strip doesn't hold up the rest
+    const bool parallel = pool.size() > 1 && s.size() >= kParallelBodies;
+    const int strips = parallel ? std::min(rows, pool.size() * 4) : 1;
+    if (stripTests_.size() < static_cast<std::size_t>(strips)) {
+        stripTests_.resize(strips);
+    }
+    if (parallel && strips_.size() < static_cast<std::size_t>(strips)) {
+        strips_.resize(strips);
+    }
+
+    const float* x = s.x.data();
+    const float* y = s.y.data();
+    const float* r = s.radius.data();
+    const std::uint8_t* flags = s.flags.data();
+    const std::uint8_t sleeping = skipSleeping ? BodyAsleep : 0;
+    const float wrapW = grid.wrapWidth();
+    const float wrapH = grid.wrapHeight();
+
+    // a single strip writes straight into out
+    auto scanStrip = [&](int k) {
+        std::vector<Contact>& buf = parallel ? strips_[k] : out;
+        buf.clear();
+        std::uint64_t tests = 0;
+
+        int rowBegin = static_cast<int>(static_cast<long long>(rows) * k / strips);
+        int rowEnd   = static_cast<int>(static_cast<long long>(rows) * (k + 1) / strips);
+
+        grid.forEachPairInRows(rowBegin, rowEnd, [&](std::uint32_t i, std::uint32_t j) {
+            if (flags[i] & flags[j] & sleeping) return;
+            tests++;
+            float dx = x[j] - x[i];
+            float dy = y[j] - y[i];
+            if (wrapW > 0.f) {
+                dx = wrapDelta(dx, wrapW);
+                dy = wrapDelta(dy, wrapH);
+            }
+            float minDist = r[i] + r[j];
+            float d2 = dx * dx + dy * dy;
+            if (d2 >= minDist * minDist) return;
+
+            float dist = std::sqrt(d2);
+            if (!(dist > 0 && dist < minDist)) return;
+
+            buf.push_back({ i, j, dx / dist, dy / dist, minDist - dist });
+        });
+        stripTests_[k] = tests;
+    };
+
+    if (parallel) {
+        std::atomic<int> next(0);
+        pool.parallelFor(static_cast<std::size_t>(pool.size()), [&](std::size_t, std::size_t) {
+            for (int k = next++; k < strips; k = next++) {
+                scanStrip(k);
+            }
+        });
+        for (int k = 0; k < strips; k++) {
+            out.insert(out.end(), strips_[k].begin(), strips_[k].end());
+        }
+    } else {
+        scanStrip(0);
+    }
+
+    for (int k = 0; k < strips; k++) {
+        pairTests_ += stripTests_[k];
+    }
+}
+
+template <class F>
+void ContactSolver::forEachColored(ThreadPool& pool, F&& f) {
+    for (int color = 0; color <= kMaskColors; color++) {
+        forEachInColor(pool, color, f);
+    }
+}
+
+template <class F>
+void ContactSolver::forEachInColor(ThreadPool& pool, int color, F& f) {
+    const std::uint32_t begin = colorStart_[color];
+    const std::uint32_t end   = colorStart_[color + 1];
+    const std::size_t count = end - begin;
+    if (count == 0) return;
+
+    auto applyRange = [&](std::size_t from, std::size_t to) {
+        for (std::size_t k = begin + from; k < begin + to; k++) {
+            f(static_cast<std::uint32_t>(k));
+        }
+    };
+
+    // the overflow bucket may share bodies, so it always runs in order
+    if (color < kMaskColors && pool.size() > 1 && count >= kParallelContacts) {
+        pool.parallelFor(count, applyRange);
+    } else {
+        applyRange(0, count);
+    }
+}
+
+void ContactSolver::solve(BodyStore& s, const std::vector<Contact>& contacts,
+                          const std::vector<char>& alive, const SolverParams& params, ThreadPool& pool) {
+    if (contacts.empty()) {
+        cache_.clear();
+        return;
+    }
+
+    used_.assign(s.size(), 0);
+    assignColors(contacts, alive);
+
+    if (params.iterations > 0) {
+        solveIterative(s, contacts, alive, params, pool);
+        return;
+    }
+
+    forEachColored(pool, [&](std::uint32_t k) {
+        applyContact(s, contacts[order_[k]], params.restitution);
+    });
+    cache_.clear();
+}
+
+void ContactSolver::colorShare(const std::vector<Contact>& contacts, const std::vector<char>& alive,
+                               std::vector<std::uint64_t>& used) {
+    used_.swap(used);
+    assignColors(contacts, alive);
+    used_.swap(used);
+}
+
+void ContactSolver::applyColor(BodyStore& s, const std::vector<Contact>& contacts, int color,
+                               float restitution, ThreadPool& pool) {
+    auto apply = [&](std::uint32_t k) {
+        applyContact(s, contacts[order_[k]], restitution);
+    };
+    forEachInColor(pool, color, apply);
+}
+
+// ---- greedy coloring, in contact order ----
+void ContactSolver::assignColors(const std::vector<Contact>& contacts, const std::vector<char>& alive) {
+    const std::size_t n = contacts.size();
+
+    colorOf_.reserve(contacts.capacity());
+    order_.reserve(contacts.capacity());
+    colorOf_.resize(n);
+    colorStart_.assign(kMaskColors + 2, 0);
+
+    for (std::size_t k = 0; k < n; k++) {
+        const Contact& c = contacts[k];
+        if (!alive[c.a] || !alive[c.b]) {
+            colorOf_[k] = kSkipped;
+            continue;
+        }
+
+        std::uint64_t taken = used_[c.a] | used_[c.b];
+        int color = kMaskColors;
+        if (~taken) {
+            color = __builtin_ctzll(~taken);
+            used_[c.a] |= std::uint64_t(1) << color;
+            used_[c.b] |= std::uint64_t(1) << color;
+        }
+        colorOf_[k] = static_cast<std::uint8_t>(color);
+        colorStart_[color + 1]++;
+    }
+
+    for (int c = 1; c < kMaskColors + 2; c++) {
+        colorStart_[c] += colorStart_[c - 1];
+    }
+
+    // stable bucket by color
+    order_.resize(colorStart_.back());
+    std::array<std::uint32_t, kMaskColors + 1> cursor;
+    std::copy(colorStart_.begin(), colorStart_.end() - 1, cursor.begin());
+    for (std::size_t k = 0; k < n; k++) {
+        if (colorOf_[k] != kSkipped) {
+            order_[cursor[colorOf_[k]]++] = static_cast<std::uint32_t>(k);
+        }
+    }
+}
+
+void ContactSolver::solveIterative(BodyStore& s, const std::vector<Contact>& contacts,
+                                   const std::vector<char>& alive, const SolverParams& params,
+                                   ThreadPool& pool) {
+    rows_.reserve(contacts.capacity());
+    rows_.resize(order_.size());
+
+    const float e = params.restitution;
+    auto normalSpeed = [&](const Row& r) {
+        return (s.vx[r.b] - s.vx[r.a]) * r.nx + (s.vy[r.b] - s.vy[r.a]) * r.ny;
+    };
+
+    // rows in color order, so the passes below stream through them; bounce
+    // targets come from the velocities before any impulse
+    forEachColored(pool, [&](std::uint32_t k) {
+        const Contact& c = contacts[order_[k]];
+        Row& r = rows_[k];
+        r.a = c.a;
+        r.b = c.b;
+        r.nx = c.nx;
+        r.ny = c.ny;
+        r.massA = s.asleep(c.a) ? 0.f : s.invMass[c.a];
+        r.massB = s.asleep(c.b) ? 0.f : s.invMass[c.b];
+        r.share = r.massA + r.massB > 0.f ? 1.f / (r.massA + r.massB) : 0.f;
+        float vn = normalSpeed(r);
+        r.bounce = vn < -params.restingSpeed ? -e * vn : 0.f;
+
+        // last step's impulse, if the pair was already touching
+        r.impulse = params.warmStart ? cachedImpulse(s.id[c.a], s.id[c.b]) : 0.f;
+        r.friction = 0.f;
+    });
+
+    if (params.warmStart) {
+        forEachColored(pool, [&](std::uint32_t k) {
+            const Row& r = rows_[k];
+            if (r.impulse > 0.f) applyImpulse(s, r, r.impulse);
+        });
+    }
+
+    findWallRows(s, alive, params);
+    if (params.warmStart) {
+        for (WallRow& w : wallRows_) {
+            s.vx[w.body] += w.impulseX * w.sx;
+            s.vy[w.body] += w.impulseY * w.sy;
+        }
+    }
+
+    for (int it = 0; it < params.iterations; it++) {
+        forEachColored(pool, [&](std::uint32_t k) {
+            Row& r = rows_[k];
+            float total = std::max(r.impulse + (r.bounce - normalSpeed(r)) * r.share, 0.f);
+            float delta = total - r.impulse;
+            r.impulse = total;
+            applyImpulse(s, r, delta);
+
+            if (params.friction > 0.f) {
+                float vt = (s.vx[r.b] - s.vx[r.a]) * -r.ny + (s.vy[r.b] - s.vy[r.a]) * r.nx;
+                float limit = params.friction * r.impulse;
+                float ft = std::min(std::max(r.friction - vt * r.share, -limit), limit);
+                float dt = ft - r.friction;
+                r.friction = ft;
+                s.vx[r.a] -= dt * -r.ny * r.massA;
+                s.vy[r.a] -= dt * r.nx * r.massA;
+                s.vx[r.b] += dt * -r.ny * r.massB;
+                s.vy[r.b] += dt * r.nx * r.massB;
+            }
+        });
+        solveWalls(s, params.friction, pool);
+    }
+
+    // overlap, measured again now that earlier colors have moved bodies;
+    // whatever that pushes into a wall is put back against it
+    forEachColored(pool, [&](std::uint32_t k) {
+        const Row& r = rows_[k];
+        float dx = s.x[r.b] - s.x[r.a];
+        float dy = s.y[r.b] - s.y[r.a];
+        if (params.wrapWidth > 0.f) {
+            dx = wrapDelta(dx, params.wrapWidth);
+            dy = wrapDelta(dy, params.wrapHeight);
+        }
+        float minDist = s.radius[r.a] + s.radius[r.b];
+        float d2 = dx * dx + dy * dy;
+        if (d2 >= minDist * minDist) return;
+
+        float dist = std::sqrt(d2);
+        if (!(dist > 0)) return;
+
+        float correction = r.share * kCorrection * std::max(minDist - dist - kSlop, 0.f) / dist;
+        s.x[r.a] -= correction * dx * r.massA;
+        s.y[r.a] -= correction * dy * r.massA;
+        s.x[r.b] += correction * dx * r.massB;
+        s.y[r.b] += correction * dy * r.massB;
+    });
+    for (const WallRow& w : wallRows_) {
+        const float r = s.radius[w.body];
+        s.x[w.body] = std::min(std::max(s.x[w.body], r), params.width - r);
+        s.y[w.body] = std::min(std::max(s.y[w.body], r), params.height - r);
+    }
+
+    nextCache_.clear();
+    for (const Row& r : rows_) {
+        if (!(r.impulse > 0.f)) continue;
+        CachedImpulse entry = { s.id[r.a], s.id[r.b], r.impulse };
+        if (entry.idA > entry.idB) std::swap(entry.idA, entry.idB);
+        nextCache_.push_back(entry);
+    }
+    for (const WallRow& w : wallRows_) {
+        const std::uint32_t id = s.id[w.body];
+        if (w.impulseX > 0.f) nextCache_.push_back({ id, w.sx > 0.f ? kWallLeft : kWallRight, w.impulseX });
+        if (w.impulseY > 0.f) nextCache_.push_back({ id, w.sy > 0.f ? kWallTop : kWallBottom, w.impulseY });
+    }
+    cache_.swap(nextCache_);
+    indexCache();
+}
+
+// Bodies within kSlop of a wall. The integration kernel already bounced
+// anything that hit one, so these rows only stop other contacts from pushing
+// bodies into the walls.
+void ContactSolver::findWallRows(const BodyStore& s, const std::vector<char>& alive,
+                                 const SolverParams& params) {
+    wallRows_.reserve(s.size());
+    wallRows_.clear();
+    if (params.width <= 0.f || params.height <= 0.f) return;
+
+    for (std::uint32_t i = 0; i < s.size(); i++) {
+        if (!alive[i] || s.asleep(i)) continue;
+        const float r = s.radius[i] + kSlop;
+
+        WallRow w = { i, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+        if (s.x[i] < r)                     w.sx = 1.f;
+        else if (s.x[i] + r > params.width) w.sx = -1.f;
+        if (s.y[i] < r)                      w.sy = 1.f;
+        else if (s.y[i] + r > params.height) w.sy = -1.f;
+        if (w.sx == 0.f && w.sy == 0.f) continue;
+
+        if (params.warmStart) {
+            if (w.sx != 0.f) w.impulseX = cachedImpulse(s.id[i], w.sx > 0.f ? kWallLeft : kWallRight);
+            if (w.sy != 0.f) w.impulseY = cachedImpulse(s.id[i], w.sy > 0.f ? kWallTop : kWallBottom);
+        }
+        wallRows_.push_back(w);
+    }
+}
+
+// The wall side has infinite mass. Wall impulses are kept per unit of the
+// body's own mass, so the effective mass is 1.
+void ContactSolver::solveWalls(BodyStore& s, float friction, ThreadPool& pool) {
+    // one axis: push along the wall normal, then rub along the wall
+    auto wall = [friction](float& vn, float& vt, float side, float& impulse, float& rub) {
+        float total = std::max(impulse - vn * side, 0.f);
+        vn += (total - impulse) * side;
+        impulse = total;
+
+        float limit = friction * impulse;
+        float f = std::min(std::max(rub - vt, -limit), limit);
+        vt += f - rub;
+        rub = f;
+    };
+
+    auto solveRange = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; k++) {
+            WallRow& w = wallRows_[k];
+            if (w.sx != 0.f) wall(s.vx[w.body], s.vy[w.body], w.sx, w.impulseX, w.frictionX);
+            if (w.sy != 0.f) wall(s.vy[w.body], s.vx[w.body], w.sy, w.impulseY, w.frictionY);
+        }
+    };
+
+    if (pool.size() > 1 && wallRows_.size() >= kParallelContacts) {
+        pool.parallelFor(wallRows_.size(), solveRange);
+    } else {
+        solveRange(0, wallRows_.size());
+    }
+}
+
+void ContactSolver::restoreCache(const std::vector<CachedImpulse>& cache) {
+    cache_ = cache;
+    indexCache();
+}
+
+// Rebuilds the hash table over cache_, at most half full.
+void ContactSolver::indexCache() {
+    std::size_t size = 16;
+    while (size < 2 * cache_.size()) size *= 2;
+    cacheSlots_.assign(size, 0);
+
+    const std::uint32_t mask = static_cast<std::uint32_t>(size - 1);
+    for (std::size_t k = 0; k < cache_.size(); k++) {
+        std::uint32_t slot = pairHash(cache_[k].idA, cache_[k].idB) & mask;
+        while (cacheSlots_[slot] != 0) slot = (slot + 1) & mask;
+        cacheSlots_[slot] = static_cast<std::uint32_t>(k + 1);
+    }
+}
+
+float ContactSolver::cachedImpulse(std::uint32_t idA, std::uint32_t idB) const {
+    if (cache_.empty()) return 0.f;
+    if (idA > idB) std::swap(idA, idB);
+
+    const std::uint32_t mask = static_cast<std::uint32_t>(cacheSlots_.size() - 1);
+    for (std::uint32_t slot = pairHash(idA, idB) & mask; cacheSlots_[slot] != 0; slot = (slot + 1) & mask) {
+        const CachedImpulse& c = cache_[cacheSlots_[slot] - 1];
+        if (c.idA == idA && c.idB == idB) return c.impulse;
+    }
+    return 0.f;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "body_store.hpp"
+#include "thread_pool.hpp"
+#include "uniform_grid.hpp"
+
+// Contacts are collected first and resolved afterwards, so the pair search
+// can run on many threads and the solver never races on a body.
+
+struct Contact {
+    std::uint32_t a, b;     // body indices, a < b
+    float nx, ny;           // unit normal from a to b
+    float penetration;      // minDist - dist, > 0 (0 for CCD impacts)
+};
+
+// The shortest way from one center to another along an axis of a periodic
+// world: across the edge when that is nearer.
+inline float wrapDelta(float d, float period) {
+    if (d > period * 0.5f)  return d - period;
+    if (d < -period * 0.5f) return d + period;
+    return d;
+}
+
+// Finds every overlapping pair. The grid is cut into row strips that threads
+// pick up one at a time; each strip fills its own buffer and the buffers are
+// joined in strip order, so the output is identical for any thread count.
+// With skipSleeping, pairs of two sleeping bodies are left out. On a
+// periodic grid, distances are measured across the edges too.
+class Narrowphase {
+public:
+    void find(const BodyStore& s, const UniformGrid& grid, ThreadPool& pool,
+              std::vector<Contact>& out, bool skipSleeping = false);
+
+    // Candidate pairs tested by the last find().
+    std::uint64_t pairTests() const { return pairTests_; }
+
+private:
+    std::vector<std::vector<Contact>> strips_;
+    std::vector<std::uint64_t> stripTests_;
+    std::uint64_t pairTests_ = 0;
+};
+
+const std::uint32_t kWallLeft   = 0xffffffffu;
+const std::uint32_t kWallRight  = 0xfffffffeu;
+const std::uint32_t kWallTop    = 0xfffffffdu;
+const std::uint32_t kWallBottom = 0xfffffffcu;
+
+struct SolverParams {
+    float restitution = 1.f;
+    int   iterations = 0;       // 0 = single pass, see ContactSolver
+    bool  warmStart = true;     // iterative only
+    float restingSpeed = 0.f;   // iterative only: slower approaches don't bounce
+    float friction = 0.f;       // iterative only: tangential impulse limit, times the normal one
+    float width = 0.f;          // iterative only: walls at 0, width and 0, height
+    float height = 0.f;
+    float wrapWidth = 0.f;      // iterative only: periodic world (no walls), distances wrap
+    float wrapHeight = 0.f;
+};
+
+// Last step's accumulated impulse for a pair, keyed by body ids (idA < idB)
+// since indices change whenever bodies are removed. Wall impulses use one of
+// the kWall* ids as idB.
+struct CachedImpulse {
+    std::uint32_t idA, idB;
+    float impulse;
+};
+
+// Resolves contacts with graph coloring: contacts are greedily given the
+// lowest color not yet used by either body, so all contacts of one color
+// touch disjoint bodies and can be applied in parallel. Colors are applied
+// in order. Coloring is sequential and depends only on contact order, which
+// keeps results bit-identical whatever the thread count.
+//
+// With iterations == 0 every contact gets one impulse and pushes both bodies
+// apart by half the overlap, the original single pass. Otherwise contacts
+// are solved as sequential impulses: each pass over the colors corrects the
+// impulse of every contact against the current velocities, keeping the
+// running total per contact non-negative, so a pile's contacts converge on
+// forces that hold it up together instead of fighting each other.
+// Approaches slower than restingSpeed don't bounce (a resting body gains
+// gravity * dt every step and would otherwise hop forever), and the overlap
+// is removed afterwards in one partial pass that doesn't feed back into the
+// velocities. With warm starting, each contact starts from the impulse its
+// pair ended the last step with, so resting piles need only a few iterations.
+// Bodies touching a wall get a wall row too, so a pile's weight ends up on
+// the floor instead of sinking into the body that touches it. Sleeping bodies
+// don't move: the awake side of a contact takes all of its impulse, so
+// whatever lands slowly on a sleeping pile rests on it like on the floor.
+class ContactSolver {
+public:
+    // Colors are 0 .. kOverflow; the last holds contacts that found no free
+    // color and is applied strictly in order.
+    static const int kOverflow = 64;
+
+    // Contacts touching a body with alive[i] == 0 are skipped.
+    void solve(BodyStore& s, const std::vector<Contact>& contacts,
+               const std::vector<char>& alive, const SolverParams& params, ThreadPool& pool);
+
+    // The single pass for one share of a bigger world's contacts (see
+    // slab_world.hpp), a color at a time. colorShare() colors the contacts
+    // as solve() would if `used` holds, per body, the colors that contacts
+    // earlier in the world's order already took; it adds its own to used.
+    // applyColor() then applies one color's contacts.
+    void colorShare(const std::vector<Contact>& contacts, const std::vector<char>& alive,
+                    std::vector<std::uint64_t>& used);
+    void applyColor(BodyStore& s, const std::vector<Contact>& contacts, int color,
+                    float restitution, ThreadPool& pool);
+
+    // Indices into contacts of one color, after solve() or colorShare().
+    const std::uint32_t* colorBegin(int color) const { return order_.data() + colorStart_[color]; }
+    const std::uint32_t* colorEnd(int color) const { return order_.data() + colorStart_[color + 1]; }
+
+    // Impulses kept for warm starting, in the last solve's color order.
+    const std::vector<CachedImpulse>& cache() const { return cache_; }
+    void restoreCache(const std::vector<CachedImpulse>& cache);
+
+private:
+    // Colors in contact order, starting from the colors in used_.
+    void assignColors(const std::vector<Contact>& contacts, const std::vector<char>& alive);
+
+    // Runs f(k) for k = 0 .. order_.size(), color by color; contacts of a
+    // color may run in parallel.
+    template <class F>
+    void forEachColored(ThreadPool& pool, F&& f);
+    template <class F>
+    void forEachInColor(ThreadPool& pool, int color, F& f);
+
+    void solveIterative(BodyStore& s, const std::vector<Contact>& contacts,
+                        const std::vector<char>& alive, const SolverParams& params, ThreadPool& pool);
+    void findWallRows(const BodyStore& s, const std::vector<char>& alive, const SolverParams& params);
+    void solveWalls(BodyStore& s, float friction, ThreadPool& pool);
+
+    void indexCache();
+    float cachedImpulse(std::uint32_t idA, std::uint32_t idB) const;
+
+    std::vector<std::uint64_t> used_;       // per body: colors it already has
+    std::vector<std::uint8_t>  colorOf_;    // per contact
+    std::vector<std::uint32_t> colorStart_;
+    std::vector<std::uint32_t> order_;      // contact indices grouped by color
+
+    // iterative solver, one row per colored contact in order_ order
+    struct Row {
+        std::uint32_t a, b;
+        float nx, ny;
+        float massA, massB; // inverse masses, 0 for a sleeping body
+        float share;        // effective mass, 1 / (massA + massB)
+        float bounce;       // target separating speed
+        float impulse;      // accumulated this step
+        float friction;     // accumulated tangential impulse
+    };
+    std::vector<Row> rows_;
+
+    // one per body touching a wall; each axis pushes along sx / sy (+1, -1 or 0)
+    struct WallRow {
+        std::uint32_t body;
+        float sx, sy;
+        float impulseX, impulseY;
+        float frictionX, frictionY;     // along the wall, for the x and y walls
+    };
+    std::vector<WallRow> wallRows_;
+
+    std::vector<CachedImpulse> cache_, nextCache_;
+    std::vector<std::uint32_t> cacheSlots_;    // open addressing, cache_ index + 1, 0 = empty
+};
@@ -0,0 +1,32 @@
+#include "fixed_step.hpp"
+
+FixedTimestep::FixedTimestep(const StepConfig& config)
+    : config_(config) {
+    if (config_.substeps < 1) config_.substeps = 1;
+    if (config_.maxStepsPerFrame < 1) config_.maxStepsPerFrame = 1;
+}
+
+int FixedTimestep::advance(World& world, float frameDt) {
+    accumulator_ += frameDt;
+
+    // After a stall, run at most maxStepsPerFrame steps and forget the rest
+    // instead of spiralling: every catch-up frame would be slower still.
+    const float maxBacklog = config_.stepDt * config_.maxStepsPerFrame;
+    if (accumulator_ > maxBacklog) {
+        dropped_ += accumulator_ - maxBacklog;
+        accumulator_ = maxBacklog;
+    }
+
+    const float subDt = config_.stepDt / config_.substeps;
+    int steps = 0;
+
+    while (accumulator_ >= config_.stepDt) {
+        world.savePrevious();
+        for (int s = 0; s < config_.substeps; s++) {
+            world.step(subDt);
+        }
+        accumulator_ -= config_.stepDt;
+        steps++;
+    }
+    return steps;
+}
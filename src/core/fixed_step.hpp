@@ -0,0 +1,35 @@
+#pragma once
+
+#include "world.hpp"
+
+// Fixed-timestep driver: turns variable frame times into a whole number of
+// equal physics steps, so a slow frame never produces one huge dt.
+
+struct StepConfig {
+    float stepDt = 1.f / 100.f;     // simulated seconds per fixed step
+    int   substeps = 1;             // world.step() calls per fixed step
+    int   maxStepsPerFrame = 5;     // catch-up cap; extra time is dropped
+};
+
+class FixedTimestep {
+public:
+    explicit FixedTimestep(const StepConfig& config = StepConfig());
+
+    // Adds frameDt to the accumulator and runs as many fixed steps as fit.
+    // Returns the number of fixed steps taken.
+    int advance(World& world, float frameDt);
+
+    // How far the accumulator is into the next step, in [0, 1). Render
+    // bodies at prev + (cur - prev) * alpha() to hide the step rate.
+    float alpha() const { return accumulator_ / config_.stepDt; }
+
+    // Seconds of frame time dropped so far because of the catch-up cap.
+    double droppedTime() const { return dropped_; }
+
+    const StepConfig& config() const { return config_; }
+
+private:
+    StepConfig config_;
+    float accumulator_ = 0.f;
+    double dropped_ = 0.0;
+};
@@ -0,0 +1,268 @@
+#include "json.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    if (type != Type::Object) return nullptr;
+    for (const auto& kv : object) {
+        if (kv.first == key) return &kv.second;
+    }
+    return nullptr;
+}
+
+double JsonValue::get(const std::string& key, double fallback) const {
+    const JsonValue* v = find(key);
+    return v && v->isNumber() ? v->number : fallback;
+}
+
+bool JsonValue::get(const std::string& key, bool fallback) const {
+    const JsonValue* v = find(key);
+    return v && v->type == Type::Bool ? v->boolean : fallback;
+}
+
+std::string JsonValue::get(const std::string& key, const char* fallback) const {
+    const JsonValue* v = find(key);
+    return v && v->isString() ? v->string : std::string(fallback);
+}
+
+JsonValue& JsonValue::push(const JsonValue& v) {
+    type = Type::Array;
+    array.push_back(v);
+    return array.back();
+}
+
+JsonValue& JsonValue::set(const std::string& key, const JsonValue& v) {
+    type = Type::Object;
+    for (auto& kv : object) {
+        if (kv.first == key) {
+            kv.second = v;
+            return kv.second;
+        }
+    }
+    object.emplace_back(key, v);
+    return object.back().second;
+}
+
+// ---- Parser ----
+
+namespace {
+
+struct Parser {
+    const std::string& s;
+    std::size_t pos = 0;
+    std::string error;
+
+    explicit Parser(const std::string& text) : s(text) {}
+
+    bool fail(const char* what) {
+        if (error.empty()) {
+            error = std::string(what) + " at offset " + std::to_string(pos);
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (pos < s.size()) {
+            char c = s[pos];
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                pos++;
+            } else if (c == '/' && pos + 1 < s.size() && s[pos + 1] == '/') {
+                // line comments, handy in hand-written scenario files
+                while (pos < s.size() && s[pos] != '\n') pos++;
+            } else {
+                break;
+            }
+        }
+    }
+
+    bool literal(const char* word) {
+        std::size_t n = std::char_traits<char>::length(word);
+        if (s.compare(pos, n, word) != 0) return fail("unexpected token");
+        pos += n;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (s[pos] != '"') return fail("expected string");
+        pos++;
+        while (pos < s.size() && s[pos] != '"') {
+            char c = s[pos++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= s.size()) break;
+            char e = s[pos++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if (pos + 4 > s.size()) return fail("bad \\u escape");
+                    unsigned code = static_cast<unsigned>(std::strtoul(s.substr(pos, 4).c_str(), nullptr, 16));
+                    pos += 4;
+                    // ASCII only; anything else becomes '?'
+                    out += code < 0x80 ? static_cast<char>(code) : '?';
+                    break;
+                }
+                default: out += e; break;
+            }
+        }
+        if (pos >= s.size()) return fail("unterminated string");
+        pos++;
+        return true;
+    }
+
+    bool parseValue(JsonValue& out, int depth) {
+        if (depth > 64) return fail("nesting too deep");
+        skipSpace();
+        if (pos >= s.size()) return fail("unexpected end");
+
+        char c = s[pos];
+        if (c == '{') {
+            out = JsonValue::makeObject();
+            pos++;
+            skipSpace();
+            if (pos < s.size() && s[pos] == '}') { pos++; return true; }
+            for (;;) {
+                skipSpace();
+                std::string key;
+                if (pos >= s.size() || !parseString(key)) return fail("expected key");
+                skipSpace();
+                if (pos >= s.size() || s[pos] != ':') return fail("expected ':'");
+                pos++;
+                JsonValue v;
+                if (!parseValue(v, depth + 1)) return false;
+                out.object.emplace_back(std::move(key), std::move(v));
+                skipSpace();
+                if (pos < s.size() && s[pos] == ',') { pos++; continue; }
+                if (pos < s.size() && s[pos] == '}') { pos++; return true; }
+                return fail("expected ',' or '}'");
+            }
+        }
+        if (c == '[') {
+            out = JsonValue::makeArray();
+            pos++;
+            skipSpace();
+            if (pos < s.size() && s[pos] == ']') { pos++; return true; }
+            for (;;) {
+                JsonValue v;
+                if (!parseValue(v, depth + 1)) return false;
+                out.array.push_back(std::move(v));
+                skipSpace();
+                if (pos < s.size() && s[pos] == ',') { pos++; continue; }
+                if (pos < s.size() && s[pos] == ']') { pos++; return true; }
+                return fail("expected ',' or ']'");
+            }
+        }
+        if (c == '"') {
+            out = JsonValue(std::string());
+            return parseString(out.string);
+        }
+        if (c == 't') { out = JsonValue(true);  return literal("true"); }
+        if (c == 'f') { out = JsonValue(false); return literal("false"); }
+        if (c == 'n') { out = JsonValue();      return literal("null"); }
+
+        const char* begin = s.c_str() + pos;
+        char* end = nullptr;
+        double d = std::strtod(begin, &end);
+        if (end == begin) return fail("unexpected character");
+        pos += static_cast<std::size_t>(end - begin);
+        out = JsonValue(d);
+        return true;
+    }
+};
+
+void write(std::ostringstream& os, const JsonValue& v, int indent, int level) {
+    auto newline = [&](int lvl) {
+        if (indent <= 0) return;
+        os << '\n' << std::string(static_cast<std::size_t>(indent * lvl), ' ');
+    };
+    auto writeString = [&](const std::string& str) {
+        os << '"';
+        for (char c : str) {
+            switch (c) {
+                case '"':  os << "\\\""; break;
+                case '\\': os << "\\\\"; break;
+                case '\n': os << "\\n"; break;
+                case '\t': os << "\\t"; break;
+                case '\r': os << "\\r"; break;
+                default:   os << c; break;
+            }
+        }
+        os << '"';
+    };
+
+    switch (v.type) {
+        case JsonValue::Type::Null:   os << "null"; break;
+        case JsonValue::Type::Bool:   os << (v.boolean ? "true" : "false"); break;
+        case JsonValue::Type::Number: {
+            if (!std::isfinite(v.number)) { os << "null"; break; }
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.10g", v.number);
+            os << buf;
+            break;
+        }
+        case JsonValue::Type::String: writeString(v.string); break;
+        case JsonValue::Type::Array: {
+            os << '[';
+            for (std::size_t i = 0; i < v.array.size(); i++) {
+                if (i) os << ',';
+                newline(level + 1);
+                write(os, v.array[i], indent, level + 1);
+            }
+            if (!v.array.empty()) newline(level);
+            os << ']';
+            break;
+        }
+        case JsonValue::Type::Object: {
+            os << '{';
+            for (std::size_t i = 0; i < v.object.size(); i++) {
+                if (i) os << ',';
+                newline(level + 1);
+                writeString(v.object[i].first);
+                os << (indent > 0 ? ": " : ":");
+                write(os, v.object[i].second, indent, level + 1);
+            }
+            if (!v.object.empty()) newline(level);
+            os << '}';
+            break;
+        }
+    }
+}
+
+} // namespace
+
+bool parseJson(const std::string& text, JsonValue& out, std::string* error) {
+    Parser p(text);
+    bool ok = p.parseValue(out, 0);
+    if (ok) {
+        p.skipSpace();
+        if (p.pos != text.size()) ok = p.fail("trailing characters");
+    }
+    if (!ok && error) *error = p.error;
+    return ok;
+}
+
+bool loadJsonFile(const std::string& path, JsonValue& out, std::string* error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return parseJson(ss.str(), out, error);
+}
+
+std::string toJson(const JsonValue& v, int indent) {
+    std::ostringstream os;
+    write(os, v, indent, 0);
+    return os.str();
+}
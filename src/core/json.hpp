@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Just enough JSON for benchmark results and scenario files: a value tree,
+// a parser and a pretty printer. Objects keep their key order.
+
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    JsonValue() = default;
+    JsonValue(bool b) : type(Type::Bool), boolean(b) {}
+    JsonValue(double d) : type(Type::Number), number(d) {}
+    JsonValue(int i) : type(Type::Number), number(i) {}
+    JsonValue(const char* s) : type(Type::String), string(s) {}
+    JsonValue(const std::string& s) : type(Type::String), string(s) {}
+
+    static JsonValue makeArray()  { JsonValue v; v.type = Type::Array;  return v; }
+    static JsonValue makeObject() { JsonValue v; v.type = Type::Object; return v; }
+
+    bool isNull()   const { return type == Type::Null; }
+    bool isNumber() const { return type == Type::Number; }
+    bool isString() const { return type == Type::String; }
+    bool isArray()  const { return type == Type::Array; }
+    bool isObject() const { return type == Type::Object; }
+
+    // Object lookup; nullptr if this isn't an object or has no such key.
+    const JsonValue* find(const std::string& key) const;
+
+    // Typed lookups with a fallback for missing or mistyped keys.
+    double      get(const std::string& key, double fallback) const;
+    bool        get(const std::string& key, bool fallback) const;
+    std::string get(const std::string& key, const char* fallback) const;
+
+    // Appends to an array / sets a key on an object (replacing an old value).
+    JsonValue& push(const JsonValue& v);
+    JsonValue& set(const std::string& key, const JsonValue& v);
+};
+
+// Returns false and fills *error (if given) on malformed input.
+bool parseJson(const std::string& text, JsonValue& out, std::string* error = nullptr);
+bool loadJsonFile(const std::string& path, JsonValue& out, std::string* error = nullptr);
+
+std::string toJson(const JsonValue& v, int indent = 2);
@@ -0,0 +1,384 @@
+#include "kernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    #define PHYS_X86 1
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+    #define PHYS_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#include <cmath>
+#include <cstring>
+
+#include "policies.hpp"
+
+namespace {
+
+// Every loop below is a template over an IntegratePolicy (policies.hpp);
+// integrateBodies() picks the instantiation.
+//
+// The scalar path is the reference; it also finishes the tail the SIMD
+// loops leave behind. Wall tests are written as x + r > W (not x > W - r)
+// so every path rounds the same way.
+template <class P>
+void integrateScalar(BodyStore& s, const IntegrateParams& p, std::size_t begin, std::size_t end) {
+    float* x  = s.x.data();
+    float* y  = s.y.data();
+    float* vx = s.vx.data();
+    float* vy = s.vy.data();
+    float* age = s.age.data();
+    const float* r = s.radius.data();
+    const std::uint8_t* flags = s.flags.data();
+
+    const float dt = p.dt;
+    const float gdt = p.gravity * p.dt;
+    const float W = p.width;
+    const float H = p.height;
+    const float e = p.restitution;
+    const float rest = p.restingSpeed;
+
+    auto bounce = [&](float v) {
+        if constexpr (P::Walls::resting) {
+            if (std::fabs(v) < rest) return 0.f;
+        }
+        return -v * e;
+    };
+
+    for (std::size_t i = begin; i < end; i++) {
+        age[i] += dt;
+        if constexpr (P::Gravity::enabled) {
+            if (!P::Sleep::enabled || !(flags[i] & BodyAsleep)) vy[i] += gdt;
+        }
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+
+        if constexpr (P::Walls::wrap) {
+            if (x[i] < 0.f)      x[i] += W;
+            else if (x[i] >= W)  x[i] -= W;
+            if (y[i] < 0.f)      y[i] += H;
+            else if (y[i] >= H)  y[i] -= H;
+            continue;
+        }
+
+        if (x[i] < r[i]) {
+            x[i] = r[i];
+            vx[i] = bounce(vx[i]);
+        }
+        else if (x[i] + r[i] > W) {
+            x[i] = W - r[i];
+            vx[i] = bounce(vx[i]);
+        }
+
+        if (y[i] < r[i]) {
+            y[i] = r[i];
+            vy[i] = bounce(vy[i]);
+        }
+        else if (y[i] + r[i] > H) {
+            y[i] = H - r[i];
+            vy[i] = bounce(vy[i]);
+        }
+    }
+}
+
+#if PHYS_X86
+
+template <class P>
+std::size_t integrateSse2(BodyStore& s, const IntegrateParams& p) {
+    const std::size_t n = s.size() & ~std::size_t(3);
+
+    const __m128 dt  = _mm_set1_ps(p.dt);
+    const __m128 gdt = _mm_set1_ps(p.gravity * p.dt);
+    const __m128 W   = _mm_set1_ps(p.width);
+    const __m128 H   = _mm_set1_ps(p.height);
+    const __m128 ne  = _mm_set1_ps(-p.restitution);
+    const __m128 rest = _mm_set1_ps(p.restingSpeed);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    // SSE2 has no blendv; select with and/andnot/or
+    auto select = [](__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    };
+
+    const __m128 zeroPs = _mm_setzero_ps();
+    auto axis = [&](__m128& pos, __m128& vel, __m128 r, __m128 limit) {
+        if constexpr (P::Walls::wrap) {
+            __m128 lo = _mm_cmplt_ps(pos, zeroPs);
+            __m128 hi = _mm_andnot_ps(lo, _mm_cmpge_ps(pos, limit));
+            pos = select(lo, _mm_add_ps(pos, limit), pos);
+            pos = select(hi, _mm_sub_ps(pos, limit), pos);
+            return;
+        }
+        __m128 lo = _mm_cmplt_ps(pos, r);
+        __m128 hi = _mm_andnot_ps(lo, _mm_cmpgt_ps(_mm_add_ps(pos, r), limit));
+        pos = select(lo, r, pos);
+        pos = select(hi, _mm_sub_ps(limit, r), pos);
+        __m128 bounced = _mm_mul_ps(vel, ne);
+        if constexpr (P::Walls::resting) {
+            bounced = _mm_andnot_ps(_mm_cmplt_ps(_mm_and_ps(vel, absMask), rest), bounced);
+        }
+        vel = select(_mm_or_ps(lo, hi), bounced, vel);
+    };
+
+    // gravity with the lanes of sleeping bodies zeroed
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i asleepBit = _mm_set1_epi32(BodyAsleep);
+    auto gravity = [&](std::size_t i) {
+        if constexpr (!P::Sleep::enabled) return gdt;
+        std::int32_t bytes;
+        std::memcpy(&bytes, &s.flags[i], sizeof(bytes));
+        __m128i f = _mm_cvtsi32_si128(bytes);
+        f = _mm_unpacklo_epi16(_mm_unpacklo_epi8(f, zero), zero);
+        __m128i awake = _mm_cmpeq_epi32(_mm_and_si128(f, asleepBit), zero);
+        return _mm_and_ps(_mm_castsi128_ps(awake), gdt);
+    };
+
+    for (std::size_t i = 0; i < n; i += 4) {
+        __m128 x  = _mm_load_ps(&s.x[i]);
+        __m128 y  = _mm_load_ps(&s.y[i]);
+        __m128 vx = _mm_load_ps(&s.vx[i]);
+        __m128 vy = _mm_load_ps(&s.vy[i]);
+        __m128 r  = _mm_load_ps(&s.radius[i]);
+
+        _mm_store_ps(&s.age[i], _mm_add_ps(_mm_load_ps(&s.age[i]), dt));
+
+        if constexpr (P::Gravity::enabled) vy = _mm_add_ps(vy, gravity(i));
+        x = _mm_add_ps(x, _mm_mul_ps(vx, dt));
+        y = _mm_add_ps(y, _mm_mul_ps(vy, dt));
+
+        axis(x, vx, r, W);
+        axis(y, vy, r, H);
+
+        _mm_store_ps(&s.x[i], x);
+        _mm_store_ps(&s.y[i], y);
+        _mm_store_ps(&s.vx[i], vx);
+        _mm_store_ps(&s.vy[i], vy);
+    }
+    return n;
+}
+
+template <class P>
+__attribute__((target("avx2")))
+std::size_t integrateAvx2(BodyStore& s, const IntegrateParams& p) {
+    const std::size_t n = s.size() & ~std::size_t(7);
+
+    const __m256 dt  = _mm256_set1_ps(p.dt);
+    const __m256 gdt = _mm256_set1_ps(p.gravity * p.dt);
+    const __m256 W   = _mm256_set1_ps(p.width);
+    const __m256 H   = _mm256_set1_ps(p.height);
+    const __m256 ne  = _mm256_set1_ps(-p.restitution);
+    const __m256 rest = _mm256_set1_ps(p.restingSpeed);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i asleepBit = _mm256_set1_epi32(BodyAsleep);
+
+    for (std::size_t i = 0; i < n; i += 8) {
+        __m256 x  = _mm256_load_ps(&s.x[i]);
+        __m256 y  = _mm256_load_ps(&s.y[i]);
+        __m256 vx = _mm256_load_ps(&s.vx[i]);
+        __m256 vy = _mm256_load_ps(&s.vy[i]);
+        __m256 r  = _mm256_load_ps(&s.radius[i]);
+
+        _mm256_store_ps(&s.age[i], _mm256_add_ps(_mm256_load_ps(&s.age[i]), dt));
+
+        // (no lambda here: it wouldn't inherit the avx2 target)
+        if constexpr (P::Gravity::enabled) {
+            __m256 g = gdt;
+            if constexpr (P::Sleep::enabled) {
+                __m256i f = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&s.flags[i])));
+                __m256i awake = _mm256_cmpeq_epi32(_mm256_and_si256(f, asleepBit), zero);
+                g = _mm256_and_ps(_mm256_castsi256_ps(awake), gdt);
+            }
+            vy = _mm256_add_ps(vy, g);
+        }
+        x = _mm256_add_ps(x, _mm256_mul_ps(vx, dt));
+        y = _mm256_add_ps(y, _mm256_mul_ps(vy, dt));
+
+        if constexpr (P::Walls::wrap) {
+            const __m256 zeroPs = _mm256_setzero_ps();
+            __m256 loX = _mm256_cmp_ps(x, zeroPs, _CMP_LT_OQ);
+            __m256 hiX = _mm256_andnot_ps(loX, _mm256_cmp_ps(x, W, _CMP_GE_OQ));
+            x = _mm256_blendv_ps(x, _mm256_add_ps(x, W), loX);
+            x = _mm256_blendv_ps(x, _mm256_sub_ps(x, W), hiX);
+            __m256 loY = _mm256_cmp_ps(y, zeroPs, _CMP_LT_OQ);
+            __m256 hiY = _mm256_andnot_ps(loY, _mm256_cmp_ps(y, H, _CMP_GE_OQ));
+            y = _mm256_blendv_ps(y, _mm256_add_ps(y, H), loY);
+            y = _mm256_blendv_ps(y, _mm256_sub_ps(y, H), hiY);
+
+            _mm256_store_ps(&s.x[i], x);
+            _mm256_store_ps(&s.y[i], y);
+            _mm256_store_ps(&s.vy[i], vy);
+            continue;
+        }
+
+        __m256 loX = _mm256_cmp_ps(x, r, _CMP_LT_OQ);
+        __m256 hiX = _mm256_andnot_ps(loX, _mm256_cmp_ps(_mm256_add_ps(x, r), W, _CMP_GT_OQ));
+        x  = _mm256_blendv_ps(x, r, loX);
+        x  = _mm256_blendv_ps(x, _mm256_sub_ps(W, r), hiX);
+        __m256 bouncedX = _mm256_mul_ps(vx, ne);
+        if constexpr (P::Walls::resting) {
+            bouncedX = _mm256_andnot_ps(_mm256_cmp_ps(_mm256_and_ps(vx, absMask), rest, _CMP_LT_OQ), bouncedX);
+        }
+        vx = _mm256_blendv_ps(vx, bouncedX, _mm256_or_ps(loX, hiX));
+
+        __m256 loY = _mm256_cmp_ps(y, r, _CMP_LT_OQ);
+        __m256 hiY = _mm256_andnot_ps(loY, _mm256_cmp_ps(_mm256_add_ps(y, r), H, _CMP_GT_OQ));
+        y  = _mm256_blendv_ps(y, r, loY);
+        y  = _mm256_blendv_ps(y, _mm256_sub_ps(H, r), hiY);
+        __m256 bouncedY = _mm256_mul_ps(vy, ne);
+        if constexpr (P::Walls::resting) {
+            bouncedY = _mm256_andnot_ps(_mm256_cmp_ps(_mm256_and_ps(vy, absMask), rest, _CMP_LT_OQ), bouncedY);
+        }
+        vy = _mm256_blendv_ps(vy, bouncedY, _mm256_or_ps(loY, hiY));
+
+        _mm256_store_ps(&s.x[i], x);
+        _mm256_store_ps(&s.y[i], y);
+        _mm256_store_ps(&s.vx[i], vx);
+        _mm256_store_ps(&s.vy[i], vy);
+    }
+    return n;
+}
+
+#endif // PHYS_X86
+
+#if PHYS_NEON
+
+template <class P>
+std::size_t integrateNeon(BodyStore& s, const IntegrateParams& p) {
+    const std::size_t n = s.size() & ~std::size_t(3);
+
+    const float32x4_t dt  = vdupq_n_f32(p.dt);
+    const float32x4_t gdt = vdupq_n_f32(p.gravity * p.dt);
+    const float32x4_t W   = vdupq_n_f32(p.width);
+    const float32x4_t H   = vdupq_n_f32(p.height);
+    const float32x4_t ne  = vdupq_n_f32(-p.restitution);
+    const float32x4_t rest = vdupq_n_f32(p.restingSpeed);
+
+    auto axis = [&](float32x4_t& pos, float32x4_t& vel, float32x4_t r, float32x4_t limit) {
+        if constexpr (P::Walls::wrap) {
+            uint32x4_t lo = vcltq_f32(pos, vdupq_n_f32(0.f));
+            uint32x4_t hi = vbicq_u32(vcgeq_f32(pos, limit), lo);
+            pos = vbslq_f32(lo, vaddq_f32(pos, limit), pos);
+            pos = vbslq_f32(hi, vsubq_f32(pos, limit), pos);
+            return;
+        }
+        uint32x4_t lo = vcltq_f32(pos, r);
+        uint32x4_t hi = vbicq_u32(vcgtq_f32(vaddq_f32(pos, r), limit), lo);
+        pos = vbslq_f32(lo, r, pos);
+        pos = vbslq_f32(hi, vsubq_f32(limit, r), pos);
+        float32x4_t bounced = vmulq_f32(vel, ne);
+        if constexpr (P::Walls::resting) {
+            uint32x4_t resting = vcltq_f32(vabsq_f32(vel), rest);
+            bounced = vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(bounced), resting));
+        }
+        vel = vbslq_f32(vorrq_u32(lo, hi), bounced, vel);
+    };
+
+    const uint32x4_t asleepBit = vdupq_n_u32(BodyAsleep);
+    auto gravity = [&](std::size_t i) {
+        if constexpr (!P::Sleep::enabled) return gdt;
+        std::uint32_t bytes;
+        std::memcpy(&bytes, &s.flags[i], sizeof(bytes));
+        uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bytes)));
+        uint32x4_t f = vmovl_u16(vget_low_u16(wide));
+        uint32x4_t awake = vceqq_u32(vandq_u32(f, asleepBit), vdupq_n_u32(0));
+        return vreinterpretq_f32_u32(vandq_u32(awake, vreinterpretq_u32_f32(gdt)));
+    };
+
+    for (std::size_t i = 0; i < n; i += 4) {
+        float32x4_t x  = vld1q_f32(&s.x[i]);
+        float32x4_t y  = vld1q_f32(&s.y[i]);
+        float32x4_t vx = vld1q_f32(&s.vx[i]);
+        float32x4_t vy = vld1q_f32(&s.vy[i]);
+        float32x4_t r  = vld1q_f32(&s.radius[i]);
+
+        vst1q_f32(&s.age[i], vaddq_f32(vld1q_f32(&s.age[i]), dt));
+
+        if constexpr (P::Gravity::enabled) vy = vaddq_f32(vy, gravity(i));
+        x = vaddq_f32(x, vmulq_f32(vx, dt));
+        y = vaddq_f32(y, vmulq_f32(vy, dt));
+
+        axis(x, vx, r, W);
+        axis(y, vy, r, H);
+
+        vst1q_f32(&s.x[i], x);
+        vst1q_f32(&s.y[i], y);
+        vst1q_f32(&s.vx[i], vx);
+        vst1q_f32(&s.vy[i], vy);
+    }
+    return n;
+}
+
+#endif // PHYS_NEON
+
+} // namespace
+
+SimdLevel bestSimdLevel() {
+#if PHYS_X86
+    static const SimdLevel level =
+        __builtin_cpu_supports("avx2") ? SimdLevel::Avx2 : SimdLevel::Sse2;
+    return level;
+#elif PHYS_NEON
+    return SimdLevel::Neon;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+std::vector<SimdLevel> simdLevels() {
+    std::vector<SimdLevel> levels{ SimdLevel::Scalar };
+#if PHYS_X86
+    levels.push_back(SimdLevel::Sse2);
+    if (bestSimdLevel() == SimdLevel::Avx2) levels.push_back(SimdLevel::Avx2);
+#elif PHYS_NEON
+    levels.push_back(SimdLevel::Neon);
+#endif
+    return levels;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar: return "scalar";
+        case SimdLevel::Sse2:   return "sse2";
+        case SimdLevel::Avx2:   return "avx2";
+        case SimdLevel::Neon:   return "neon";
+    }
+    return "?";
+}
+
+namespace {
+
+template <class P>
+void integrateWith(BodyStore& s, const IntegrateParams& p, SimdLevel level) {
+    std::size_t done = 0;
+
+    switch (level) {
+#if PHYS_X86
+        case SimdLevel::Avx2: done = integrateAvx2<P>(s, p); break;
+        case SimdLevel::Sse2: done = integrateSse2<P>(s, p); break;
+#endif
+#if PHYS_NEON
+        case SimdLevel::Neon: done = integrateNeon<P>(s, p); break;
+#endif
+        default: break;
+    }
+
+    integrateScalar<P>(s, p, done, s.size());
+}
+
+template <class Gravity, class Sleep>
+void pickWalls(BodyStore& s, const IntegrateParams& p, SimdLevel level) {
+    if (p.periodic)                integrateWith<IntegratePolicy<Gravity, Sleep, WrapEdges>>(s, p, level);
+    else if (p.restingSpeed > 0.f) integrateWith<IntegratePolicy<Gravity, Sleep, RestingWalls>>(s, p, level);
+    else                           integrateWith<IntegratePolicy<Gravity, Sleep, BounceWalls>>(s, p, level);
+}
+
+} // namespace
+
+void integrateBodies(BodyStore& s, const IntegrateParams& p, SimdLevel level) {
+    // without gravity, sleeping changes nothing here
+    if (p.gravity == 0.f)  pickWalls<NoGravity, AllAwake>(s, p, level);
+    else if (p.sleeping)   pickWalls<WithGravity, SkipSleeping>(s, p, level);
+    else                   pickWalls<WithGravity, AllAwake>(s, p, level);
+}
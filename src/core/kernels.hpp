@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+#include "body_store.hpp"
+
+// Vectorized per-body kernels. Every kernel has a scalar reference version;
+// the SIMD versions produce the same results and only differ in speed.
+
+enum class SimdLevel { Scalar, Sse2, Avx2, Neon };
+
+// Widest instruction set this CPU supports (checked once at runtime on x86).
+SimdLevel bestSimdLevel();
+// Every level this CPU can run, from Scalar up to bestSimdLevel().
+std::vector<SimdLevel> simdLevels();
+const char* simdLevelName(SimdLevel level);
+
+struct IntegrateParams {
+    float dt = 0.f;
+    float gravity = 0.f;        // added to vy, +y is down
+    float width = 0.f;
+    float height = 0.f;
+    float restitution = 1.f;    // wall restitution
+    float restingSpeed = 0.f;   // wall hits slower than this stop instead of bouncing
+    bool  sleeping = false;     // skip gravity for BodyAsleep bodies
+    bool  periodic = false;     // wrap around instead of bouncing off the walls
+};
+
+// ---- Movement + walls ----
+// Ages every body by dt, applies gravity, moves it and clamps it back inside
+// [0, width] x [0, height], reflecting and damping the velocity on contact.
+// With p.periodic there are no walls: centers are wrapped back into
+// [0, width) x [0, height) instead. Sleeping bodies have no velocity, so
+// with p.sleeping they stay put.
+// Gravity, sleeping and the resting wall model are compiled into separate
+// loops (see policies.hpp), picked here once per call.
+void integrateBodies(BodyStore& s, const IntegrateParams& p, SimdLevel level);
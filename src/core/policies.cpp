@@ -0,0 +1,31 @@
+#include "policies.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+Body AreaMerges::merge(const Body& a, const Body& b) {
+    // areas add up, and momentum is kept: everything else is weighted by mass
+    float wA = massOf(a.radius);
+    float wB = massOf(b.radius);
+    float wSum = wA + wB;
+
+    Body m;
+    m.radius = std::sqrt(a.radius * a.radius + b.radius * b.radius);
+    m.x  = (a.x * wA + b.x * wB) / wSum;
+    m.y  = (a.y * wA + b.y * wB) / wSum;
+    m.vx = (a.vx * wA + b.vx * wB) / wSum;
+    m.vy = (a.vy * wA + b.vy * wB) / wSum;
+    m.canMerge = false;
+
+    const Rgba& cA = a.color;
+    const Rgba& cB = b.color;
+    auto blendChannel = [&](std::uint8_t a, std::uint8_t b) -> std::uint8_t {
+        float v = (a * wA + b * wB) / wSum;
+        return static_cast<std::uint8_t>(std::clamp(v, 0.f, 255.f));
+    };
+    m.color.r = blendChannel(cA.r, cB.r);
+    m.color.g = blendChannel(cA.g, cB.g);
+    m.color.b = blendChannel(cA.b, cB.b);
+    m.color.a = blendChannel(cA.a, cB.a);
+    return m;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "body_store.hpp"
+
+// Policy types for the step kernels. Each one names a behavior a sim may or
+// may not have, and the kernels are templates over them: a combination is
+// compiled as its own loop, with if constexpr dropping whatever the policies
+// turn off. The World picks the instantiation from its WorldConfig once per
+// call, so the config stays the one place a sim is described, and a new sim
+// made from a different config gets a loop specialized for it without
+// copying any of the step.
+
+// ---- Integration ----
+
+struct NoGravity   { static constexpr bool enabled = false; };
+struct WithGravity { static constexpr bool enabled = true; };
+
+// With SkipSleeping, BodyAsleep bodies get no gravity.
+struct AllAwake     { static constexpr bool enabled = false; };
+struct SkipSleeping { static constexpr bool enabled = true; };
+
+// Wall models: both reflect the velocity with the wall restitution;
+// RestingWalls stop bodies slower than IntegrateParams::restingSpeed dead.
+// WrapEdges has no walls: a body leaving one side comes back on the other.
+struct BounceWalls  { static constexpr bool resting = false; static constexpr bool wrap = false; };
+struct RestingWalls { static constexpr bool resting = true;  static constexpr bool wrap = false; };
+struct WrapEdges    { static constexpr bool resting = false; static constexpr bool wrap = true; };
+
+template <class GravityP, class SleepP, class WallsP>
+struct IntegratePolicy {
+    using Gravity = GravityP;
+    using Sleep = SleepP;
+    using Walls = WallsP;
+};
+
+// ---- Pair rules ----
+
+struct NoPops { static constexpr bool enabled = false; };
+
+// Bubbles: old, slow bubbles pop by themselves, and two that touch pop
+// together, with the thresholds and odds of WorldConfig::rules.
+struct BubblePops { static constexpr bool enabled = true; };
+
+struct NoMerges { static constexpr bool enabled = false; };
+
+// Two touching bodies that may both still merge do so one step in
+// WorldConfig::rules.mergeOdds. The result keeps their total area and
+// momentum, and can't merge again.
+struct AreaMerges {
+    static constexpr bool enabled = true;
+
+    static Body merge(const Body& a, const Body& b);
+    static Body merge(const BodyStore& s, std::size_t i, std::size_t j) { return merge(s.get(i), s.get(j)); }
+};
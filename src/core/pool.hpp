@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Slot map: items live densely in one array (cheap to iterate), handles stay
+// valid while other items come and go. Removal swaps the last item into the
+// hole. Freed slots go on a free list and are reused before the arrays grow,
+// so once capacity is reserved, add/remove never allocate.
+
+struct PoolHandle {
+    std::uint32_t slot = ~0u;
+    std::uint32_t generation = 0;
+};
+
+template <class T>
+class Pool {
+public:
+    void reserve(std::size_t n) {
+        items_.reserve(n);
+        owner_.reserve(n);
+        slots_.reserve(n);
+        free_.reserve(n);
+    }
+
+    std::size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+
+    PoolHandle add(const T& item) {
+        std::uint32_t slot;
+        if (!free_.empty()) {
+            slot = free_.back();
+            free_.pop_back();
+        } else {
+            slot = static_cast<std::uint32_t>(slots_.size());
+            slots_.push_back(Slot());
+        }
+
+        slots_[slot].dense = static_cast<std::uint32_t>(items_.size());
+        items_.push_back(item);
+        owner_.push_back(slot);
+        return { slot, slots_[slot].generation };
+    }
+
+    // nullptr once the item has been removed
+    T* get(PoolHandle h) {
+        if (h.slot >= slots_.size() || slots_[h.slot].generation != h.generation) return nullptr;
+        return &items_[slots_[h.slot].dense];
+    }
+
+    void remove(PoolHandle h) {
+        if (get(h)) removeAt(slots_[h.slot].dense);
+    }
+
+    // Removes the item at dense position i; the last item moves into i.
+    void removeAt(std::size_t i) {
+        std::uint32_t slot = owner_[i];
+        std::size_t last = items_.size() - 1;
+        if (i != last) {
+            items_[i] = items_[last];
+            owner_[i] = owner_[last];
+            slots_[owner_[i]].dense = static_cast<std::uint32_t>(i);
+        }
+        items_.pop_back();
+        owner_.pop_back();
+
+        slots_[slot].generation++;
+        free_.push_back(slot);
+    }
+
+    // Removes every item for which dead(item) is true, in place.
+    template <class F>
+    void removeIf(F&& dead) {
+        for (std::size_t i = 0; i < items_.size();) {
+            if (dead(items_[i])) removeAt(i);
+            else i++;
+        }
+    }
+
+    T& operator[](std::size_t i) { return items_[i]; }
+    const T& operator[](std::size_t i) const { return items_[i]; }
+
+    typename std::vector<T>::iterator begin() { return items_.begin(); }
+    typename std::vector<T>::iterator end() { return items_.end(); }
+    typename std::vector<T>::const_iterator begin() const { return items_.begin(); }
+    typename std::vector<T>::const_iterator end() const { return items_.end(); }
+
+private:
+    struct Slot {
+        std::uint32_t dense = 0;
+        std::uint32_t generation = 0;
+    };
+
+    std::vector<T> items_;
+    std::vector<std::uint32_t> owner_;  // dense index -> slot
+    std::vector<Slot> slots_;
+    std::vector<std::uint32_t> free_;
+};
@@ -0,0 +1,260 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "json.hpp"
+
+Profiler& Profiler::get() {
+    static Profiler instance;
+    return instance;
+}
+
+Profiler::Profiler()
+    : epoch_(Clock::now()), lastDump_(epoch_) {}
+
+Profiler::~Profiler() {
+    stopTrace();
+}
+
+int Profiler::section(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < sections_.size(); i++) {
+        if (sections_[i].name == name) return static_cast<int>(i);
+    }
+    Section s;
+    s.name = name;
+    s.history.assign(kWindow, 0.f);
+    sections_.push_back(s);
+    return static_cast<int>(sections_.size() - 1);
+}
+
+int Profiler::counter(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < counters_.size(); i++) {
+        if (counters_[i].name == name) return static_cast<int>(i);
+    }
+    Counter c;
+    c.name = name;
+    c.history.assign(kWindow, 0.f);
+    counters_.push_back(c);
+    return static_cast<int>(counters_.size() - 1);
+}
+
+// Registered on a thread's first record and kept for the profiler's life,
+// so a log never dangles when its thread exits.
+Profiler::ThreadLog& Profiler::threadLog() {
+    thread_local ThreadLog* log = nullptr;
+    if (!log) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.emplace_back(new ThreadLog);
+        log = threads_.back().get();
+        log->thread = static_cast<int>(threads_.size());
+    }
+    return *log;
+}
+
+void Profiler::record(int section, Clock::time_point begin, Clock::time_point end) {
+    if (!enabled()) return;
+    ThreadLog& log = threadLog();
+    std::lock_guard<std::mutex> lock(log.mutex);
+    if (log.sections.size() <= static_cast<std::size_t>(section)) log.sections.resize(section + 1, 0.0);
+    log.sections[section] += std::chrono::duration<double>(end - begin).count();
+
+    if (traceOn_.load(std::memory_order_relaxed)) {
+        double b = std::chrono::duration<double, std::micro>(begin - epoch_).count();
+        double d = std::chrono::duration<double, std::micro>(end - begin).count();
+        log.events.push_back({ section, log.thread, b, d });
+    }
+}
+
+void Profiler::add(int counter, std::uint64_t n) {
+    if (!enabled()) return;
+    ThreadLog& log = threadLog();
+    std::lock_guard<std::mutex> lock(log.mutex);
+    if (log.counters.size() <= static_cast<std::size_t>(counter)) log.counters.resize(counter + 1, 0);
+    log.counters[counter] += n;
+}
+
+void Profiler::endFrame() {
+    if (!enabled()) return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto& t : threads_) {
+        std::lock_guard<std::mutex> logLock(t->mutex);
+        for (std::size_t i = 0; i < t->sections.size(); i++) {
+            sections_[i].frame += t->sections[i];
+            t->sections[i] = 0.0;
+        }
+        for (std::size_t i = 0; i < t->counters.size(); i++) {
+            counters_[i].frame += t->counters[i];
+            t->counters[i] = 0;
+        }
+        pending_.insert(pending_.end(), t->events.begin(), t->events.end());
+        t->events.clear();
+    }
+
+    const std::size_t slot = frames_ % kWindow;
+    for (auto& s : sections_) {
+        s.history[slot] = static_cast<float>(s.frame * 1e3);
+        s.frame = 0;
+    }
+    for (auto& c : counters_) {
+        c.history[slot] = static_cast<float>(c.frame);
+        c.frame = 0;
+    }
+    frames_++;
+
+    if (trace_.is_open()) {
+        for (const TraceEvent& e : pending_) {
+            trace_ << (traceFirst_ ? "\n" : ",\n")
+                   << "{\"name\":\"" << sections_[e.section].name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread << ","
+                   << std::fixed << std::setprecision(3)
+                   << "\"ts\":" << e.beginUs << ",\"dur\":" << e.durUs << "}";
+            traceFirst_ = false;
+        }
+        pending_.clear();
+    }
+    lock.unlock();
+
+    if (!dumpPath_.empty()) {
+        Clock::time_point now = Clock::now();
+        if (std::chrono::duration<double>(now - lastDump_).count() >= dumpInterval_) {
+            writeDump();
+            lastDump_ = now;
+        }
+    }
+}
+
+std::vector<Profiler::SectionStat> Profiler::sectionStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::size_t n = std::min(frames_, kWindow);
+    std::vector<SectionStat> out;
+    std::vector<float> sorted;
+
+    for (const auto& s : sections_) {
+        SectionStat st;
+        st.name = s.name;
+        if (n > 0) {
+            sorted.assign(s.history.begin(), s.history.begin() + n);
+            std::sort(sorted.begin(), sorted.end());
+            auto pct = [&](double p) { return sorted[static_cast<std::size_t>(p * (n - 1) + 0.5)]; };
+            st.p50 = pct(0.50);
+            st.p95 = pct(0.95);
+            st.p99 = pct(0.99);
+            st.max = sorted.back();
+        }
+        out.push_back(st);
+    }
+    return out;
+}
+
+std::vector<Profiler::CounterStat> Profiler::counterStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::size_t n = std::min(frames_, kWindow);
+    std::vector<CounterStat> out;
+
+    for (const auto& c : counters_) {
+        CounterStat st;
+        st.name = c.name;
+        if (n > 0) {
+            double sum = 0;
+            for (std::size_t i = 0; i < n; i++) sum += c.history[i];
+            st.mean = sum / n;
+            st.last = c.history[(frames_ - 1) % kWindow];
+        }
+        out.push_back(st);
+    }
+    return out;
+}
+
+void Profiler::startDump(const std::string& path, double intervalSeconds) {
+    dumpPath_ = path;
+    dumpInterval_ = intervalSeconds > 0 ? intervalSeconds : 1.0;
+    dumpJson_ = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    dumpHeader_ = false;
+    lastDump_ = Clock::now();
+}
+
+// CSV appends one row per section/counter each interval; JSON rewrites the
+// file with the latest summary.
+void Profiler::writeDump() {
+    const double t = std::chrono::duration<double>(Clock::now() - epoch_).count();
+    const auto sections = sectionStats();
+    const auto counters = counterStats();
+
+    if (dumpJson_) {
+        JsonValue root = JsonValue::makeObject();
+        root.set("time", t);
+        root.set("frames", static_cast<double>(frames_));
+        JsonValue& secs = root.set("sections_ms", JsonValue::makeObject());
+        for (const auto& s : sections) {
+            JsonValue v = JsonValue::makeObject();
+            v.set("p50", s.p50);
+            v.set("p95", s.p95);
+            v.set("p99", s.p99);
+            v.set("max", s.max);
+            secs.set(s.name, v);
+        }
+        JsonValue& cnts = root.set("counters_per_frame", JsonValue::makeObject());
+        for (const auto& c : counters) {
+            cnts.set(c.name, c.mean);
+        }
+        std::ofstream out(dumpPath_);
+        out << toJson(root) << "\n";
+        return;
+    }
+
+    std::ofstream out(dumpPath_, dumpHeader_ ? std::ios::app : std::ios::trunc);
+    if (!dumpHeader_) {
+        out << "time,kind,name,p50_ms,p95_ms,p99_ms,max_ms,mean\n";
+        dumpHeader_ = true;
+    }
+    out << std::fixed << std::setprecision(4);
+    for (const auto& s : sections) {
+        out << t << ",section," << s.name << "," << s.p50 << "," << s.p95 << ","
+            << s.p99 << "," << s.max << ",\n";
+    }
+    for (const auto& c : counters) {
+        out << t << ",counter," << c.name << ",,,,," << c.mean << "\n";
+    }
+}
+
+bool Profiler::startTrace(const std::string& path) {
+    stopTrace();
+    trace_.open(path, std::ios::trunc);
+    if (!trace_) {
+        std::cerr << "Failed to open trace file " << path << "\n";
+        return false;
+    }
+    trace_ << "[";
+    traceFirst_ = true;
+    traceOn_ = true;
+    return true;
+}
+
+void Profiler::stopTrace() {
+    if (!trace_.is_open()) return;
+    traceOn_ = false;
+    pending_.clear();
+    trace_ << "\n]\n";
+    trace_.close();
+}
+
+void Profiler::configureFromEnv() {
+    const char* on = std::getenv("PHYS_PROFILE");
+    const char* dump = std::getenv("PHYS_PROFILE_DUMP");
+    const char* interval = std::getenv("PHYS_PROFILE_INTERVAL");
+    const char* trace = std::getenv("PHYS_TRACE");
+
+    if (on && *on && *on != '0') enabled_ = true;
+    if (dump && *dump) {
+        startDump(dump, interval ? std::atof(interval) : 1.0);
+        enabled_ = true;
+    }
+    if (trace && *trace && startTrace(trace)) {
+        enabled_ = true;
+    }
+}
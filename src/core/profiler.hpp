@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Frame profiler for the hot path. Sections are timed with PROF_SCOPE (or
+// fed directly by World's phase clock), counters with PROF_COUNT. While the
+// profiler is disabled a scope costs one branch; building with
+// -DPHYS_NO_PROFILE removes the macros entirely.
+//
+// Per frame, each section's total time goes into a rolling window that
+// percentiles are computed from. The same data can be shown as an overlay,
+// dumped periodically as CSV/JSON, or streamed as Chrome trace events.
+// Any thread may record: each fills its own buffer, and PROF_FRAME, called
+// from one thread, adds them all into that frame. A sim stepped on its own
+// thread thus shows up with whatever steps it finished since the last frame.
+
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct SectionStat {
+        std::string name;
+        double p50 = 0, p95 = 0, p99 = 0, max = 0;   // ms per frame
+    };
+
+    struct CounterStat {
+        std::string name;
+        double mean = 0;                              // per frame
+        double last = 0;
+    };
+
+    static Profiler& get();
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    void setEnabled(bool on) { enabled_.store(on, std::memory_order_relaxed); }
+
+    // Interns a name; call once per call site and keep the id.
+    int section(const char* name);
+    int counter(const char* name);
+
+    void record(int section, Clock::time_point begin, Clock::time_point end);
+    void add(int counter, std::uint64_t n);
+
+    // Closes the frame: pushes totals into the rolling windows, flushes
+    // trace events and writes the periodic dump when it is due.
+    void endFrame();
+
+    std::vector<SectionStat> sectionStats() const;
+    std::vector<CounterStat> counterStats() const;
+
+    // Periodic summary, format chosen by extension (.json, anything else is CSV).
+    void startDump(const std::string& path, double intervalSeconds);
+    // Chrome trace-event JSON, viewable in chrome://tracing or Perfetto.
+    bool startTrace(const std::string& path);
+    void stopTrace();
+
+    // PHYS_PROFILE=1 enables, PHYS_PROFILE_DUMP=<file> (+ PHYS_PROFILE_INTERVAL
+    // seconds) dumps, PHYS_TRACE=<file> traces. Any of them enables profiling.
+    void configureFromEnv();
+
+    ~Profiler();
+
+private:
+    Profiler();
+
+    static constexpr std::size_t kWindow = 240;   // frames
+
+    struct Section {
+        std::string name;
+        double frame = 0;                      // seconds in the current frame
+        std::vector<float> history;            // ms, ring buffer
+    };
+
+    struct Counter {
+        std::string name;
+        std::uint64_t frame = 0;
+        std::vector<float> history;
+    };
+
+    struct TraceEvent {
+        int section;
+        int thread;
+        double beginUs, durUs;
+    };
+
+    // What one thread recorded since the last frame, indexed like
+    // sections_ and counters_.
+    struct ThreadLog {
+        std::mutex mutex;
+        int thread = 0;                        // trace tid
+        std::vector<double> sections;
+        std::vector<std::uint64_t> counters;
+        std::vector<TraceEvent> events;
+    };
+
+    ThreadLog& threadLog();
+    void writeDump();
+
+    std::atomic<bool> enabled_{ false };
+    mutable std::mutex mutex_;                 // names, the thread list, the frame merge and stats
+    std::vector<std::unique_ptr<ThreadLog>> threads_;
+    std::vector<Section> sections_;
+    std::vector<Counter> counters_;
+    std::size_t frames_ = 0;                   // frames closed so far
+    Clock::time_point epoch_;
+
+    std::ofstream trace_;
+    std::atomic<bool> traceOn_{ false };       // trace_ is open; read by recording threads
+    bool traceFirst_ = true;
+    std::vector<TraceEvent> pending_;
+
+    std::string dumpPath_;
+    bool dumpJson_ = false;
+    bool dumpHeader_ = false;
+    double dumpInterval_ = 1.0;
+    Clock::time_point lastDump_;
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(int section)
+        : section_(section), on_(Profiler::get().enabled()) {
+        if (on_) begin_ = Profiler::Clock::now();
+    }
+    ~ProfileScope() {
+        if (on_) Profiler::get().record(section_, begin_, Profiler::Clock::now());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    int section_;
+    bool on_;
+    Profiler::Clock::time_point begin_;
+};
+
+#define PROF_CAT2(a, b) a##b
+#define PROF_CAT(a, b) PROF_CAT2(a, b)
+
+#ifndef PHYS_NO_PROFILE
+    #define PROF_SCOPE(name)                                                              \
+        static const int PROF_CAT(profSection_, __LINE__) = Profiler::get().section(name); \
+        ProfileScope PROF_CAT(profScope_, __LINE__)(PROF_CAT(profSection_, __LINE__))
+    #define PROF_COUNT(name, n)                                                           \
+        do {                                                                              \
+            if (Profiler::get().enabled()) {                                              \
+                static const int profCounter_ = Profiler::get().counter(name);           \
+                Profiler::get().add(profCounter_, (n));                                   \
+            }                                                                             \
+        } while (0)
+    #define PROF_FRAME() Profiler::get().endFrame()
+#else
+    #define PROF_SCOPE(name) ((void)0)
+    #define PROF_COUNT(name, n) ((void)0)
+    #define PROF_FRAME() ((void)0)
+#endif
@@ -0,0 +1,465 @@
+#include "recorder.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+
+namespace {
+
+constexpr char kMagic[8] = { 'P', 'H', 'Y', 'S', 'T', 'R', 'A', 'J' };
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kByteOrder = 0x01020304;
+constexpr std::uint32_t kChunkMagic = 0x4B4E4843;   // "CHNK"
+
+// id, x, y, vx, vy, radius
+constexpr int kBodyFields = 6;
+// type, x, y, radius
+constexpr int kEventFields = 4;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t framesPerChunk;
+    float positionStep, velocityStep, radiusStep;
+    float stepDt;
+    float width, height;
+    std::uint32_t reserved;
+    std::uint64_t seed;
+};
+
+struct ChunkHeader {
+    std::uint32_t magic;
+    std::uint32_t frames;
+    std::uint32_t bytes;        // payload size
+    std::uint32_t reserved;
+};
+
+static_assert(std::is_trivially_copyable<FileHeader>::value, "FileHeader is written raw");
+static_assert(std::is_trivially_copyable<ChunkHeader>::value, "ChunkHeader is written raw");
+
+std::int32_t quantize(float v, float inv) {
+    double q = std::nearbyint(static_cast<double>(v) * inv);
+    if (!(q > std::numeric_limits<std::int32_t>::min())) q = std::numeric_limits<std::int32_t>::min();
+    if (q > std::numeric_limits<std::int32_t>::max()) q = std::numeric_limits<std::int32_t>::max();
+    return static_cast<std::int32_t>(q);
+}
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+void putSigned(std::vector<std::uint8_t>& out, std::int64_t v) {
+    putVarint(out, (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63));
+}
+
+void putColor(std::vector<std::uint8_t>& out, Rgba c) {
+    out.push_back(c.r);
+    out.push_back(c.g);
+    out.push_back(c.b);
+    out.push_back(c.a);
+}
+
+// Bounds-checked cursor over one chunk's payload; any overrun sets failed.
+struct ByteReader {
+    const std::uint8_t* p;
+    const std::uint8_t* end;
+    bool failed = false;
+
+    std::uint64_t varint() {
+        std::uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) break;
+            std::uint8_t b = *p++;
+            v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        failed = true;
+        return 0;
+    }
+
+    std::int64_t signedVarint() {
+        std::uint64_t z = varint();
+        return static_cast<std::int64_t>(z >> 1) ^ -static_cast<std::int64_t>(z & 1);
+    }
+
+    std::uint8_t byte() {
+        if (p == end) { failed = true; return 0; }
+        return *p++;
+    }
+
+    Rgba color() {
+        Rgba c;
+        c.r = byte(); c.g = byte(); c.b = byte(); c.a = byte();
+        return c;
+    }
+};
+
+} // namespace
+
+// ---- Recorder ----
+
+void TrajectoryRecorder::Chunk::clear() {
+    frames.clear();
+    bodies.clear();
+    colors.clear();
+    events.clear();
+    eventColors.clear();
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    close();
+}
+
+bool TrajectoryRecorder::open(const std::string& path, const World& world, const RecorderOptions& options) {
+    close();
+
+    options_ = options;
+    if (options_.framesPerChunk < 1) options_.framesPerChunk = 1;
+    if (options_.ringChunks < 2) options_.ringChunks = 2;
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        std::cerr << "Failed to open recording " << path << "\n";
+        return false;
+    }
+
+    FileHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.byteOrder = kByteOrder;
+    h.framesPerChunk = static_cast<std::uint32_t>(options_.framesPerChunk);
+    h.positionStep = options_.positionStep;
+    h.velocityStep = options_.velocityStep;
+    h.radiusStep = options_.radiusStep;
+    h.stepDt = options_.stepDt;
+    h.width = world.config().width;
+    h.height = world.config().height;
+    h.seed = world.config().seed;
+    if (std::fwrite(&h, sizeof(h), 1, file_) != 1) {
+        std::cerr << "Failed to write recording " << path << "\n";
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    invPosition_ = 1.f / options_.positionStep;
+    invVelocity_ = 1.f / options_.velocityStep;
+    invRadius_ = 1.f / options_.radiusStep;
+
+    chunks_.assign(options_.ringChunks, Chunk());
+    state_.assign(options_.ringChunks, SlotState::Free);
+    current_ = -1;
+    nextSlot_ = 0;
+    writeSlot_ = 0;
+    recordedFrames_ = 0;
+    droppedFrames_ = 0;
+    bytesWritten_ = sizeof(h);
+    writeFailed_ = false;
+    stopping_ = false;
+
+    thread_ = std::thread(&TrajectoryRecorder::writerLoop, this);
+    return true;
+}
+
+void TrajectoryRecorder::record(const World& world) {
+    if (!file_) return;
+
+    if (current_ < 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_[nextSlot_] != SlotState::Free) {
+            droppedFrames_++;       // the writer is a whole ring behind
+            return;
+        }
+        current_ = nextSlot_;
+        nextSlot_ = (nextSlot_ + 1) % static_cast<int>(chunks_.size());
+        state_[current_] = SlotState::Filling;
+        chunks_[current_].clear();
+    }
+
+    Chunk& c = chunks_[current_];
+
+    const BodyStore& s = world.bodies();
+    const std::size_t n = s.size();
+
+    FrameSpan f;
+    f.step = world.stats().steps;
+    f.bodyBegin = static_cast<std::uint32_t>(c.colors.size());
+    f.bodyCount = static_cast<std::uint32_t>(n);
+    f.eventBegin = static_cast<std::uint32_t>(c.eventColors.size());
+    f.eventCount = static_cast<std::uint32_t>(world.events().size());
+    c.frames.push_back(f);
+
+    std::size_t base = c.bodies.size();
+    c.bodies.resize(base + n * kBodyFields);
+    std::int32_t* out = c.bodies.data() + base;
+    for (std::size_t i = 0; i < n; i++) {
+        out[0] = static_cast<std::int32_t>(s.id[i]);
+        out[1] = quantize(s.x[i], invPosition_);
+        out[2] = quantize(s.y[i], invPosition_);
+        out[3] = quantize(s.vx[i], invVelocity_);
+        out[4] = quantize(s.vy[i], invVelocity_);
+        out[5] = quantize(s.radius[i], invRadius_);
+        out += kBodyFields;
+    }
+    c.colors.insert(c.colors.end(), s.color.begin(), s.color.end());
+
+    for (const SimEvent& e : world.events()) {
+        c.events.push_back(static_cast<std::int32_t>(e.type));
+        c.events.push_back(quantize(e.x, invPosition_));
+        c.events.push_back(quantize(e.y, invPosition_));
+        c.events.push_back(quantize(e.radius, invRadius_));
+        c.eventColors.push_back(e.color);
+    }
+
+    recordedFrames_++;
+    if (static_cast<int>(c.frames.size()) >= options_.framesPerChunk) submit();
+}
+
+void TrajectoryRecorder::submit() {
+    if (current_ < 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        state_[current_] = SlotState::Queued;
+    }
+    current_ = -1;
+    wake_.notify_one();
+}
+
+void TrajectoryRecorder::close() {
+    if (!file_) return;
+
+    submit();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+
+    if (std::fclose(file_) != 0) writeFailed_ = true;
+    file_ = nullptr;
+    if (writeFailed_) std::cerr << "Recording is incomplete: a write failed\n";
+}
+
+std::uint64_t TrajectoryRecorder::bytesWritten() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytesWritten_;
+}
+
+void TrajectoryRecorder::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return state_[writeSlot_] == SlotState::Queued || stopping_; });
+        if (state_[writeSlot_] != SlotState::Queued) return;   // stopping, ring drained
+
+        lock.unlock();
+        const Chunk& c = chunks_[writeSlot_];
+        encode(c);
+
+        ChunkHeader ch;
+        ch.magic = kChunkMagic;
+        ch.frames = static_cast<std::uint32_t>(c.frames.size());
+        ch.bytes = static_cast<std::uint32_t>(encoded_.size());
+        ch.reserved = 0;
+        bool ok = std::fwrite(&ch, sizeof(ch), 1, file_) == 1 &&
+                  std::fwrite(encoded_.data(), 1, encoded_.size(), file_) == encoded_.size() &&
+                  std::fflush(file_) == 0;
+        lock.lock();
+
+        if (ok) bytesWritten_ += sizeof(ch) + encoded_.size();
+        else    writeFailed_ = true;
+        state_[writeSlot_] = SlotState::Free;
+        writeSlot_ = (writeSlot_ + 1) % static_cast<int>(chunks_.size());
+    }
+}
+
+// Per frame: step delta, body count, bodies, event count, events. A body
+// whose id matches the previous frame's body in the same slot is written
+// as deltas; anything else is written absolute, with its color.
+void TrajectoryRecorder::encode(const Chunk& c) {
+    std::vector<std::uint8_t>& out = encoded_;
+    out.clear();
+
+    std::uint64_t prevStep = 0;
+    const std::int32_t* prev = nullptr;
+    std::uint32_t prevCount = 0;
+
+    for (const FrameSpan& f : c.frames) {
+        putVarint(out, f.step - prevStep);
+        prevStep = f.step;
+        putVarint(out, f.bodyCount);
+
+        const std::int32_t* cur = c.bodies.data() + std::size_t(f.bodyBegin) * kBodyFields;
+        for (std::uint32_t i = 0; i < f.bodyCount; i++) {
+            const std::int32_t* b = cur + std::size_t(i) * kBodyFields;
+            const std::int32_t* p = (prev && i < prevCount) ? prev + std::size_t(i) * kBodyFields : nullptr;
+            std::int64_t prevId = p ? p[0] : 0;
+            putSigned(out, std::int64_t(b[0]) - prevId);
+
+            if (p && p[0] == b[0]) {
+                for (int k = 1; k < kBodyFields; k++) putSigned(out, std::int64_t(b[k]) - p[k]);
+            } else {
+                for (int k = 1; k < kBodyFields; k++) putSigned(out, b[k]);
+                putColor(out, c.colors[f.bodyBegin + i]);
+            }
+        }
+        prev = cur;
+        prevCount = f.bodyCount;
+
+        putVarint(out, f.eventCount);
+        for (std::uint32_t e = 0; e < f.eventCount; e++) {
+            const std::int32_t* ev = c.events.data() + std::size_t(f.eventBegin + e) * kEventFields;
+            out.push_back(static_cast<std::uint8_t>(ev[0]));
+            for (int k = 1; k < kEventFields; k++) putSigned(out, ev[k]);
+            putColor(out, c.eventColors[f.eventBegin + e]);
+        }
+    }
+}
+
+// ---- Reader ----
+
+TrajectoryReader::~TrajectoryReader() = default;
+
+bool TrajectoryReader::open(const std::string& path) {
+    path_ = path;
+    chunkOffsets_.clear();
+    frameCount_ = 0;
+    nextChunk_ = nextFrame_ = 0;
+    sequential_.clear();
+
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "Failed to open recording " << path << "\n";
+        return false;
+    }
+
+    FileHeader h;
+    if (std::fread(&h, sizeof(h), 1, f) != 1 || std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+        std::cerr << path << " is not a recording\n";
+        std::fclose(f);
+        return false;
+    }
+    if (h.byteOrder != kByteOrder || h.version != kVersion) {
+        std::cerr << path << " is recording version " << h.version
+                  << ", this build reads version " << kVersion << "\n";
+        std::fclose(f);
+        return false;
+    }
+
+    info_.width = h.width;
+    info_.height = h.height;
+    info_.stepDt = h.stepDt;
+    info_.seed = h.seed;
+    info_.framesPerChunk = h.framesPerChunk;
+    positionStep_ = h.positionStep;
+    velocityStep_ = h.velocityStep;
+    radiusStep_ = h.radiusStep;
+
+    // Index the chunks; a torn last chunk (crash mid-write) is ignored.
+    std::fseek(f, 0, SEEK_END);
+    long fileSize = std::ftell(f);
+    long at = static_cast<long>(sizeof(h));
+    for (;;) {
+        ChunkHeader ch;
+        std::fseek(f, at, SEEK_SET);
+        if (std::fread(&ch, sizeof(ch), 1, f) != 1 || ch.magic != kChunkMagic) break;
+        long payload = at + static_cast<long>(sizeof(ch));
+        if (payload + static_cast<long>(ch.bytes) > fileSize) break;
+        chunkOffsets_.push_back({ payload, ch.frames, ch.bytes });
+        frameCount_ += ch.frames;
+        at = payload + static_cast<long>(ch.bytes);
+    }
+    std::fclose(f);
+    return true;
+}
+
+bool TrajectoryReader::readChunk(std::size_t index, std::vector<TrajectoryFrame>& frames) const {
+    if (index >= chunkOffsets_.size()) return false;
+    const ChunkRef& ref = chunkOffsets_[index];
+
+    std::vector<std::uint8_t> bytes(ref.bytes);
+    std::FILE* f = std::fopen(path_.c_str(), "rb");
+    if (!f) return false;
+    bool ok = std::fseek(f, ref.offset, SEEK_SET) == 0 &&
+              std::fread(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    std::fclose(f);
+    if (!ok) return false;
+
+    ByteReader in{ bytes.data(), bytes.data() + bytes.size() };
+    frames.resize(ref.frames);
+
+    // quantized values of the previous and current frame, kBodyFields per body
+    std::vector<std::int64_t> prevQ, curQ;
+
+    std::uint64_t step = 0;
+    for (TrajectoryFrame& fr : frames) {
+        step += in.varint();
+        fr.step = step;
+
+        std::uint64_t n = in.varint();
+        if (n > bytes.size()) return false;     // can't be, each body takes bytes
+        fr.id.resize(n);
+        fr.x.resize(n); fr.y.resize(n);
+        fr.vx.resize(n); fr.vy.resize(n);
+        fr.radius.resize(n);
+        fr.color.resize(n);
+
+        curQ.resize(n * kBodyFields);
+        const std::size_t prevCount = prevQ.size() / kBodyFields;
+        const TrajectoryFrame* prev = &fr == &frames[0] ? nullptr : &fr - 1;
+
+        for (std::size_t i = 0; i < n; i++) {
+            const std::int64_t* p = i < prevCount ? prevQ.data() + i * kBodyFields : nullptr;
+            std::int64_t* v = curQ.data() + i * kBodyFields;
+            std::int64_t prevId = p ? p[0] : 0;
+            v[0] = prevId + in.signedVarint();
+            fr.id[i] = static_cast<std::uint32_t>(v[0]);
+
+            if (p && v[0] == prevId) {
+                for (int k = 1; k < kBodyFields; k++) v[k] = p[k] + in.signedVarint();
+                fr.color[i] = prev->color[i];
+            } else {
+                for (int k = 1; k < kBodyFields; k++) v[k] = in.signedVarint();
+                fr.color[i] = in.color();
+            }
+            fr.x[i] = static_cast<float>(v[1] * static_cast<double>(positionStep_));
+            fr.y[i] = static_cast<float>(v[2] * static_cast<double>(positionStep_));
+            fr.vx[i] = static_cast<float>(v[3] * static_cast<double>(velocityStep_));
+            fr.vy[i] = static_cast<float>(v[4] * static_cast<double>(velocityStep_));
+            fr.radius[i] = static_cast<float>(v[5] * static_cast<double>(radiusStep_));
+        }
+
+        std::uint64_t events = in.varint();
+        if (events > bytes.size()) return false;
+        fr.events.resize(events);
+        for (SimEvent& e : fr.events) {
+            e.type = static_cast<EventType>(in.byte());
+            e.x = static_cast<float>(in.signedVarint() * static_cast<double>(positionStep_));
+            e.y = static_cast<float>(in.signedVarint() * static_cast<double>(positionStep_));
+            e.radius = static_cast<float>(in.signedVarint() * static_cast<double>(radiusStep_));
+            e.color = in.color();
+        }
+
+        if (in.failed) return false;
+        prevQ.swap(curQ);
+    }
+    return true;
+}
+
+bool TrajectoryReader::next(TrajectoryFrame& frame) {
+    while (nextFrame_ >= sequential_.size()) {
+        if (nextChunk_ >= chunkOffsets_.size()) return false;
+        if (!readChunk(nextChunk_++, sequential_)) return false;
+        nextFrame_ = 0;
+    }
+    frame = sequential_[nextFrame_++];
+    return true;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "world.hpp"
+
+// Trajectory recording: every step of a run (each body's id, position,
+// velocity and radius, plus that step's pop/merge events) streamed to disk.
+//
+// Values are quantized to fixed steps, then each frame is delta-coded
+// against the previous frame of the same chunk and written as zigzag
+// varints. A body that keeps its slot and id costs a few bytes per step;
+// one that is new in its slot (first frame of a chunk, after a merge or
+// compaction) is written in full, including its color. Chunks stand alone,
+// so a file cut short by a crash loses at most the last chunk and readers
+// can decode chunks in parallel.
+
+struct RecorderOptions {
+    int   framesPerChunk = 64;
+    int   ringChunks = 8;               // chunks in flight between sim and disk
+    float positionStep = 1.f / 64.f;    // quantization, world units
+    float velocityStep = 1.f / 16.f;    // units / s
+    float radiusStep = 1.f / 256.f;
+    float stepDt = 1.f / 100.f;         // informational, for replay timing
+};
+
+// Records from the sim thread without ever waiting on the disk: the sim
+// fills a chunk in a fixed ring, a background thread encodes and writes
+// full chunks. If the ring is full the sim drops frames (counted in
+// droppedFrames()) rather than stall. After the first lap of the ring,
+// recording reuses its buffers and doesn't allocate.
+class TrajectoryRecorder {
+public:
+    TrajectoryRecorder() = default;
+    ~TrajectoryRecorder();   // close()s
+
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    bool open(const std::string& path, const World& world,
+              const RecorderOptions& options = RecorderOptions());
+    bool isOpen() const { return file_ != nullptr; }
+
+    // Captures the world as it is now, with world.events() as this step's
+    // events. Call once per step, before clearing events.
+    void record(const World& world);
+
+    // Flushes the partial chunk, waits for the writer and closes the file.
+    void close();
+
+    std::uint64_t recordedFrames() const { return recordedFrames_; }
+    std::uint64_t droppedFrames() const { return droppedFrames_; }
+    std::uint64_t bytesWritten() const;
+
+private:
+    struct FrameSpan {
+        std::uint64_t step;
+        std::uint32_t bodyBegin, bodyCount;
+        std::uint32_t eventBegin, eventCount;
+    };
+
+    // Quantized, not yet encoded frames.
+    struct Chunk {
+        std::vector<FrameSpan> frames;
+        std::vector<std::int32_t> bodies;   // kBodyFields per body
+        std::vector<Rgba> colors;
+        std::vector<std::int32_t> events;   // kEventFields per event
+        std::vector<Rgba> eventColors;
+
+        void clear();
+    };
+
+    enum class SlotState { Free, Filling, Queued };
+
+    void submit();
+    void writerLoop();
+    void encode(const Chunk& chunk);
+
+    RecorderOptions options_;
+    std::FILE* file_ = nullptr;
+    float invPosition_ = 1.f, invVelocity_ = 1.f, invRadius_ = 1.f;
+
+    std::vector<Chunk> chunks_;
+    std::vector<SlotState> state_;
+    int current_ = -1;      // slot the sim is filling, -1 if none
+    int nextSlot_ = 0;      // slot the sim takes next
+    int writeSlot_ = 0;     // slot the writer waits on next
+
+    std::vector<std::uint8_t> encoded_;     // writer thread only
+
+    std::uint64_t recordedFrames_ = 0;
+    std::uint64_t droppedFrames_ = 0;
+    std::uint64_t bytesWritten_ = 0;        // guarded by mutex_
+    bool writeFailed_ = false;              // guarded by mutex_
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    std::thread thread_;
+};
+
+// One decoded step.
+struct TrajectoryFrame {
+    std::uint64_t step = 0;
+    std::vector<std::uint32_t> id;
+    std::vector<float> x, y, vx, vy, radius;
+    std::vector<Rgba> color;
+    std::vector<SimEvent> events;
+
+    std::size_t size() const { return id.size(); }
+};
+
+struct TrajectoryInfo {
+    float width = 0.f, height = 0.f;
+    float stepDt = 0.f;
+    std::uint64_t seed = 0;
+    std::uint32_t framesPerChunk = 0;
+};
+
+// Reads a recording. open() indexes the chunks by skipping over them, so
+// readChunk() is random access and safe to call from several threads at
+// once; next() walks the frames in order.
+class TrajectoryReader {
+public:
+    TrajectoryReader() = default;
+    ~TrajectoryReader();
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    bool open(const std::string& path);
+
+    const TrajectoryInfo& info() const { return info_; }
+    std::size_t chunkCount() const { return chunkOffsets_.size(); }
+    std::uint64_t frameCount() const { return frameCount_; }
+
+    // Decodes chunk `index` into frames, reusing their storage.
+    bool readChunk(std::size_t index, std::vector<TrajectoryFrame>& frames) const;
+
+    // Sequential access; returns false at the end of the recording.
+    bool next(TrajectoryFrame& frame);
+
+private:
+    struct ChunkRef {
+        long offset;                // payload start
+        std::uint32_t frames;
+        std::uint32_t bytes;
+    };
+
+    std::string path_;
+    TrajectoryInfo info_;
+    float positionStep_ = 1.f, velocityStep_ = 1.f, radiusStep_ = 1.f;
+    std::vector<ChunkRef> chunkOffsets_;
+    std::uint64_t frameCount_ = 0;
+
+    std::vector<TrajectoryFrame> sequential_;
+    std::size_t nextChunk_ = 0, nextFrame_ = 0;
+};
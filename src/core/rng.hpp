@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+// Counter-based RNG (Philox4x32-10). A random value is a pure function of
+// (seed, stream, step, a, b), with no hidden state, so stochastic rules give
+// the same answer whatever order pairs are visited in and from any thread.
+
+enum class RngStream : std::uint32_t {
+    Spawn = 1,
+    SlowPop,
+    PairPop,
+    Merge,
+};
+
+struct RngWords {
+    std::uint32_t w[4];
+};
+
+class CounterRng {
+public:
+    explicit CounterRng(std::uint64_t seed = 0) : seed_(seed) {}
+
+    std::uint64_t seed() const { return seed_; }
+
+    RngWords words(RngStream stream, std::uint64_t step, std::uint32_t a, std::uint32_t b = 0) const {
+        std::uint32_t ctr[4] = {
+            a, b,
+            static_cast<std::uint32_t>(step),
+            static_cast<std::uint32_t>(step >> 32),
+        };
+        std::uint32_t key[2] = {
+            static_cast<std::uint32_t>(seed_),
+            static_cast<std::uint32_t>(seed_ >> 32) ^ (static_cast<std::uint32_t>(stream) * 0x9E3779B9u),
+        };
+
+        for (int round = 0; round < 10; round++) {
+            std::uint64_t p0 = std::uint64_t(0xD2511F53u) * ctr[0];
+            std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * ctr[2];
+            std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0];
+            std::uint32_t n1 = static_cast<std::uint32_t>(p1);
+            std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1];
+            std::uint32_t n3 = static_cast<std::uint32_t>(p0);
+            ctr[0] = n0; ctr[1] = n1; ctr[2] = n2; ctr[3] = n3;
+
+            key[0] += 0x9E3779B9u;
+            key[1] += 0xBB67AE85u;
+        }
+        return { { ctr[0], ctr[1], ctr[2], ctr[3] } };
+    }
+
+    std::uint32_t next32(RngStream stream, std::uint64_t step, std::uint32_t a, std::uint32_t b = 0) const {
+        return words(stream, step, a, b).w[0];
+    }
+
+    // Uniform integer in [0, n), n > 0 (multiply-shift, no modulo bias worth
+    // mentioning for the small n the rules use).
+    std::uint32_t below(std::uint32_t n, RngStream stream, std::uint64_t step,
+                        std::uint32_t a, std::uint32_t b = 0) const {
+        return static_cast<std::uint32_t>((std::uint64_t(next32(stream, step, a, b)) * n) >> 32);
+    }
+
+private:
+    std::uint64_t seed_;
+};
+
+// Sequential draws from one stream, for code that just wants "the next
+// number", like spawning. Position in the sequence is the counter.
+class RngSequence {
+public:
+    RngSequence(std::uint64_t seed, RngStream stream) : rng_(seed), stream_(stream) {}
+
+    std::uint32_t next32() {
+        return rng_.next32(stream_, counter_++, 0);
+    }
+
+    // Uniform integer in [0, n), n > 0.
+    int below(int n) {
+        return static_cast<int>((std::uint64_t(next32()) * static_cast<std::uint32_t>(n)) >> 32);
+    }
+
+    std::uint64_t counter() const { return counter_; }
+
+private:
+    CounterRng rng_;
+    RngStream stream_;
+    std::uint64_t counter_ = 0;
+};
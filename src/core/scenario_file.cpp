@@ -0,0 +1,328 @@
+#include "scenario_file.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <utility>
+
+#include "scenarios.hpp"
+
+namespace {
+
+// Every config field a scenario may set, by its dotted name in the file.
+template <class F>
+void forEachField(WorldConfig& c, F&& f) {
+    f("width", c.width);
+    f("height", c.height);
+    f("restitutionBall", c.restitutionBall);
+    f("restitutionWall", c.restitutionWall);
+    f("gravity", c.gravity);
+    f("bubbleRules", c.bubbleRules);
+    f("seed", c.seed);
+    f("ccd", c.ccd);
+    f("solverIterations", c.solverIterations);
+    f("warmStart", c.warmStart);
+    f("restingSpeed", c.restingSpeed);
+    f("friction", c.friction);
+    f("sleeping", c.sleeping);
+    f("sleepSpeed", c.sleepSpeed);
+    f("sleepDelay", c.sleepDelay);
+    f("periodic", c.periodic);
+    f("rules.slowPopAge", c.rules.slowPopAge);
+    f("rules.slowPopSpeed", c.rules.slowPopSpeed);
+    f("rules.slowPopOdds", c.rules.slowPopOdds);
+    f("rules.pairPopAge", c.rules.pairPopAge);
+    f("rules.pairPopSpeed", c.rules.pairPopSpeed);
+    f("rules.pairPopOdds", c.rules.pairPopOdds);
+    f("rules.mergeOdds", c.rules.mergeOdds);
+}
+
+// ---- Values ----
+
+bool isWhole(const JsonValue& v, double min) {
+    return v.isNumber() && std::floor(v.number) == v.number && v.number >= min;
+}
+
+bool readValue(const JsonValue& v, float& out) {
+    if (!v.isNumber()) return false;
+    out = static_cast<float>(v.number);
+    return true;
+}
+
+bool readValue(const JsonValue& v, bool& out) {
+    if (v.type != JsonValue::Type::Bool) return false;
+    out = v.boolean;
+    return true;
+}
+
+bool readValue(const JsonValue& v, int& out) {
+    if (!isWhole(v, -2147483648.0) || v.number > 2147483647.0) return false;
+    out = static_cast<int>(v.number);
+    return true;
+}
+
+bool readValue(const JsonValue& v, std::uint32_t& out) {
+    if (!isWhole(v, 0.0) || v.number > 4294967295.0) return false;
+    out = static_cast<std::uint32_t>(v.number);
+    return true;
+}
+
+// Below 2^53 only: from there on a double can't hold every whole number,
+// and a seed would silently turn into a different one (2^53 + 1 parses
+// as 2^53).
+bool readValue(const JsonValue& v, std::uint64_t& out) {
+    if (!isWhole(v, 0.0) || v.number >= 9007199254740992.0) return false;
+    out = static_cast<std::uint64_t>(v.number);
+    return true;
+}
+
+// Numbers as short as they can be without changing: 0.8f is written as 0.8,
+// and a sweep step of 0.1 doesn't pile up into 0.30000000000000004.
+double rounded(double v, int digits) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.*g", digits, v);
+    return std::strtod(buf, nullptr);
+}
+
+JsonValue toValue(float v) { return JsonValue(rounded(v, 7)); }
+JsonValue toValue(bool v) { return JsonValue(v); }
+JsonValue toValue(int v) { return JsonValue(v); }
+JsonValue toValue(std::uint32_t v) { return JsonValue(static_cast<double>(v)); }
+JsonValue toValue(std::uint64_t v) { return JsonValue(static_cast<double>(v)); }
+
+// A value as it goes into a swept run's name.
+std::string nameText(const JsonValue& v) {
+    return v.isString() ? v.string : toJson(v, 0);
+}
+
+bool fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+// ---- Objects ----
+
+// {"rules": {"mergeOdds": 60}} -> ("rules.mergeOdds", 60)
+void flatten(const JsonValue& obj, const std::string& prefix,
+             std::vector<std::pair<std::string, const JsonValue*>>& out) {
+    for (const auto& kv : obj.object) {
+        const std::string key = prefix + kv.first;
+        if (kv.second.isObject()) flatten(kv.second, key + ".", out);
+        else out.emplace_back(key, &kv.second);
+    }
+}
+
+// Sets root.a.b.c = v, making the objects on the way as needed. False if
+// something on the way is there but isn't an object.
+bool setPath(JsonValue& root, const std::string& path, const JsonValue& v) {
+    JsonValue* at = &root;
+    std::size_t begin = 0;
+    for (;;) {
+        const std::size_t dot = path.find('.', begin);
+        const std::string key = path.substr(begin, dot == std::string::npos ? std::string::npos : dot - begin);
+        if (dot == std::string::npos) {
+            at->set(key, v);
+            return true;
+        }
+        JsonValue* next = nullptr;
+        for (auto& kv : at->object) {
+            if (kv.first == key) next = &kv.second;
+        }
+        if (!next) next = &at->set(key, JsonValue::makeObject());
+        if (!next->isObject()) return false;
+        at = next;
+        begin = dot + 1;
+    }
+}
+
+bool applyConfig(const JsonValue& obj, WorldConfig& cfg, std::string* error) {
+    std::vector<std::pair<std::string, const JsonValue*>> fields;
+    flatten(obj, "", fields);
+
+    for (const auto& kv : fields) {
+        bool found = false, ok = false;
+        forEachField(cfg, [&](const char* name, auto& field) {
+            if (!found && kv.first == name) {
+                found = true;
+                ok = readValue(*kv.second, field);
+            }
+        });
+        if (!found) return fail(error, "unknown config key '" + kv.first + "'");
+        if (!ok) return fail(error, "config key '" + kv.first + "' has the wrong type");
+    }
+
+    if (!(cfg.width > 0.f) || !(cfg.height > 0.f)) return fail(error, "width and height must be positive");
+    if (cfg.solverIterations < 0) return fail(error, "solverIterations can't be negative");
+    if (cfg.periodic && cfg.ccd) return fail(error, "periodic worlds have no swept collision; set ccd to false");
+    if (cfg.rules.slowPopOdds == 0 || cfg.rules.pairPopOdds == 0 || cfg.rules.mergeOdds == 0) {
+        return fail(error, "rule odds must be at least 1");
+    }
+    return true;
+}
+
+// One scenario object, sweep already expanded.
+bool parseOne(const JsonValue& obj, const std::string& name, Scenario& out, std::string* error) {
+    out.name = name;
+    out.sim = obj.get("sim", "bubbles");
+    if (!simConfig(out.sim, out.config)) {
+        return fail(error, "unknown sim '" + out.sim + "' (balls, balls-gravity, bubbles)");
+    }
+
+    for (const auto& kv : obj.object) {
+        const std::string& key = kv.first;
+        const JsonValue& v = kv.second;
+        bool ok = true;
+        if (key == "name" || key == "sim") ok = v.isString();
+        else if (key == "count")  ok = readValue(v, out.count) && out.count >= -1;
+        else if (key == "steps")  ok = readValue(v, out.steps) && out.steps >= 0;
+        else if (key == "dt")     ok = readValue(v, out.dt) && out.dt > 0.f;
+        else if (key == "config") {
+            if (!v.isObject()) return fail(error, "'config' must be an object");
+            if (!applyConfig(v, out.config, error)) return false;
+        }
+        else return fail(error, "unknown key '" + key + "'");
+        if (!ok) return fail(error, "bad value for '" + key + "'");
+    }
+    return true;
+}
+
+// ---- Sweeps ----
+
+struct Axis {
+    std::string path;
+    std::string label;      // last part of the path, for run names
+    std::vector<JsonValue> values;
+};
+
+bool parseAxis(const std::string& path, const JsonValue& v, Axis& axis, std::string* error) {
+    axis.path = path;
+    axis.label = path.substr(path.rfind('.') + 1);
+    if (v.isArray()) {
+        axis.values = v.array;
+    } else if (v.isObject()) {
+        const JsonValue* from = v.find("from");
+        const JsonValue* to = v.find("to");
+        const JsonValue* step = v.find("step");
+        if (!from || !to || !step || !from->isNumber() || !to->isNumber() || !step->isNumber() ||
+            !(step->number > 0.0) || v.object.size() != 3) {
+            return fail(error, "sweep range '" + path + "' needs numbers from, to and step > 0");
+        }
+        // inclusive of `to`, allowing for rounding in the step
+        const double last = to->number + step->number * 1e-6;
+        for (long k = 0; from->number + k * step->number <= last; k++) {
+            if (k >= 1000000) return fail(error, "sweep range '" + path + "' is too long");
+            axis.values.push_back(rounded(from->number + k * step->number, 12));
+        }
+    } else {
+        return fail(error, "sweep '" + path + "' must be an array or a {from, to, step} range");
+    }
+    if (axis.values.empty()) return fail(error, "sweep '" + path + "' has no values");
+    return true;
+}
+
+bool expand(const JsonValue& obj, std::vector<Scenario>& out, std::string* error) {
+    if (!obj.isObject()) return fail(error, "a scenario must be an object");
+
+    JsonValue base = obj;
+    const JsonValue* sweep = obj.find("sweep");
+    if (sweep) {
+        base.object.clear();
+        for (const auto& kv : obj.object) {
+            if (kv.first != "sweep") base.object.push_back(kv);
+        }
+    }
+    const std::string name = base.get("name", base.get("sim", "bubbles").c_str());
+
+    if (!sweep) {
+        Scenario s;
+        if (!parseOne(base, name, s, error)) return fail(error, "scenario '" + name + "': " + *error);
+        out.push_back(s);
+        return true;
+    }
+
+    if (!sweep->isObject()) return fail(error, "scenario '" + name + "': 'sweep' must be an object");
+    std::vector<Axis> axes(sweep->object.size());
+    double runs = 1.0;
+    for (std::size_t a = 0; a < axes.size(); a++) {
+        const auto& kv = sweep->object[a];
+        if (!parseAxis(kv.first, kv.second, axes[a], error)) return fail(error, "scenario '" + name + "': " + *error);
+        runs *= static_cast<double>(axes[a].values.size());
+    }
+    if (runs > 1e7) return fail(error, "scenario '" + name + "': the sweep makes too many runs");
+
+    // every combination, the first axis changing slowest
+    std::vector<std::size_t> at(axes.size(), 0);
+    for (;;) {
+        JsonValue run = base;
+        std::string runName = name;
+        for (std::size_t a = 0; a < axes.size(); a++) {
+            const JsonValue& v = axes[a].values[at[a]];
+            if (!setPath(run, axes[a].path, v)) {
+                return fail(error, "scenario '" + name + "': sweep key '" + axes[a].path + "' doesn't lead into an object");
+            }
+            runName += "/" + axes[a].label + "=" + nameText(v);
+        }
+        Scenario s;
+        if (!parseOne(run, runName, s, error)) return fail(error, "scenario '" + runName + "': " + *error);
+        out.push_back(s);
+
+        std::size_t a = axes.size();
+        while (a > 0 && ++at[a - 1] == axes[a - 1].values.size()) {
+            at[a - 1] = 0;
+            a--;
+        }
+        if (a == 0) break;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseScenarios(const JsonValue& root, std::vector<Scenario>& out, std::string* error) {
+    std::string message;
+    std::vector<Scenario> parsed;
+    if (root.isArray()) {
+        for (const JsonValue& s : root.array) {
+            if (!expand(s, parsed, &message)) return fail(error, message);
+        }
+    } else if (!expand(root, parsed, &message)) {
+        return fail(error, message);
+    }
+
+    // results are matched to runs by name, so names must be unique
+    std::set<std::string> names;
+    for (const Scenario& s : parsed) {
+        if (!names.insert(s.name).second) return fail(error, "two runs are named '" + s.name + "'");
+    }
+    out.insert(out.end(), parsed.begin(), parsed.end());
+    return true;
+}
+
+bool loadScenarios(const std::string& path, std::vector<Scenario>& out, std::string* error) {
+    JsonValue root;
+    std::string message;
+    if (!loadJsonFile(path, root, &message)) return fail(error, path + ": " + message);
+    if (!parseScenarios(root, out, &message)) return fail(error, path + ": " + message);
+    return true;
+}
+
+JsonValue scenarioToJson(const Scenario& s) {
+    JsonValue out = JsonValue::makeObject();
+    out.set("name", s.name);
+    out.set("sim", s.sim);
+    out.set("count", s.count);
+    out.set("steps", s.steps);
+    out.set("dt", toValue(s.dt));
+    out.set("config", configToJson(s.config));
+    return out;
+}
+
+JsonValue configToJson(const WorldConfig& cfg) {
+    JsonValue out = JsonValue::makeObject();
+    WorldConfig c = cfg;
+    forEachField(c, [&](const char* name, auto& field) {
+        setPath(out, name, toValue(field));
+    });
+    return out;
+}
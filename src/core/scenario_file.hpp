@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "world.hpp"
+
+// Runs described in JSON instead of in code, for the windowed sims and for
+// batch sweeps (src/tools/batch.cpp). A file holds one scenario object or
+// an array of them:
+//
+//   {
+//     "name": "merge-odds",           // default: the sim name
+//     "sim": "bubbles",               // balls, balls-gravity, bubbles
+//     "count": 500,                   // bodies; default -1, the sim's usual count
+//     "steps": 2000,                  // default 1000
+//     "dt": 0.01,                     // default 0.01
+//     "config": {                     // WorldConfig fields over the sim's stock config
+//       "width": 1440, "restitutionBall": 0.9, "seed": 7,
+//       "rules": { "mergeOdds": 60 }
+//     },
+//     "sweep": {                      // optional: one run per combination
+//       "config.rules.mergeOdds": [30, 60, 120],
+//       "config.restitutionBall": { "from": 0.5, "to": 1.0, "step": 0.1 },
+//       "config.seed": [1, 2, 3]
+//     }
+//   }
+//
+// Sweep keys are dotted paths into the scenario object, and each swept run
+// is named after its values, "merge-odds/mergeOdds=30/restitutionBall=0.5/
+// seed=1". Keys the loader doesn't know are errors, not ignored, so a typo
+// can't silently run the stock value all night. The thread count, SIMD
+// level and phase timing aren't part of a scenario: they are up to the
+// runner.
+
+struct Scenario {
+    std::string name;
+    std::string sim = "bubbles";
+    WorldConfig config;
+    int count = -1;
+    int steps = 1000;
+    float dt = 0.01f;
+};
+
+// Expands every sweep. Returns false and fills *error (if given) on a
+// malformed file, an unknown key or sim, a bad value or a repeated name.
+bool loadScenarios(const std::string& path, std::vector<Scenario>& out, std::string* error = nullptr);
+bool parseScenarios(const JsonValue& root, std::vector<Scenario>& out, std::string* error = nullptr);
+
+// A scenario the way a file has it (sweep expanded), with every config field.
+JsonValue scenarioToJson(const Scenario& s);
+JsonValue configToJson(const WorldConfig& cfg);
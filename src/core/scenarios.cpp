@@ -0,0 +1,153 @@
+#include "scenarios.hpp"
+
+#include "rng.hpp"
+
+WorldConfig bouncyBallConfig(bool gravity) {
+    float sc = 1;
+    WorldConfig cfg;
+    cfg.width  = 800 * sc;
+    cfg.height = 600 * sc;
+    cfg.restitutionBall = 0.8f; // inelastic (1.0 = elastic)
+    cfg.restitutionWall = 0.8f;
+    cfg.gravity = gravity ? 600.f : 0.f;
+    cfg.bubbleRules = false;
+    cfg.ccd = true;             // fast balls would tunnel otherwise
+    if (gravity) {
+        cfg.solverIterations = 8;   // lets the pile on the floor come to rest
+        cfg.sleeping = true;
+    }
+    return cfg;
+}
+
+WorldConfig bouncyBubbleConfig() {
+    float sc = 1.2f;
+    WorldConfig cfg;
+    cfg.width  = static_cast<float>(static_cast<unsigned int>(1200 * sc));
+    cfg.height = static_cast<float>(static_cast<unsigned int>(900  * sc));
+    cfg.restitutionBall = 0.8f;
+    cfg.restitutionWall = 0.8f;
+    cfg.bubbleRules = true;
+    return cfg;
+}
+
+bool simConfig(const std::string& sim, WorldConfig& out) {
+    if (sim == "balls")              out = bouncyBallConfig(false);
+    else if (sim == "balls-gravity") out = bouncyBallConfig(true);
+    else if (sim == "bubbles")       out = bouncyBubbleConfig();
+    else return false;
+    return true;
+}
+
+// Balls can be very fast (up to ~30000 px/s). Swept collision keeps them
+// from passing through each other, so one step per tick is enough (this
+// used to take 4 substeps).
+StepConfig bouncyBallSteps() {
+    StepConfig steps;
+    steps.stepDt = 1.f / 80.f;
+    steps.substeps = 1;
+    return steps;
+}
+
+// The bubble pop/merge odds are per step, so keep the rate the sim was
+// tuned at (the old 100 fps frame limit).
+StepConfig bouncyBubbleSteps() {
+    StepConfig steps;
+    steps.stepDt = 1.f / 100.f;
+    steps.substeps = 1;
+    return steps;
+}
+
+void spawnBouncyBalls(World& world, int count) {
+    RngSequence rng(world.config().seed, RngStream::Spawn);
+    const unsigned int W = static_cast<unsigned int>(world.config().width);
+    const unsigned int H = static_cast<unsigned int>(world.config().height);
+
+    int n = count >= 0 ? count : rng.below(80) + 20;
+    int radius = 20;
+
+    for (int i = 0; i < n; i++) {
+        int rand_x  = rng.below(W - 2*radius) + radius;
+        int rand_y  = rng.below(H - 2*radius) + radius;
+
+        int rand_vx = (rng.below(200) + 100) * (rng.below(2) ? 1 : -1);
+        int rand_vy = (rng.below(200) + 100) * (rng.below(2) ? 1 : -1);
+
+        Body b;
+        b.color = { static_cast<std::uint8_t>(rng.below(128) + 128),
+                    static_cast<std::uint8_t>(rng.below(128) + 128),
+                    static_cast<std::uint8_t>(rng.below(128) + 128), 255 };
+
+        int r = rng.below(3 - 1 + 1) + 1;
+        b.radius = r * 10.f;
+        b.x = rand_x + b.radius;
+        b.y = rand_y + b.radius;
+
+        r = rng.below(10) + 1;
+        int sign = (rng.below(2) == 0) ? 1 : -1;
+        b.vx = static_cast<float>(sign * r * rand_vx * 10);
+        b.vy = static_cast<float>(sign * r * rand_vy * 10);
+
+        world.addBody(b);
+    }
+}
+
+void spawnBubbles(World& world, int count) {
+    RngSequence rng(world.config().seed, RngStream::Spawn);
+    const unsigned int W = static_cast<unsigned int>(world.config().width);
+    const unsigned int H = static_cast<unsigned int>(world.config().height);
+
+    int n = count >= 0 ? count : rng.below(20) + 100;
+    int radius = 20;
+
+    for (int i = 0; i < n; i++) {
+        int rand_x  = rng.below(W - 2 * radius) + radius;
+        int rand_y  = rng.below(H - 2 * radius) + radius;
+        int rand_vx = (rng.below(200) + 100) * (rng.below(2) ? 1 : -1);
+        int rand_vy = (rng.below(200) + 100) * (rng.below(2) ? 1 : -1);
+
+        Body b;
+        b.radius = static_cast<float>(rng.below(20) + 5);
+        b.x  = rand_x + b.radius;
+        b.y  = rand_y + b.radius;
+        b.vx = static_cast<float>(rand_vx);
+        b.vy = static_cast<float>(rand_vy);
+
+        int style = rng.below(3);
+        int R = 0, G = 0, B = 0, A = 0;
+
+        switch (style) {
+            case 0: {
+                int base = rng.below(50) + 180;
+                R = base;
+                G = base + 10;
+                B = rng.below(20) + (255 - 20 + 1);
+                A = rng.below(40) + 140;
+                break;
+            }
+            case 1: {
+                R = rng.below(60) + 80;
+                G = rng.below(80) + 170;
+                B = 255;
+                A = rng.below(40) + 140;
+                break;
+            }
+            case 2: {
+                R = rng.below(60) + 40;
+                G = rng.below(80) + 80;
+                B = rng.below(55) + 200;
+                A = rng.below(40) + 140;
+                break;
+            }
+        }
+
+        b.color = { static_cast<std::uint8_t>(R), static_cast<std::uint8_t>(G),
+                    static_cast<std::uint8_t>(B), static_cast<std::uint8_t>(A) };
+
+        world.addBody(b);
+    }
+}
+
+void spawnBodies(World& world, int count) {
+    if (world.config().bubbleRules) spawnBubbles(world, count);
+    else                            spawnBouncyBalls(world, count);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "fixed_step.hpp"
+#include "world.hpp"
+
+// Stock setups for the two sims, shared by the windowed and headless runners.
+
+WorldConfig bouncyBallConfig(bool gravity);
+WorldConfig bouncyBubbleConfig();
+
+// The stock config for a sim name (balls, balls-gravity, bubbles); false if
+// there is no such sim.
+bool simConfig(const std::string& sim, WorldConfig& out);
+
+StepConfig bouncyBallSteps();
+StepConfig bouncyBubbleSteps();
+
+// count < 0 picks the sim's usual random count. Spawns draw from the world's
+// seed, so the same seed always gives the same starting layout.
+void spawnBouncyBalls(World& world, int count = -1);
+void spawnBubbles(World& world, int count = -1);
+
+// Spawns what the world's config is for: bubbles with the bubble rules on,
+// balls otherwise.
+void spawnBodies(World& world, int count = -1);
@@ -0,0 +1,954 @@
+#include "slab_world.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "policies.hpp"
+
+namespace {
+
+// ---- Messages ----
+
+bool writeAll(int fd, const void* data, std::size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool readAll(int fd, void* data, std::size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = ::read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// Raw values, sent as one length-prefixed block. Both ends are this
+// machine, so nothing is converted. Reading past the end gives zeros and
+// clears ok().
+class Message {
+public:
+    void clear() {
+        bytes_.clear();
+        at_ = 0;
+        ok_ = true;
+    }
+
+    template <class T>
+    void put(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "values are sent raw");
+        const char* p = reinterpret_cast<const char*>(&v);
+        bytes_.insert(bytes_.end(), p, p + sizeof(T));
+    }
+
+    template <class T>
+    void putVector(const std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "values are sent raw");
+        put<std::uint64_t>(v.size());
+        const char* p = reinterpret_cast<const char*>(v.data());
+        bytes_.insert(bytes_.end(), p, p + v.size() * sizeof(T));
+    }
+
+    template <class T>
+    T get() {
+        T v;
+        std::memset(static_cast<void*>(&v), 0, sizeof(T));
+        if (bytes_.size() - at_ < sizeof(T)) {
+            ok_ = false;
+            return v;
+        }
+        std::memcpy(static_cast<void*>(&v), bytes_.data() + at_, sizeof(T));
+        at_ += sizeof(T);
+        return v;
+    }
+
+    template <class T>
+    void getVector(std::vector<T>& v) {
+        const std::uint64_t n = get<std::uint64_t>();
+        if (n > (bytes_.size() - at_) / sizeof(T)) {
+            ok_ = false;
+            v.clear();
+            return;
+        }
+        v.resize(n);
+        std::memcpy(static_cast<void*>(v.data()), bytes_.data() + at_, n * sizeof(T));
+        at_ += n * sizeof(T);
+    }
+
+    bool ok() const { return ok_; }
+
+    bool send(int fd) const {
+        const std::uint64_t size = bytes_.size();
+        return writeAll(fd, &size, sizeof(size)) && writeAll(fd, bytes_.data(), bytes_.size());
+    }
+
+    bool receive(int fd) {
+        clear();
+        std::uint64_t size = 0;
+        if (!readAll(fd, &size, sizeof(size))) return false;
+        bytes_.resize(size);
+        return readAll(fd, bytes_.data(), size);
+    }
+
+private:
+    std::vector<char> bytes_;
+    std::size_t at_ = 0;
+    bool ok_ = true;
+};
+
+// What the coordinator asks of a worker, in step order. Commands marked
+// "no reply" are followed straight away by the next one.
+enum class Command : std::uint32_t {
+    Begin,          // dt: move, slow pops; reply Bounds
+    Layout,         // grid layout; reply bodies per row
+    Cut,            // slab rows; reply the bodies that go elsewhere
+    Bodies,         // bodies arriving; find contacts (no reply)
+    PairRules,      // updates; pair pops and merges; reply shared rows, merge count
+    Color,          // updates; color contacts; reply halo row, top color, overflow count
+    Solve,          // color, updates; apply it; reply shared bodies it moved
+    Report,         // updates; reply deaths, events, counts
+    Compact,        // body count, index moves, first merge id (no reply)
+    Gather,         // reply every body
+    Quit,
+};
+
+// One body in transit, with its index in World's order and the row of the
+// step's grid it sits in.
+struct Carried {
+    std::uint32_t index;
+    std::int32_t row;
+    float x, y, px, py, vx, vy;
+    float radius, invMass, age, sleepTime;
+    std::uint32_t id;
+    Rgba color;
+    std::uint8_t flags;
+    std::uint8_t alive;
+};
+
+// A shared-row body as one worker left it, for the other worker that holds
+// it. Before the solver only alive and used change, and every copy of a
+// body has the same position and velocity, so applying all of it is safe.
+struct SharedUpdate {
+    std::uint32_t index;
+    std::int32_t row;
+    float x, y, vx, vy;
+    std::uint64_t used;     // solver colors taken by contacts so far
+    std::uint8_t alive;
+};
+
+struct Bounds {
+    std::uint64_t count;
+    float minX, minY, maxX, maxY;
+    float maxRadius;
+};
+
+// A slow pop, placed among the others by the popped body's index.
+struct IndexedEvent {
+    std::uint32_t index;
+    SimEvent event;
+};
+
+// Where compaction moved a body.
+struct Move {
+    std::uint32_t from, to;
+};
+
+Carried carry(const BodyStore& s, std::size_t i, std::uint32_t index, std::int32_t row, bool alive) {
+    Carried c;
+    c.index = index;
+    c.row = row;
+    c.x = s.x[i];
+    c.y = s.y[i];
+    c.px = s.px[i];
+    c.py = s.py[i];
+    c.vx = s.vx[i];
+    c.vy = s.vy[i];
+    c.radius = s.radius[i];
+    c.invMass = s.invMass[i];
+    c.age = s.age[i];
+    c.sleepTime = s.sleepTime[i];
+    c.id = s.id[i];
+    c.color = s.color[i];
+    c.flags = s.flags[i];
+    c.alive = alive ? 1 : 0;
+    return c;
+}
+
+// A merged body as BodyStore::set() would store it.
+Carried carry(const Body& b, std::uint32_t index) {
+    BodyStore one;
+    one.push(b);
+    return carry(one, 0, index, 0, true);
+}
+
+void place(BodyStore& s, std::size_t i, const Carried& c) {
+    s.x[i] = c.x;
+    s.y[i] = c.y;
+    s.px[i] = c.px;
+    s.py[i] = c.py;
+    s.vx[i] = c.vx;
+    s.vy[i] = c.vy;
+    s.radius[i] = c.radius;
+    s.invMass[i] = c.invMass;
+    s.age[i] = c.age;
+    s.sleepTime[i] = c.sleepTime;
+    s.id[i] = c.id;
+    s.color[i] = c.color;
+    s.flags[i] = c.flags;
+}
+
+// Rows [cut[k], cut[k + 1]) of the step's grid are worker k's slab. A
+// worker with a non-empty slab keeps the row below it as its halo.
+struct Slabs {
+    std::vector<std::int32_t> cut;
+
+    int owner(int row) const {
+        return static_cast<int>(std::upper_bound(cut.begin(), cut.end(), row) - cut.begin()) - 1;
+    }
+
+    // The worker keeping row as its halo, or -1.
+    int haloOf(int row) const {
+        if (row <= 0) return -1;
+        const int k = owner(row - 1);
+        return cut[k + 1] == row ? k : -1;
+    }
+};
+
+// ---- Worker ----
+
+// One slab's share of the step, run in a worker process. Between steps the
+// store holds the bodies the worker owns, sorted by index; during a step it
+// holds the halo too, in the same order, which is the order World's grid
+// lists them in within a cell.
+class SlabWorker {
+public:
+    SlabWorker(const WorldConfig& config, std::uint64_t steps, int self)
+        : config_(config), steps_(steps), self_(self), rng_(config.seed), pool_(1) {}
+
+    void add(const BodyStore& s, std::size_t i) {
+        const std::size_t k = size();
+        resize(k + 1);
+        place(s_, k, carry(s, i, static_cast<std::uint32_t>(i), 0, true));
+        index_[k] = static_cast<std::uint32_t>(i);
+    }
+
+    // Serves the coordinator on fd until told to quit; returns the exit code.
+    int serve(int fd);
+
+private:
+    std::size_t size() const { return s_.size(); }
+
+    void resize(std::size_t n) {
+        s_.resize(n);
+        index_.resize(n);
+        row_.resize(n);
+        alive_.resize(n);
+    }
+
+    void moveBody(std::size_t from, std::size_t to) {
+        s_.move(from, to);
+        index_[to] = index_[from];
+        row_[to] = row_[from];
+        alive_[to] = alive_[from];
+    }
+
+    void put(std::size_t i, const Carried& c) {
+        place(s_, i, c);
+        index_[i] = c.index;
+        row_[i] = c.row;
+        alive_[i] = static_cast<char>(c.alive);
+    }
+
+    // Keeps the bodies keep(i) says to, in order.
+    template <class F>
+    void keepOnly(F&& keep) {
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < size(); i++) {
+            if (!keep(i)) continue;
+            if (kept != i) moveBody(i, kept);
+            kept++;
+        }
+        resize(kept);
+    }
+
+    void insert(std::vector<Carried>& batch);
+    std::size_t find(std::uint32_t index) const;
+    bool shared(std::size_t i) const;
+    void applyUpdates(Message& in);
+    void putShared(Message& out, bool haloOnly);
+
+    void begin(Message& in, Message& out);
+    void layout(Message& in, Message& out);
+    void cut(Message& in, Message& out);
+    void bodies(Message& in);
+    void pairRules(Message& in, Message& out);
+    void color(Message& in, Message& out);
+    void solve(Message& in, Message& out);
+    void report(Message& in, Message& out);
+    void compact(Message& in);
+    void kill(std::size_t i);
+
+    WorldConfig config_;
+    std::uint64_t steps_;           // World's stats().steps: the RNG counter
+    int self_;
+    CounterRng rng_;
+    ThreadPool pool_;
+
+    BodyStore s_;
+    std::vector<std::uint32_t> index_;  // per body, in World's order
+    std::vector<std::int32_t> row_;     // per body, of this step's grid
+    std::vector<char> alive_;
+
+    UniformGrid::Layout layout_;
+    Slabs slabs_;
+    int first_ = 0, end_ = 0;           // this worker's rows
+
+    UniformGrid grid_;
+    Narrowphase narrowphase_;
+    ContactSolver solver_;
+    std::vector<Contact> contacts_;
+    std::vector<std::uint64_t> used_;
+    std::vector<char> touched_;
+
+    // this step's results
+    std::vector<std::uint32_t> deaths_;     // indices this worker popped or merged away
+    struct Merged {
+        std::uint32_t slot;
+        Body body;
+    };
+    std::vector<Merged> merged_;
+    std::vector<IndexedEvent> slowPops_;
+    std::vector<SimEvent> events_;
+
+    std::vector<Carried> carried_;
+    std::vector<SharedUpdate> updates_;
+};
+
+int SlabWorker::serve(int fd) {
+    Message in, out;
+    for (;;) {
+        if (!in.receive(fd)) return 1;
+        out.clear();
+        bool reply = true;
+        switch (in.get<Command>()) {
+            case Command::Begin:     begin(in, out); break;
+            case Command::Layout:    layout(in, out); break;
+            case Command::Cut:       cut(in, out); break;
+            case Command::Bodies:    bodies(in); reply = false; break;
+            case Command::PairRules: pairRules(in, out); break;
+            case Command::Color:     color(in, out); break;
+            case Command::Solve:     solve(in, out); break;
+            case Command::Report:    report(in, out); break;
+            case Command::Compact:   compact(in); reply = false; break;
+            case Command::Gather:
+                for (std::size_t i = 0; i < size(); i++) {
+                    carried_.push_back(carry(s_, i, index_[i], 0, true));
+                }
+                out.putVector(carried_);
+                carried_.clear();
+                break;
+            case Command::Quit:      return 0;
+        }
+        if (!in.ok()) return 1;
+        if (reply && !out.send(fd)) return 1;
+    }
+}
+
+// Merges a batch into the store, which stays sorted by index.
+void SlabWorker::insert(std::vector<Carried>& batch) {
+    std::sort(batch.begin(), batch.end(), [](const Carried& a, const Carried& b) { return a.index < b.index; });
+    std::size_t i = size();
+    std::size_t k = batch.size();
+    std::size_t at = i + k;
+    resize(at);
+    while (k > 0) {
+        if (i > 0 && index_[i - 1] > batch[k - 1].index) moveBody(--i, --at);
+        else put(--at, batch[--k]);
+    }
+    batch.clear();
+}
+
+std::size_t SlabWorker::find(std::uint32_t index) const {
+    auto it = std::lower_bound(index_.begin(), index_.end(), index);
+    return it != index_.end() && *it == index ? static_cast<std::size_t>(it - index_.begin()) : size();
+}
+
+// Whether another worker holds body i too: it is in this worker's halo, or
+// in its first row, which is the halo of the worker above.
+bool SlabWorker::shared(std::size_t i) const {
+    return row_[i] == end_ || (row_[i] == first_ && slabs_.haloOf(first_) >= 0);
+}
+
+void SlabWorker::applyUpdates(Message& in) {
+    in.getVector(updates_);
+    for (const SharedUpdate& u : updates_) {
+        const std::size_t i = find(u.index);
+        if (i == size()) continue;
+        s_.x[i] = u.x;
+        s_.y[i] = u.y;
+        s_.vx[i] = u.vx;
+        s_.vy[i] = u.vy;
+        used_[i] |= u.used;
+        alive_[i] = static_cast<char>(alive_[i] && u.alive);
+    }
+}
+
+void SlabWorker::putShared(Message& out, bool haloOnly) {
+    updates_.clear();
+    for (std::size_t i = 0; i < size(); i++) {
+        if (haloOnly ? row_[i] != end_ : !shared(i)) continue;
+        updates_.push_back({ index_[i], row_[i], s_.x[i], s_.y[i], s_.vx[i], s_.vy[i], used_[i],
+                             static_cast<std::uint8_t>(alive_[i] ? 1 : 0) });
+    }
+    out.putVector(updates_);
+}
+
+// ---- Movement + slow pops ----
+// As World::integrate() and World::slowPop(); every body here is owned.
+void SlabWorker::begin(Message& in, Message& out) {
+    const float dt = in.get<float>();
+    const std::size_t n = size();
+    alive_.assign(n, 1);
+    deaths_.clear();
+    merged_.clear();
+    slowPops_.clear();
+    events_.clear();
+
+    IntegrateParams p;
+    p.dt = dt;
+    p.gravity = config_.gravity;
+    p.width = config_.width;
+    p.height = config_.height;
+    p.restitution = config_.restitutionWall;
+    integrateBodies(s_, p, config_.simd);
+
+    if (config_.bubbleRules) {
+        const BubbleRules& rules = config_.rules;
+        for (std::size_t i = 0; i < n; i++) {
+            float speed = std::sqrt(s_.vx[i] * s_.vx[i] + s_.vy[i] * s_.vy[i]);
+            if (s_.age[i] > rules.slowPopAge && speed < rules.slowPopSpeed &&
+                rng_.below(rules.slowPopOdds, RngStream::SlowPop, steps_, s_.id[i]) == 0) {
+                slowPops_.push_back({ index_[i], { EventType::Pop, s_.x[i], s_.y[i], s_.radius[i], s_.color[i] } });
+                kill(i);
+            }
+        }
+    }
+
+    // the grid covers the dead too, as World's does until compaction
+    Bounds b = { n, 0.f, 0.f, 0.f, 0.f, 0.f };
+    if (n > 0) {
+        b.minX = b.maxX = s_.x[0];
+        b.minY = b.maxY = s_.y[0];
+    }
+    for (std::size_t i = 0; i < n; i++) {
+        b.minX = std::min(b.minX, s_.x[i]);
+        b.maxX = std::max(b.maxX, s_.x[i]);
+        b.minY = std::min(b.minY, s_.y[i]);
+        b.maxY = std::max(b.maxY, s_.y[i]);
+        b.maxRadius = std::max(b.maxRadius, s_.radius[i]);
+    }
+    out.put(b);
+}
+
+void SlabWorker::layout(Message& in, Message& out) {
+    layout_ = in.get<UniformGrid::Layout>();
+    std::vector<std::uint32_t> perRow(static_cast<std::size_t>(layout_.rows), 0);
+    for (std::size_t i = 0; i < size(); i++) {
+        row_[i] = layout_.rowOf(s_.y[i]);
+        perRow[row_[i]]++;
+    }
+    out.putVector(perRow);
+}
+
+// Bodies outside this slab go to their owner, and bodies in another
+// worker's halo row to that worker too.
+void SlabWorker::cut(Message& in, Message& out) {
+    in.getVector(slabs_.cut);
+    first_ = slabs_.cut[self_];
+    end_ = slabs_.cut[self_ + 1];
+
+    carried_.clear();
+    keepOnly([&](std::size_t i) {
+        const int owner = slabs_.owner(row_[i]);
+        const int halo = slabs_.haloOf(row_[i]);
+        if (owner != self_ || (halo >= 0 && halo != self_)) {
+            carried_.push_back(carry(s_, i, index_[i], row_[i], alive_[i]));
+        }
+        return owner == self_ || halo == self_;
+    });
+    out.putVector(carried_);
+    carried_.clear();
+}
+
+void SlabWorker::bodies(Message& in) {
+    in.getVector(carried_);
+    insert(carried_);
+
+    const std::size_t n = size();
+    used_.assign(n, 0);
+    touched_.assign(n, 0);
+    if (first_ < end_) {
+        grid_.buildRows(s_.x.data(), s_.y.data(), n, layout_, first_, end_);
+        narrowphase_.find(s_, grid_, pool_, contacts_);
+    } else {
+        contacts_.clear();
+    }
+}
+
+void SlabWorker::kill(std::size_t i) {
+    alive_[i] = 0;
+    deaths_.push_back(index_[i]);
+}
+
+// ---- Pair pops and merges ----
+// As World::applyContactEvents(), over this slab's contacts. The worker
+// above has already been through its own, which come first in World's order.
+void SlabWorker::pairRules(Message& in, Message& out) {
+    applyUpdates(in);
+
+    if (config_.bubbleRules) {
+        const BodyStore& s = s_;
+        const BubbleRules& rules = config_.rules;
+        auto pop = [&](std::uint32_t i) {
+            events_.push_back({ EventType::Pop, s.x[i], s.y[i], s.radius[i], s.color[i] });
+            kill(i);
+        };
+
+        for (const Contact& c : contacts_) {
+            const std::uint32_t i = c.a;
+            const std::uint32_t j = c.b;
+            if (!alive_[i] || !alive_[j]) continue;
+
+            const std::uint32_t idA = s.id[i];
+            const std::uint32_t idB = s.id[j];
+
+            float speedA = std::sqrt(s.vx[i] * s.vx[i] + s.vy[i] * s.vy[i]);
+            float speedB = std::sqrt(s.vx[j] * s.vx[j] + s.vy[j] * s.vy[j]);
+
+            if (s.age[i] > rules.pairPopAge && s.age[j] > rules.pairPopAge &&
+                speedA < rules.pairPopSpeed && speedB < rules.pairPopSpeed &&
+                rng_.below(rules.pairPopOdds, RngStream::PairPop, steps_, idA, idB) == 0) {
+                pop(i);
+                pop(j);
+                continue;
+            }
+
+            bool pairCanMerge = (s.canMerge(i) && s.canMerge(j));
+            if (pairCanMerge && rng_.below(rules.mergeOdds, RngStream::Merge, steps_, idA, idB) == 0) {
+                Body m = AreaMerges::merge(s, i, j);
+                merged_.push_back({ index_[i], m });
+                events_.push_back({ EventType::Merge, m.x, m.y, m.radius, m.color });
+
+                alive_[i] = 0;
+                kill(j);
+            }
+        }
+    }
+
+    putShared(out, false);
+}
+
+// ---- Solver ----
+void SlabWorker::color(Message& in, Message& out) {
+    applyUpdates(in);
+    solver_.colorShare(contacts_, alive_, used_);
+
+    std::int32_t top = -1;
+    for (int c = 0; c < ContactSolver::kOverflow; c++) {
+        if (solver_.colorBegin(c) != solver_.colorEnd(c)) top = c;
+    }
+    putShared(out, true);
+    out.put(top);
+    out.put<std::uint64_t>(solver_.colorEnd(ContactSolver::kOverflow) - solver_.colorBegin(ContactSolver::kOverflow));
+}
+
+void SlabWorker::solve(Message& in, Message& out) {
+    const int color = in.get<std::int32_t>();
+    applyUpdates(in);
+    if (!in.ok() || color < 0 || color > ContactSolver::kOverflow) return;
+    solver_.applyColor(s_, contacts_, color, config_.restitutionBall, pool_);
+
+    // only what this color moved: in the same color the other worker may
+    // have moved other shared bodies
+    updates_.clear();
+    for (const std::uint32_t* k = solver_.colorBegin(color); k != solver_.colorEnd(color); k++) {
+        for (const std::uint32_t i : { contacts_[*k].a, contacts_[*k].b }) {
+            if (touched_[i] || !shared(i)) continue;
+            touched_[i] = 1;
+            updates_.push_back({ index_[i], row_[i], s_.x[i], s_.y[i], s_.vx[i], s_.vy[i], 0, 1 });
+        }
+    }
+    for (const SharedUpdate& u : updates_) touched_[find(u.index)] = 0;
+    out.putVector(updates_);
+}
+
+void SlabWorker::report(Message& in, Message& out) {
+    applyUpdates(in);
+    out.putVector(deaths_);
+    out.putVector(slowPops_);
+    out.putVector(events_);
+    out.put<std::uint64_t>(contacts_.size());
+    out.put<std::uint64_t>(first_ < end_ ? narrowphase_.pairTests() : 0);
+}
+
+// ---- Compaction ----
+// World swap-removes the dead from the highest index down; the coordinator
+// has worked out where that moves each survivor, and sends the moves of
+// the bodies that end up in a new place. Those all come from the top of
+// the old index range, past the new body count.
+void SlabWorker::compact(Message& in) {
+    const std::uint64_t count = in.get<std::uint64_t>();
+    std::vector<Move> moves;
+    in.getVector(moves);
+    std::uint32_t nextId = in.get<std::uint32_t>();
+
+    // the halo goes back to its owner's copy, and merged parents to the
+    // merged body, which the worker that merged them keeps
+    keepOnly([&](std::size_t i) { return alive_[i] && row_[i] != end_; });
+    for (const Merged& m : merged_) {
+        Body b = m.body;
+        b.id = nextId++;
+        carried_.push_back(carry(b, m.slot));
+    }
+    while (size() > 0 && index_[size() - 1] >= count) {
+        carried_.push_back(carry(s_, size() - 1, index_[size() - 1], 0, true));
+        resize(size() - 1);
+    }
+    for (Carried& c : carried_) {
+        if (c.index < count) continue;
+        auto it = std::lower_bound(moves.begin(), moves.end(), c.index,
+                                   [](const Move& m, std::uint32_t from) { return m.from < from; });
+        if (it != moves.end() && it->from == c.index) c.index = it->to;
+    }
+    insert(carried_);
+    steps_++;
+}
+
+int runWorker(int fd, const World& world, int self, int workers) {
+    const BodyStore& s = world.bodies();
+    SlabWorker worker(world.config(), world.stats().steps, self);
+
+    // a first, arbitrary share; the first step sends everything to its slab
+    const std::size_t begin = s.size() * self / workers;
+    const std::size_t end = s.size() * (self + 1) / workers;
+    for (std::size_t i = begin; i < end; i++) worker.add(s, i);
+    return worker.serve(fd);
+}
+
+} // namespace
+
+// ---- Coordinator ----
+
+SlabWorld::~SlabWorld() {
+    stop();
+}
+
+void SlabWorld::stop() {
+    Message quit;
+    quit.put(Command::Quit);
+    for (Link& l : links_) {
+        if (!broken_) quit.send(l.fd);
+        ::close(l.fd);
+        int status = 0;
+        while (::waitpid(l.pid, &status, 0) < 0 && errno == EINTR) {}
+    }
+    links_.clear();
+}
+
+bool SlabWorld::fail(const char* what) {
+    if (!broken_) std::cerr << "SlabWorld: a worker went away (" << what << ")\n";
+    broken_ = true;
+    return false;
+}
+
+bool SlabWorld::start(const World& world, int workers) {
+    const WorldConfig& cfg = world.config();
+    if (cfg.ccd || cfg.solverIterations > 0 || cfg.sleeping || cfg.periodic) {
+        std::cerr << "SlabWorld: swept collision, the iterative solver, sleeping and periodic worlds aren't supported\n";
+        return false;
+    }
+    if (!world.impulseCache().empty()) {
+        std::cerr << "SlabWorld: the world has warm-start impulses from an iterative solver\n";
+        return false;
+    }
+    stop();
+    broken_ = false;
+
+    config_ = cfg;
+    stats_ = world.stats();
+    time_ = world.time();
+    nextId_ = world.nextId();
+    count_ = world.bodies().size();
+    events_.clear();
+
+    workers = std::max(workers, 1);
+    for (int k = 0; k < workers; k++) {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            std::cerr << "SlabWorld: socketpair failed: " << std::strerror(errno) << "\n";
+            stop();
+            return false;
+        }
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            std::cerr << "SlabWorld: fork failed: " << std::strerror(errno) << "\n";
+            ::close(fds[0]);
+            ::close(fds[1]);
+            stop();
+            return false;
+        }
+        if (pid == 0) {
+            // the worker only ever talks to the coordinator; _exit() leaves
+            // the parent's objects and atexit handlers alone
+            ::close(fds[0]);
+            for (const Link& l : links_) ::close(l.fd);
+            ::_exit(runWorker(fds[1], world, k, workers));
+        }
+        ::close(fds[1]);
+        links_.push_back({ pid, fds[0] });
+    }
+    return true;
+}
+
+bool SlabWorld::run(int steps, float dt) {
+    for (int s = 0; s < steps; s++) {
+        if (!step(dt)) return false;
+        events_.clear();
+    }
+    return true;
+}
+
+bool SlabWorld::step(float dt) {
+    if (broken_ || links_.empty()) return fail("not started");
+    const int workers = this->workers();
+    Message msg;
+
+    auto sendAll = [&](auto&& fill) {
+        for (int k = 0; k < workers; k++) {
+            msg.clear();
+            fill(k);
+            if (!msg.send(links_[k].fd)) return false;
+        }
+        return true;
+    };
+    auto receive = [&](int k) {
+        return msg.receive(links_[k].fd);
+    };
+
+    // ---- Movement and slow pops, everywhere at once ----
+    if (!sendAll([&](int) { msg.put(Command::Begin); msg.put(dt); })) return fail("begin");
+    Bounds all = { 0, std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                   std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), 0.f };
+    for (int k = 0; k < workers; k++) {
+        if (!receive(k)) return fail("begin");
+        const Bounds b = msg.get<Bounds>();
+        if (b.count == 0) continue;
+        all.count += b.count;
+        all.minX = std::min(all.minX, b.minX);
+        all.minY = std::min(all.minY, b.minY);
+        all.maxX = std::max(all.maxX, b.maxX);
+        all.maxY = std::max(all.maxY, b.maxY);
+        all.maxRadius = std::max(all.maxRadius, b.maxRadius);
+    }
+
+    // ---- The grid World would build, cut into slabs of about equal size ----
+    UniformGrid::Layout layout;
+    if (all.count > 0) {
+        layout = UniformGrid::layoutFor(all.minX, all.minY, all.maxX, all.maxY, all.maxRadius, all.count);
+    }
+    if (!sendAll([&](int) { msg.put(Command::Layout); msg.put(layout); })) return fail("layout");
+    std::vector<std::uint64_t> perRow(static_cast<std::size_t>(layout.rows), 0);
+    std::vector<std::uint32_t> counts;
+    for (int k = 0; k < workers; k++) {
+        if (!receive(k)) return fail("layout");
+        msg.getVector(counts);
+        for (std::size_t r = 0; r < counts.size() && r < perRow.size(); r++) perRow[r] += counts[r];
+    }
+
+    Slabs slabs;
+    slabs.cut.assign(workers + 1, 0);
+    std::uint64_t below = 0;
+    int row = 0;
+    for (int k = 1; k < workers; k++) {
+        const std::uint64_t target = all.count * k / workers;
+        while (row < layout.rows && 2 * below + perRow[row] <= 2 * target) below += perRow[row++];
+        slabs.cut[k] = row;
+    }
+    slabs.cut[workers] = layout.rows;
+
+    // ---- Migration and halos ----
+    if (!sendAll([&](int) { msg.put(Command::Cut); msg.putVector(slabs.cut); })) return fail("cut");
+    std::vector<std::vector<Carried>> arriving(workers);
+    std::vector<Carried> leaving;
+    for (int k = 0; k < workers; k++) {
+        if (!receive(k)) return fail("cut");
+        msg.getVector(leaving);
+        for (const Carried& c : leaving) {
+            const int owner = slabs.owner(c.row);
+            const int halo = slabs.haloOf(c.row);
+            if (owner != k) arriving[owner].push_back(c);
+            if (halo >= 0 && halo != k) arriving[halo].push_back(c);
+        }
+    }
+    if (!sendAll([&](int k) { msg.put(Command::Bodies); msg.putVector(arriving[k]); })) return fail("bodies");
+
+    // shared-row updates waiting for each worker
+    std::vector<std::vector<SharedUpdate>> pending(workers);
+    std::vector<SharedUpdate> updates;
+    auto route = [&](int from) {
+        msg.getVector(updates);
+        for (const SharedUpdate& u : updates) {
+            const int owner = slabs.owner(u.row);
+            const int halo = slabs.haloOf(u.row);
+            if (owner != from) pending[owner].push_back(u);
+            if (halo >= 0 && halo != from) pending[halo].push_back(u);
+        }
+    };
+    auto ask = [&](int k, Command cmd, std::int32_t color) {
+        msg.clear();
+        msg.put(cmd);
+        if (cmd == Command::Solve) msg.put(color);
+        msg.putVector(pending[k]);
+        pending[k].clear();
+        return msg.send(links_[k].fd);
+    };
+
+    // ---- Pair rules and coloring, slab after slab, in World's contact order ----
+    for (int k = 0; k < workers; k++) {
+        if (!ask(k, Command::PairRules, 0) || !receive(k)) return fail("pair rules");
+        route(k);
+    }
+    std::int32_t topColor = -1;
+    std::uint64_t overflow = 0;
+    for (int k = 0; k < workers; k++) {
+        if (!ask(k, Command::Color, 0) || !receive(k)) return fail("coloring");
+        route(k);
+        topColor = std::max(topColor, msg.get<std::int32_t>());
+        overflow += msg.get<std::uint64_t>();
+    }
+
+    // ---- Solve: a color's contacts share no bodies, so all slabs at once ----
+    for (std::int32_t color = 0; color <= topColor; color++) {
+        for (int k = 0; k < workers; k++) {
+            if (!ask(k, Command::Solve, color)) return fail("solve");
+        }
+        for (int k = 0; k < workers; k++) {
+            if (!receive(k)) return fail("solve");
+            route(k);
+        }
+    }
+    // the last color may share bodies and runs in order
+    for (int k = 0; k < workers && overflow > 0; k++) {
+        if (!ask(k, Command::Solve, ContactSolver::kOverflow) || !receive(k)) return fail("solve");
+        route(k);
+    }
+
+    // ---- Events, in World's order: slow pops by index, then slab by slab ----
+    for (int k = 0; k < workers; k++) {
+        if (!ask(k, Command::Report, 0)) return fail("report");
+    }
+    std::vector<std::uint32_t> dead, deaths;
+    std::vector<IndexedEvent> slowPops, pops;
+    std::vector<SimEvent> pairEvents, events;
+    std::vector<std::uint32_t> firstId(workers);
+    std::uint32_t nextId = nextId_;
+    for (int k = 0; k < workers; k++) {
+        if (!receive(k)) return fail("report");
+        msg.getVector(deaths);
+        msg.getVector(pops);
+        msg.getVector(events);
+        stats_.contacts += msg.get<std::uint64_t>();
+        stats_.pairTests += msg.get<std::uint64_t>();
+        if (!msg.ok()) return fail("report");
+
+        dead.insert(dead.end(), deaths.begin(), deaths.end());
+        slowPops.insert(slowPops.end(), pops.begin(), pops.end());
+        pairEvents.insert(pairEvents.end(), events.begin(), events.end());
+        firstId[k] = nextId;
+        for (const SimEvent& e : events) {
+            if (e.type == EventType::Merge) nextId++;
+        }
+    }
+    std::sort(slowPops.begin(), slowPops.end(),
+              [](const IndexedEvent& a, const IndexedEvent& b) { return a.index < b.index; });
+    for (const IndexedEvent& e : slowPops) events_.push_back(e.event);
+    events_.insert(events_.end(), pairEvents.begin(), pairEvents.end());
+    stats_.merges += nextId - nextId_;
+    stats_.pops += slowPops.size() + (pairEvents.size() - (nextId - nextId_));
+    nextId_ = nextId;
+
+    // ---- Compaction: World's swap-removes, highest index first ----
+    std::sort(dead.begin(), dead.end(), std::greater<std::uint32_t>());
+    std::unordered_map<std::uint32_t, std::uint32_t> cameFrom;     // slot -> index it had before
+    std::size_t live = count_;
+    for (const std::uint32_t d : dead) {
+        const std::uint32_t last = static_cast<std::uint32_t>(live - 1);
+        if (d != last) {
+            auto it = cameFrom.find(last);
+            const std::uint32_t from = it != cameFrom.end() ? it->second : last;
+            if (it != cameFrom.end()) cameFrom.erase(it);
+            cameFrom[d] = from;
+        }
+        live--;
+    }
+    std::vector<Move> moves;
+    for (const auto& kv : cameFrom) moves.push_back({ kv.second, kv.first });
+    std::sort(moves.begin(), moves.end(), [](const Move& a, const Move& b) { return a.from < b.from; });
+
+    if (!sendAll([&](int k) {
+            msg.put(Command::Compact);
+            msg.put<std::uint64_t>(live);
+            msg.putVector(moves);
+            msg.put(firstId[k]);
+        })) {
+        return fail("compact");
+    }
+
+    count_ = live;
+    time_ += dt;
+    stats_.steps++;
+    return true;
+}
+
+bool SlabWorld::gather(World& world) {
+    if (broken_ || links_.empty()) return fail("not started");
+    Message msg;
+    msg.put(Command::Gather);
+    for (const Link& l : links_) {
+        if (!msg.send(l.fd)) return fail("gather");
+    }
+
+    BodyStore bodies;
+    bodies.resize(count_);
+    std::vector<Carried> carried;
+    for (const Link& l : links_) {
+        if (!msg.receive(l.fd)) return fail("gather");
+        msg.getVector(carried);
+        for (const Carried& c : carried) {
+            if (c.index < count_) place(bodies, c.index, c);
+        }
+    }
+    world.restore(config_, std::move(bodies), stats_, time_, nextId_, {});
+    return true;
+}
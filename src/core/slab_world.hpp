@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "world.hpp"
+
+// One World split across worker processes on this machine, for bubble runs
+// that outgrow one process. Each worker owns a slab: a band of rows of the
+// grid World::step() would build, cut again every step so that the slabs
+// hold about as many bodies each. Bodies that move into another slab go to
+// its worker. A worker also keeps copies of the bodies in the row just
+// below its slab (its halo), which is all it needs to find the contacts its
+// own rows report.
+//
+// The result is the single-process World's, bit for bit, whatever the
+// number of workers. Contacts come out in World's grid order, slab after
+// slab, so the parts of a step that depend on that order (pair pops and
+// merges, then coloring the contacts for the solver) run slab after slab,
+// each worker handing the next the state of the row they share. The rest
+// runs on every worker at once: movement, slow pops, the contact search,
+// and the solver, one color at a time with the shared rows brought up to
+// date between colors. Bodies keep the index World would give them, so
+// compaction, and the ids given to merged bodies, come out the same too.
+//
+// The calling process coordinates: workers talk only to it, over a Unix-
+// domain socket pair each, and it forwards migrating bodies, halo copies and
+// shared-row updates to whoever needs them. Each worker steps on one thread.
+// Swept collision, the iterative solver, sleeping and periodic worlds
+// aren't supported.
+class SlabWorld {
+public:
+    SlabWorld() = default;
+    ~SlabWorld();       // stops the workers
+
+    SlabWorld(const SlabWorld&) = delete;
+    SlabWorld& operator=(const SlabWorld&) = delete;
+
+    // Starts `workers` processes and hands them world's state. Returns false,
+    // saying why on stderr, if its config uses something the slabs can't
+    // do or the processes can't be started.
+    bool start(const World& world, int workers);
+
+    // Advances the world by dt. Events are appended to events() until
+    // clearEvents() is called. Returns false, saying why on stderr, if a
+    // worker has gone away; nothing can be stepped after that.
+    bool step(float dt);
+
+    // Batch stepping; events are discarded.
+    bool run(int steps, float dt);
+
+    // Copies the whole state into world (see World::restore), bodies in the
+    // order World would hold them: for snapshots, recording or rendering.
+    bool gather(World& world);
+
+    int workers() const { return static_cast<int>(links_.size()); }
+    const WorldConfig& config() const { return config_; }
+    const WorldStats& stats() const { return stats_; }
+    double time() const { return time_; }
+    std::size_t bodyCount() const { return count_; }
+    const std::vector<SimEvent>& events() const { return events_; }
+    void clearEvents() { events_.clear(); }
+
+private:
+    struct Link {
+        pid_t pid = -1;
+        int fd = -1;
+    };
+
+    void stop();
+    bool fail(const char* what);
+
+    WorldConfig config_;
+    WorldStats stats_;
+    double time_ = 0.0;
+    std::uint32_t nextId_ = 1;
+    std::size_t count_ = 0;
+    std::vector<SimEvent> events_;
+    std::vector<Link> links_;
+    bool broken_ = false;
+};
@@ -0,0 +1,405 @@
+#include "snapshot.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[8] = { 'P', 'H', 'Y', 'S', 'N', 'A', 'P', '\0' };
+constexpr std::uint32_t kVersion = 5;       // 2: solver and sleep state, 3: masses, 4: rules, 5: periodic
+constexpr std::uint32_t kByteOrder = 0x01020304;   // reads back swapped on the other endianness
+constexpr std::uint64_t kAlign = 64;
+constexpr std::uint32_t kFlagCcd = 1;
+constexpr std::uint32_t kFlagWarmStart = 2;
+constexpr std::uint32_t kFlagSleeping = 4;
+constexpr std::uint32_t kFlagPeriodic = 8;
+
+enum Section {
+    SecX, SecY, SecPx, SecPy, SecVx, SecVy, SecRadius, SecInvMass, SecAge, SecSleepTime, SecFlags, SecId,
+    SecColor, SecRings, SecImpulses,
+    SecCount
+};
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t bodyCount;
+    std::uint64_t ringCount;
+    std::uint64_t impulseCount;
+    std::uint64_t fileSize;
+
+    // WorldConfig, minus the per-machine settings (simd, threads, timePhases)
+    float width, height;
+    float restitutionBall, restitutionWall;
+    float gravity;
+    std::uint32_t bubbleRules;
+    // BubbleRules, field by field: its default initializers would make
+    // Header non-trivial to zero
+    float slowPopAge, slowPopSpeed;
+    std::uint32_t slowPopOdds;
+    float pairPopAge, pairPopSpeed;
+    std::uint32_t pairPopOdds;
+    std::uint32_t mergeOdds;
+    std::uint64_t seed;
+
+    // WorldStats and clock; steps doubles as the RNG counter
+    std::uint64_t steps, pops, merges, contacts, pairTests;
+    double time;
+    std::uint32_t nextId;
+    std::uint32_t worldFlags;           // kFlagCcd, kFlagWarmStart, kFlagSleeping, kFlagPeriodic
+    std::uint32_t solverIterations;
+    float restingSpeed, friction;
+    float sleepSpeed, sleepDelay;
+
+    std::uint64_t offset[SecCount];     // byte offset of each section, kAlign aligned
+};
+
+static_assert(std::is_trivially_copyable<Header>::value, "Header is written raw");
+static_assert(sizeof(Rgba) == 4, "Rgba is written raw");
+static_assert(std::is_trivially_copyable<PopRingState>::value, "PopRingState is written raw");
+static_assert(sizeof(CachedImpulse) == 12, "CachedImpulse is written raw, without padding");
+
+std::uint64_t alignUp(std::uint64_t n) {
+    return (n + kAlign - 1) / kAlign * kAlign;
+}
+
+std::size_t elementSize(int section) {
+    switch (section) {
+        case SecFlags: return sizeof(std::uint8_t);
+        case SecId:    return sizeof(std::uint32_t);
+        case SecColor: return sizeof(Rgba);
+        case SecRings: return sizeof(PopRingState);
+        case SecImpulses: return sizeof(CachedImpulse);
+        default:       return sizeof(float);
+    }
+}
+
+std::uint64_t sectionCount(const Header& h, int section) {
+    switch (section) {
+        case SecRings:    return h.ringCount;
+        case SecImpulses: return h.impulseCount;
+        default:          return h.bodyCount;
+    }
+}
+
+Header makeHeader(const World& world, std::size_t ringCount) {
+    const WorldConfig& cfg = world.config();
+    const WorldStats& st = world.stats();
+
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.byteOrder = kByteOrder;
+    h.bodyCount = world.bodies().size();
+    h.ringCount = ringCount;
+    h.impulseCount = world.impulseCache().size();
+
+    h.width = cfg.width;
+    h.height = cfg.height;
+    h.restitutionBall = cfg.restitutionBall;
+    h.restitutionWall = cfg.restitutionWall;
+    h.gravity = cfg.gravity;
+    h.bubbleRules = cfg.bubbleRules ? 1 : 0;
+    h.slowPopAge = cfg.rules.slowPopAge;
+    h.slowPopSpeed = cfg.rules.slowPopSpeed;
+    h.slowPopOdds = cfg.rules.slowPopOdds;
+    h.pairPopAge = cfg.rules.pairPopAge;
+    h.pairPopSpeed = cfg.rules.pairPopSpeed;
+    h.pairPopOdds = cfg.rules.pairPopOdds;
+    h.mergeOdds = cfg.rules.mergeOdds;
+    h.seed = cfg.seed;
+
+    h.steps = st.steps;
+    h.pops = st.pops;
+    h.merges = st.merges;
+    h.contacts = st.contacts;
+    h.pairTests = st.pairTests;
+    h.time = world.time();
+    h.nextId = world.nextId();
+    h.worldFlags = (cfg.ccd ? kFlagCcd : 0) | (cfg.warmStart ? kFlagWarmStart : 0) |
+                   (cfg.sleeping ? kFlagSleeping : 0) | (cfg.periodic ? kFlagPeriodic : 0);
+    h.solverIterations = static_cast<std::uint32_t>(cfg.solverIterations);
+    h.restingSpeed = cfg.restingSpeed;
+    h.friction = cfg.friction;
+    h.sleepSpeed = cfg.sleepSpeed;
+    h.sleepDelay = cfg.sleepDelay;
+
+    std::uint64_t at = alignUp(sizeof(Header));
+    for (int s = 0; s < SecCount; s++) {
+        h.offset[s] = at;
+        at = alignUp(at + sectionCount(h, s) * elementSize(s));
+    }
+    h.fileSize = at;
+    return h;
+}
+
+// Pointer to each section's source data, in Section order.
+void sectionSources(const World& world, const std::vector<PopRingState>& rings,
+                    const void* out[SecCount]) {
+    const BodyStore& b = world.bodies();
+    out[SecX] = b.x.data();
+    out[SecY] = b.y.data();
+    out[SecPx] = b.px.data();
+    out[SecPy] = b.py.data();
+    out[SecVx] = b.vx.data();
+    out[SecVy] = b.vy.data();
+    out[SecRadius] = b.radius.data();
+    out[SecInvMass] = b.invMass.data();
+    out[SecAge] = b.age.data();
+    out[SecSleepTime] = b.sleepTime.data();
+    out[SecFlags] = b.flags.data();
+    out[SecId] = b.id.data();
+    out[SecColor] = b.color.data();
+    out[SecRings] = rings.data();
+    out[SecImpulses] = world.impulseCache().data();
+}
+
+// Lays the whole file out in buffer, reusing its capacity. Gaps between
+// sections are zeroed so the same state always gives the same bytes.
+void encode(std::vector<char>& buffer, const World& world, const std::vector<PopRingState>& rings) {
+    Header h = makeHeader(world, rings.size());
+    buffer.resize(h.fileSize);
+    char* base = buffer.data();
+
+    std::memcpy(base, &h, sizeof(h));
+    std::uint64_t end = sizeof(h);
+
+    const void* src[SecCount];
+    sectionSources(world, rings, src);
+    for (int s = 0; s < SecCount; s++) {
+        std::memset(base + end, 0, h.offset[s] - end);
+        std::size_t bytes = sectionCount(h, s) * elementSize(s);
+        if (bytes > 0) std::memcpy(base + h.offset[s], src[s], bytes);
+        end = h.offset[s] + bytes;
+    }
+    std::memset(base + end, 0, h.fileSize - end);
+}
+
+bool writeFile(const std::string& path, const std::vector<char>& buffer) {
+    std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) {
+        std::cerr << "Failed to open snapshot file " << tmp << "\n";
+        return false;
+    }
+    bool ok = std::fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+    ok = std::fclose(f) == 0 && ok;
+    if (ok) ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        std::cerr << "Failed to write snapshot " << path << "\n";
+        std::remove(tmp.c_str());
+    }
+    return ok;
+}
+
+// Read-only mapping of a whole file, unmapped on destruction.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_ = static_cast<const char*>(p);
+                size_ = static_cast<std::size_t>(st.st_size);
+                ::madvise(p, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// Checks the header against the actual file before any section is read.
+bool validate(const Header& h, std::size_t fileSize, const std::string& path) {
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+        std::cerr << path << " is not a snapshot\n";
+        return false;
+    }
+    if (h.byteOrder != kByteOrder) {
+        std::cerr << path << " was written on a machine with the other byte order\n";
+        return false;
+    }
+    if (h.version != kVersion) {
+        std::cerr << path << " is snapshot version " << h.version
+                  << ", this build reads version " << kVersion << "\n";
+        return false;
+    }
+    if (h.fileSize != fileSize) {
+        std::cerr << path << " is truncated or padded (" << fileSize
+                  << " bytes, header says " << h.fileSize << ")\n";
+        return false;
+    }
+    for (int s = 0; s < SecCount; s++) {
+        // divided rather than multiplied: a corrupt count could wrap around
+        if (h.offset[s] % kAlign != 0 || h.offset[s] < sizeof(Header) || h.offset[s] > fileSize ||
+            sectionCount(h, s) > (fileSize - h.offset[s]) / elementSize(s)) {
+            std::cerr << path << " has a corrupt section table\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Vec>
+void copySection(Vec& dst, const char* base, const Header& h, int section) {
+    dst.resize(sectionCount(h, section));
+    std::size_t bytes = dst.size() * sizeof(typename Vec::value_type);
+    if (bytes > 0) std::memcpy(dst.data(), base + h.offset[section], bytes);
+}
+
+} // namespace
+
+bool saveSnapshot(const std::string& path, const World& world, const std::vector<PopRingState>& rings) {
+    std::vector<char> buffer;
+    encode(buffer, world, rings);
+    return writeFile(path, buffer);
+}
+
+bool loadSnapshot(const std::string& path, World& world, std::vector<PopRingState>* rings) {
+    MappedFile file(path);
+    if (!file.data()) {
+        std::cerr << "Failed to open snapshot " << path << "\n";
+        return false;
+    }
+    if (file.size() < sizeof(Header)) {
+        std::cerr << path << " is too small to be a snapshot\n";
+        return false;
+    }
+
+    Header h;
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (!validate(h, file.size(), path)) return false;
+
+    const char* base = file.data();
+    BodyStore b;
+    copySection(b.x, base, h, SecX);
+    copySection(b.y, base, h, SecY);
+    copySection(b.px, base, h, SecPx);
+    copySection(b.py, base, h, SecPy);
+    copySection(b.vx, base, h, SecVx);
+    copySection(b.vy, base, h, SecVy);
+    copySection(b.radius, base, h, SecRadius);
+    copySection(b.invMass, base, h, SecInvMass);
+    copySection(b.age, base, h, SecAge);
+    copySection(b.sleepTime, base, h, SecSleepTime);
+    copySection(b.flags, base, h, SecFlags);
+    copySection(b.id, base, h, SecId);
+    copySection(b.color, base, h, SecColor);
+    if (rings) copySection(*rings, base, h, SecRings);
+    std::vector<CachedImpulse> impulses;
+    copySection(impulses, base, h, SecImpulses);
+
+    WorldConfig cfg = world.config();
+    cfg.width = h.width;
+    cfg.height = h.height;
+    cfg.restitutionBall = h.restitutionBall;
+    cfg.restitutionWall = h.restitutionWall;
+    cfg.gravity = h.gravity;
+    cfg.bubbleRules = h.bubbleRules != 0;
+    cfg.rules.slowPopAge = h.slowPopAge;
+    cfg.rules.slowPopSpeed = h.slowPopSpeed;
+    cfg.rules.slowPopOdds = h.slowPopOdds;
+    cfg.rules.pairPopAge = h.pairPopAge;
+    cfg.rules.pairPopSpeed = h.pairPopSpeed;
+    cfg.rules.pairPopOdds = h.pairPopOdds;
+    cfg.rules.mergeOdds = h.mergeOdds;
+    cfg.seed = h.seed;
+    cfg.ccd = (h.worldFlags & kFlagCcd) != 0;
+    cfg.warmStart = (h.worldFlags & kFlagWarmStart) != 0;
+    cfg.sleeping = (h.worldFlags & kFlagSleeping) != 0;
+    cfg.periodic = (h.worldFlags & kFlagPeriodic) != 0;
+    cfg.solverIterations = static_cast<int>(h.solverIterations);
+    cfg.restingSpeed = h.restingSpeed;
+    cfg.friction = h.friction;
+    cfg.sleepSpeed = h.sleepSpeed;
+    cfg.sleepDelay = h.sleepDelay;
+
+    WorldStats st;
+    st.steps = h.steps;
+    st.pops = h.pops;
+    st.merges = h.merges;
+    st.contacts = h.contacts;
+    st.pairTests = h.pairTests;
+
+    world.restore(cfg, std::move(b), st, h.time, h.nextId, impulses);
+    return true;
+}
+
+SnapshotWriter::SnapshotWriter() : thread_(&SnapshotWriter::writerLoop, this) {}
+
+SnapshotWriter::~SnapshotWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+bool SnapshotWriter::save(const std::string& path, const World& world,
+                          const std::vector<PopRingState>& rings) {
+    if (busy()) return false;
+
+    // the writer thread only touches buffer_ and path_ while pending_ is set
+    encode(buffer_, world, rings);
+    path_ = path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = true;
+    }
+    wake_.notify_one();
+    return true;
+}
+
+bool SnapshotWriter::busy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+bool SnapshotWriter::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return !pending_; });
+    return lastOk_;
+}
+
+void SnapshotWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return pending_ || stopping_; });
+        if (!pending_) return;   // stopping with nothing left to write
+
+        lock.unlock();
+        bool ok = writeFile(path_, buffer_);
+        lock.lock();
+
+        lastOk_ = ok;
+        pending_ = false;
+        done_.notify_all();
+    }
+}
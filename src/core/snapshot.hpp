@@ -0,0 +1,78 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "world.hpp"
+
+// Binary checkpoints of a whole World: config, clock, stats (the step count
+// is the RNG counter, so the pop/merge rules carry on exactly where they
+// left off), every body array, the solver's warm-start impulses and the
+// renderer's pop rings.
+//
+// The file is a fixed header followed by one raw, 64-byte aligned section
+// per body array, in host byte order. Loading maps the file and copies each
+// section straight into the matching array; nothing is parsed.
+
+// A pop ring as the bubble renderer keeps it, minus SFML.
+struct PopRingState {
+    float x = 0.f, y = 0.f;
+    float baseRadius = 0.f;
+    float age = 0.f;
+    float lifetime = 0.f;
+    Rgba color;
+};
+
+// Writes a snapshot synchronously. Returns false (and says why on stderr)
+// if the file can't be written.
+bool saveSnapshot(const std::string& path, const World& world,
+                  const std::vector<PopRingState>& rings = {});
+
+// Replaces world's state with the snapshot's (see World::restore). rings may
+// be null if the caller has none. Returns false, leaving world untouched,
+// if the file is missing, from another version or truncated.
+bool loadSnapshot(const std::string& path, World& world,
+                  std::vector<PopRingState>* rings = nullptr);
+
+// Saves snapshots on a background thread. save() copies the state into a
+// staging buffer on the calling thread (a memcpy per array) and returns;
+// the disk write happens on the writer thread, into "<path>.tmp" renamed
+// over path when complete, so a crash never leaves half a snapshot behind.
+// The staging buffer is reused, so repeated saves don't allocate.
+class SnapshotWriter {
+public:
+    SnapshotWriter();
+    ~SnapshotWriter();   // finishes a pending write
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    // Returns false without copying anything if the previous save is
+    // still being written.
+    bool save(const std::string& path, const World& world,
+              const std::vector<PopRingState>& rings = {});
+
+    bool busy() const;
+    // Blocks until the pending write (if any) is done; returns whether the
+    // last write succeeded.
+    bool wait();
+
+private:
+    void writerLoop();
+
+    std::vector<char> buffer_;
+    std::string path_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    bool pending_ = false;
+    bool lastOk_ = true;
+    bool stopping_ = false;
+
+    std::thread thread_;   // last, so it starts after everything it uses
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Lock-free ring for exactly one producer thread and one consumer thread.
+// Neither side ever waits or allocates: push() fails when the ring is full
+// and pop() when it is empty. Capacity is rounded up to a power of two.
+template <class T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity = 1024) {
+        std::size_t n = 1;
+        while (n < capacity) n *= 2;
+        items_.resize(n);
+        mask_ = n - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer only.
+    bool push(const T& item) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) return false;
+        items_[head & mask_] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only.
+    bool pop(T& out) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        out = items_[tail & mask_];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const { return items_.size(); }
+
+private:
+    std::vector<T> items_;
+    std::size_t mask_ = 0;
+
+    // on separate cache lines, so the two threads don't keep stealing
+    // each other's line
+    alignas(64) std::atomic<std::size_t> head_{ 0 };    // written by the producer
+    alignas(64) std::atomic<std::size_t> tail_{ 0 };    // written by the consumer
+};
@@ -0,0 +1,72 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+    }
+    for (int i = 1; i < threads; i++) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : workers_) {
+        t.join();
+    }
+}
+
+void ThreadPool::runChunk(int index) {
+    std::size_t parts = static_cast<std::size_t>(size());
+    std::size_t begin = jobSize_ * index / parts;
+    std::size_t end   = jobSize_ * (index + 1) / parts;
+    if (begin < end) job_(jobContext_, begin, end);
+}
+
+void ThreadPool::run(std::size_t n, ChunkFn fn, void* ctx) {
+    if (workers_.empty() || n < 2) {
+        if (n > 0) fn(ctx, 0, n);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = fn;
+        jobContext_ = ctx;
+        jobSize_ = n;
+        pending_ = static_cast<int>(workers_.size());
+        generation_++;
+    }
+    wake_.notify_all();
+
+    runChunk(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&] { return pending_ == 0; });
+    job_ = nullptr;
+}
+
+void ThreadPool::workerLoop(int index) {
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+        }
+
+        runChunk(index);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_--;
+        }
+        done_.notify_one();
+    }
+}
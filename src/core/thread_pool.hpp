@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed-size pool for fork/join loops. The calling thread takes part in
+// every parallelFor, so a pool of size 1 starts no threads at all.
+class ThreadPool {
+public:
+    // threads <= 0 uses every hardware thread.
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    // Splits [0, n) into size() contiguous chunks and calls f(begin, end) on
+    // each, one chunk per thread. Blocks until every chunk is done. f is
+    // called through a plain pointer, never copied, so this does not allocate.
+    template <class F>
+    void parallelFor(std::size_t n, F&& f) {
+        using Fn = std::remove_reference_t<F>;
+        run(n, [](void* ctx, std::size_t begin, std::size_t end) {
+            (*static_cast<Fn*>(ctx))(begin, end);
+        }, const_cast<void*>(static_cast<const void*>(&f)));
+    }
+
+private:
+    using ChunkFn = void (*)(void*, std::size_t, std::size_t);
+
+    void run(std::size_t n, ChunkFn fn, void* ctx);
+    void workerLoop(int index);
+    void runChunk(int index);
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    ChunkFn job_ = nullptr;
+    void* jobContext_ = nullptr;
+    std::size_t jobSize_ = 0;
+    unsigned long generation_ = 0;
+    int pending_ = 0;
+    bool stopping_ = false;
+};
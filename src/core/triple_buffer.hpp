@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free triple buffer for exactly one producer thread and one consumer
+// thread. The producer fills back() and publish()es it whole; the consumer
+// update()s to the newest published value and reads front(). Neither side
+// ever waits: a slow consumer just skips values, and a producer that
+// publishes faster than they are read overwrites the unread one.
+//
+// The three slots are only swapped, never copied, so a T holding vectors
+// keeps its capacity: once every slot has grown to fit, nothing allocates.
+// back() comes back holding an older value, not an empty one.
+template <class T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer only.
+    T& back() { return slots_[back_]; }
+
+    // Producer only: back() becomes the newest value, and back() is now
+    // another slot.
+    void publish() {
+        back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndex;
+    }
+
+    // Consumer only: moves front() to the newest published value. Returns
+    // false, keeping front(), if nothing was published since the last call.
+    bool update() {
+        if (!(middle_.load(std::memory_order_relaxed) & kFresh)) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndex;
+        return true;
+    }
+
+    // Consumer only.
+    const T& front() const { return slots_[front_]; }
+
+private:
+    static const unsigned kIndex = 3;
+    static const unsigned kFresh = 4;   // set on middle_ by publish(), cleared by update()
+
+    T slots_[3];
+
+    // the slot between the two threads; back_ and front_ are each touched
+    // by one thread only, and kept off middle_'s cache line
+    alignas(64) std::atomic<unsigned> middle_{ 1 };
+    alignas(64) unsigned back_ = 0;
+    alignas(64) unsigned front_ = 2;
+};
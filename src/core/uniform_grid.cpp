@@ -0,0 +1,163 @@
+#include "uniform_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void UniformGrid::build(const float* x, const float* y, std::size_t count, float maxRadius) {
+    cellOf.resize(count);
+    items.resize(count);
+    quiet.clear();
+
+    // the cell count below never exceeds maxCells, so after the first few
+    // builds the assign() calls reuse their storage
+    cellStart.reserve(4 * count + 65);
+    cursor.reserve(4 * count + 64);
+
+    wrapWidth_ = wrapHeight_ = 0.f;
+    haloRows = 0;
+    if (count == 0) {
+        cols = rows = 0;
+        cellStart.assign(1, 0);
+        return;
+    }
+
+    float minX = x[0], maxX = x[0];
+    float minY = y[0], maxY = y[0];
+    for (std::size_t i = 1; i < count; i++) {
+        minX = std::min(minX, x[i]);
+        maxX = std::max(maxX, x[i]);
+        minY = std::min(minY, y[i]);
+        maxY = std::max(maxY, y[i]);
+    }
+
+    const Layout layout = layoutFor(minX, minY, maxX, maxY, maxRadius, count);
+    cell = layout.cell;
+    cols = layout.cols;
+    rows = layoutRows = layout.rows;
+    firstRow = 0;
+    originX = layout.originX;
+    originY = layout.originY;
+    invX = invY = 1.f / cell;
+    bin(x, y, count);
+}
+
+UniformGrid::Layout UniformGrid::layoutFor(float minX, float minY, float maxX, float maxY,
+                                           float maxRadius, std::size_t count) {
+    Layout l;
+    l.originX = minX;
+    l.originY = minY;
+    l.cell = std::max(2.f * maxRadius, 1e-3f);
+
+    // Keep the cell count in proportion to the body count; a few huge cells
+    // beat millions of empty ones when bodies are sparse.
+    const double maxCells = 4.0 * static_cast<double>(count) + 64.0;
+    for (;;) {
+        double c = std::floor((maxX - minX) / l.cell) + 1.0;
+        double r = std::floor((maxY - minY) / l.cell) + 1.0;
+        if (c * r <= maxCells) {
+            l.cols = static_cast<int>(c);
+            l.rows = static_cast<int>(r);
+            return l;
+        }
+        l.cell *= 2.f;
+    }
+}
+
+void UniformGrid::buildRows(const float* x, const float* y, std::size_t count, const Layout& layout,
+                            int rowBegin, int rowEnd) {
+    cellOf.resize(count);
+    items.resize(count);
+    quiet.clear();
+    cellStart.reserve(4 * count + 65);
+    cursor.reserve(4 * count + 64);
+
+    wrapWidth_ = wrapHeight_ = 0.f;
+    cell = layout.cell;
+    cols = layout.cols;
+    rows = rowEnd - rowBegin;
+    haloRows = rowEnd < layout.rows ? 1 : 0;
+    firstRow = rowBegin;
+    layoutRows = layout.rows;
+    originX = layout.originX;
+    originY = layout.originY;
+    invX = invY = 1.f / cell;
+    bin(x, y, count);
+}
+
+void UniformGrid::buildPeriodic(const float* x, const float* y, std::size_t count, float maxRadius,
+                                float width, float height) {
+    cellOf.resize(count);
+    items.resize(count);
+    quiet.clear();
+    cellStart.reserve(4 * count + 65);
+    cursor.reserve(4 * count + 64);
+
+    originX = originY = 0.f;
+    haloRows = 0;
+    wrapWidth_ = width;
+    wrapHeight_ = height;
+
+    // whole cells per period, each at least as wide as the largest diameter
+    cell = std::max(2.f * maxRadius, 1e-3f);
+    const double maxCells = 4.0 * static_cast<double>(count) + 64.0;
+    for (;;) {
+        double c = std::max(std::floor(static_cast<double>(width) / cell), 1.0);
+        double r = std::max(std::floor(static_cast<double>(height) / cell), 1.0);
+        if (c < 3.0) c = 1.0;
+        if (r < 3.0) r = 1.0;
+        if (c * r <= maxCells || (c == 1.0 && r == 1.0)) {
+            cols = static_cast<int>(c);
+            rows = static_cast<int>(r);
+            break;
+        }
+        cell *= 2.f;
+    }
+    // stretched to tile the period exactly
+    invX = cols / width;
+    invY = rows / height;
+    cell = std::max(width / cols, height / rows);
+    if (count == 0) {
+        cellStart.assign(static_cast<std::size_t>(cols) * rows + 1, 0);
+        return;
+    }
+    bin(x, y, count);
+}
+
+// Counting sort of bodies into cells. A periodic grid first wraps each
+// center into the period; a grid of some rows of a layout counts rows from
+// its first one.
+void UniformGrid::bin(const float* x, const float* y, std::size_t count) {
+    const int binnedRows = rows + haloRows;
+    cellStart.assign(static_cast<std::size_t>(cols) * binnedRows + 1, 0);
+    for (std::size_t i = 0; i < count; i++) {
+        int cx, cy;
+        if (wrapWidth_ > 0.f) {
+            cx = static_cast<int>(std::floor(x[i] * invX)) % cols;
+            cy = static_cast<int>(std::floor(y[i] * invY)) % rows;
+            if (cx < 0) cx += cols;
+            if (cy < 0) cy += rows;
+        } else {
+            cx = std::min(static_cast<int>((x[i] - originX) * invX), cols - 1);
+            cy = std::min(static_cast<int>((y[i] - originY) * invY), layoutRows - 1) - firstRow;
+            cy = std::min(std::max(cy, 0), binnedRows - 1);
+        }
+        std::uint32_t c = static_cast<std::uint32_t>(cy * cols + cx);
+        cellOf[i] = c;
+        cellStart[c + 1]++;
+    }
+    for (std::size_t c = 1; c < cellStart.size(); c++) {
+        cellStart[c] += cellStart[c - 1];
+    }
+
+    cursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (std::size_t i = 0; i < count; i++) {
+        items[cursor[cellOf[i]]++] = static_cast<std::uint32_t>(i);
+    }
+}
+
+void UniformGrid::markQuiet(const std::uint8_t* flags, std::uint8_t bit) {
+    quiet.assign(cellStart.size() - 1, 1);
+    for (std::size_t i = 0; i < cellOf.size(); i++) {
+        if (!(flags[i] & bit)) quiet[cellOf[i]] = 0;
+    }
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Uniform-grid broadphase. Rebuilt from scratch every step: cells are at least
+// as wide as the largest diameter, so any two overlapping circles sit in the
+// same cell or in one of its 8 neighbours.
+class UniformGrid {
+public:
+    // x/y are body centers. Bounds are taken from the data itself, so bodies
+    // that stray outside the window still get binned.
+    void build(const float* x, const float* y, std::size_t count, float maxRadius);
+
+    // For a periodic world: the grid spans exactly [0, width) x [0, height)
+    // and wraps, so the last column neighbours the first and the last row
+    // the first. Centers outside are binned where they wrap to. A dimension
+    // under three cells wide gets a single cell, so no pair is seen twice.
+    void buildPeriodic(const float* x, const float* y, std::size_t count, float maxRadius,
+                       float width, float height);
+
+    // The cells build() lays out for centers spanning [minX, maxX] x
+    // [minY, maxY], given the largest radius and the body count.
+    struct Layout {
+        float originX = 0.f, originY = 0.f;
+        float cell = 1.f;
+        int cols = 0, rows = 0;
+
+        // The row build() bins a center at y into.
+        int rowOf(float y) const {
+            return std::min(static_cast<int>((y - originY) * (1.f / cell)), rows - 1);
+        }
+    };
+    static Layout layoutFor(float minX, float minY, float maxX, float maxY, float maxRadius,
+                            std::size_t count);
+
+    // Builds rows [rowBegin, rowEnd) of a layout's grid, for one share of a
+    // world split by rows (see slab_world.hpp). Every center must lie in
+    // those rows or in row rowEnd, which is binned too but only as their
+    // neighbour: pairs come out exactly as build() would report them for
+    // the rows, in the same order, with row rowBegin as row 0.
+    void buildRows(const float* x, const float* y, std::size_t count, const Layout& layout,
+                   int rowBegin, int rowEnd);
+
+    // Marks cells whose bodies all have `bit` set in flags (sleeping bodies,
+    // say). Until the next build(), pairs inside a quiet cell and between
+    // two quiet cells are skipped.
+    void markQuiet(const std::uint8_t* flags, std::uint8_t bit);
+
+    // Calls f(i, j) once for every candidate pair, with i < j.
+    template <class F>
+    void forEachPair(F&& f) const {
+        forEachPairInRows(0, rows, f);
+    }
+
+    // Same, limited to pairs whose first cell lies in rows [rowBegin, rowEnd).
+    // Disjoint row ranges visit disjoint pairs, so ranges can be walked in
+    // parallel; walking them in order gives the same sequence as forEachPair.
+    template <class F>
+    void forEachPairInRows(int rowBegin, int rowEnd, F&& f) const {
+        for (int cy = rowBegin; cy < rowEnd; cy++) {
+            for (int cx = 0; cx < cols; cx++) {
+                int c = cy * cols + cx;
+                std::uint32_t begin = cellStart[c];
+                std::uint32_t end   = cellStart[c + 1];
+                if (begin == end) continue;
+                const bool q = !quiet.empty() && quiet[c];
+
+                // pairs inside the cell
+                for (std::uint32_t a = begin; a < end && !q; a++) {
+                    for (std::uint32_t b = a + 1; b < end; b++) {
+                        emit(items[a], items[b], f);
+                    }
+                }
+
+                // half stencil: right, and the three cells of the next row
+                static const int offs[4][2] = { {1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+                for (const auto& o : offs) {
+                    int nx = cx + o[0];
+                    int ny = cy + o[1];
+                    if (nx < 0 || nx >= cols) {
+                        if (wrapWidth_ == 0.f || cols == 1) continue;
+                        nx = nx < 0 ? cols - 1 : 0;
+                    }
+                    if (ny >= rows + haloRows) {
+                        if (wrapHeight_ == 0.f || rows == 1) continue;
+                        ny = 0;
+                    }
+
+                    int nc = ny * cols + nx;
+                    if (q && quiet[nc]) continue;
+                    std::uint32_t nBegin = cellStart[nc];
+                    std::uint32_t nEnd   = cellStart[nc + 1];
+                    for (std::uint32_t a = begin; a < end; a++) {
+                        for (std::uint32_t b = nBegin; b < nEnd; b++) {
+                            emit(items[a], items[b], f);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Cells a rectangle's lookup visits: those overlapping it, padded by
+    // half a cell, so a body binned elsewhere has its center further than
+    // maxRadius from the rectangle.
+    struct CellRange {
+        int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+    };
+
+    CellRange cellsNear(float minX, float minY, float maxX, float maxY) const {
+        CellRange r;
+        if (cols == 0) return r;
+        const float pad = cell * 0.5f;
+        auto index = [](float v, int count) {
+            return static_cast<int>(std::min(std::max(std::floor(v), -1.f), static_cast<float>(count)));
+        };
+        r.x0 = std::max(index((minX - pad - originX) * invX, cols), 0);
+        r.y0 = std::max(index((minY - pad - originY) * invY, rows), 0);
+        r.x1 = std::min(index((maxX + pad - originX) * invX, cols), cols - 1);
+        r.y1 = std::min(index((maxY + pad - originY) * invY, rows), rows - 1);
+        return r;
+    }
+
+    // Calls f(i) for every body binned in the range.
+    template <class F>
+    void forEachIn(const CellRange& r, F&& f) const {
+        for (int cy = r.y0; cy <= r.y1; cy++) {
+            for (int c = cy * cols + r.x0; c <= cy * cols + r.x1; c++) {
+                for (std::uint32_t k = cellStart[c]; k < cellStart[c + 1]; k++) {
+                    f(items[k]);
+                }
+            }
+        }
+    }
+
+    // Whether body i was binned in the range.
+    bool binnedIn(const CellRange& r, std::size_t i) const {
+        const int cx = static_cast<int>(cellOf[i] % cols);
+        const int cy = static_cast<int>(cellOf[i] / cols);
+        return cx >= r.x0 && cx <= r.x1 && cy >= r.y0 && cy <= r.y1;
+    }
+
+    float cellSize() const { return cell; }
+    int   columns()  const { return cols; }
+    int   rowCount() const { return rows; }
+
+    // Period of a wrapping grid, 0 for one built with build().
+    float wrapWidth()  const { return wrapWidth_; }
+    float wrapHeight() const { return wrapHeight_; }
+
+private:
+    template <class F>
+    static void emit(std::uint32_t a, std::uint32_t b, F& f) {
+        if (a < b) f(a, b);
+        else       f(b, a);
+    }
+
+    void bin(const float* x, const float* y, std::size_t count);
+
+    float cell = 1.f;
+    float invX = 1.f, invY = 1.f;           // cells per unit; differ only on a periodic grid
+    float originX = 0.f;
+    float originY = 0.f;
+    int cols = 0;
+    int rows = 0;
+    int haloRows = 0;                       // binned below the last row, see buildRows()
+    int firstRow = 0;                       // of the layout, for buildRows()
+    int layoutRows = 0;
+    float wrapWidth_ = 0.f;
+    float wrapHeight_ = 0.f;
+
+    std::vector<std::uint32_t> cellOf;     // per body
+    std::vector<std::uint32_t> cellStart;  // cols*rows + 1 prefix offsets
+    std::vector<std::uint32_t> items;      // body indices sorted by cell
+    std::vector<std::uint32_t> cursor;     // scatter write positions
+    std::vector<std::uint8_t> quiet;       // per cell, empty unless markQuiet() ran
+};
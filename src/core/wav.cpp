@@ -0,0 +1,145 @@
+#include "wav.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+std::uint16_t read16(const std::uint8_t* p) {
+    return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+std::uint32_t read32(const std::uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+void put16(std::uint8_t* p, std::uint32_t v) {
+    p[0] = static_cast<std::uint8_t>(v);
+    p[1] = static_cast<std::uint8_t>(v >> 8);
+}
+
+void put32(std::uint8_t* p, std::uint32_t v) {
+    put16(p, v);
+    put16(p + 2, v >> 16);
+}
+
+const std::size_t kHeaderBytes = 44;
+
+} // namespace
+
+bool loadWav(const std::string& path, AudioClip& out) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+    std::vector<std::uint8_t> bytes;
+    std::uint8_t buf[65536];
+    std::size_t got;
+    while ((got = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+        bytes.insert(bytes.end(), buf, buf + got);
+    }
+    std::fclose(f);
+
+    if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) != 0 ||
+        std::memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+        std::cerr << path << " is not a WAV file\n";
+        return false;
+    }
+
+    // walk the chunks; fmt comes before data, anything else is skipped
+    unsigned int channels = 0, bits = 0;
+    std::size_t at = 12;
+    while (at + 8 <= bytes.size()) {
+        const std::uint8_t* chunk = bytes.data() + at;
+        const std::size_t size = read32(chunk + 4);
+        const std::size_t body = at + 8;
+        if (body + size > bytes.size() && std::memcmp(chunk, "data", 4) != 0) break;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            if (read16(chunk + 8) != 1) {
+                std::cerr << path << " is not PCM\n";
+                return false;
+            }
+            channels = read16(chunk + 10);
+            out.sampleRate = read32(chunk + 12);
+            bits = read16(chunk + 22);
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (channels == 0 || bits != 16) {
+                std::cerr << path << " is not 16-bit PCM\n";
+                return false;
+            }
+            // a writer that never came back for the size leaves it short or 0
+            const std::size_t avail = std::min(size, bytes.size() - body);
+            const std::size_t frames = avail / (2 * channels);
+            out.samples.resize(frames);
+            const std::uint8_t* p = bytes.data() + body;
+            for (std::size_t i = 0; i < frames; i++) {
+                float sum = 0.f;
+                for (unsigned int c = 0; c < channels; c++, p += 2) {
+                    sum += static_cast<std::int16_t>(read16(p));
+                }
+                out.samples[i] = sum / (32768.f * channels);
+            }
+            return true;
+        }
+        at = body + size + (size & 1);     // chunks are padded to even sizes
+    }
+
+    std::cerr << path << " has no audio data\n";
+    return false;
+}
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+bool WavWriter::open(const std::string& path, unsigned int channels, unsigned int sampleRate) {
+    close();
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+    channels_ = channels;
+    frames_ = 0;
+    failed_ = false;
+
+    std::uint8_t h[kHeaderBytes] = {};
+    std::memcpy(h, "RIFF", 4);
+    std::memcpy(h + 8, "WAVEfmt ", 8);
+    put32(h + 16, 16);
+    put16(h + 20, 1);                           // PCM
+    put16(h + 22, channels);
+    put32(h + 24, sampleRate);
+    put32(h + 28, sampleRate * channels * 2);   // bytes per second
+    put16(h + 32, channels * 2);                // bytes per frame
+    put16(h + 34, 16);
+    std::memcpy(h + 36, "data", 4);
+    // sizes at 4 and 40 are filled in by close()
+    failed_ = std::fwrite(h, 1, sizeof(h), file_) != sizeof(h);
+    return !failed_;
+}
+
+void WavWriter::write(const std::int16_t* samples, std::size_t frames) {
+    if (!file_ || frames == 0) return;
+    const std::size_t n = frames * channels_;
+    if (std::fwrite(samples, sizeof(std::int16_t), n, file_) != n) failed_ = true;
+    frames_ += frames;
+}
+
+bool WavWriter::close() {
+    if (!file_) return !failed_;
+
+    const std::uint32_t dataBytes = static_cast<std::uint32_t>(frames_ * channels_ * 2);
+    std::uint8_t size[4];
+    put32(size, dataBytes + kHeaderBytes - 8);
+    if (std::fseek(file_, 4, SEEK_SET) != 0 || std::fwrite(size, 1, 4, file_) != 4) failed_ = true;
+    put32(size, dataBytes);
+    if (std::fseek(file_, 40, SEEK_SET) != 0 || std::fwrite(size, 1, 4, file_) != 4) failed_ = true;
+
+    if (std::fclose(file_) != 0) failed_ = true;
+    file_ = nullptr;
+    return !failed_;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Just enough WAV for the pop sound: 16-bit PCM in, 16-bit PCM out.
+
+// A sound downmixed to mono, samples in -1..1.
+struct AudioClip {
+    std::vector<float> samples;
+    unsigned int sampleRate = 0;
+};
+
+// Reads a 16-bit PCM WAV file with any number of channels.
+bool loadWav(const std::string& path, AudioClip& out);
+
+// Streams interleaved 16-bit samples to a WAV file. The header's sizes are
+// only known at the end and get filled in by close().
+class WavWriter {
+public:
+    WavWriter() = default;
+    ~WavWriter();   // close()s
+
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    bool open(const std::string& path, unsigned int channels, unsigned int sampleRate);
+    bool isOpen() const { return file_ != nullptr; }
+
+    void write(const std::int16_t* samples, std::size_t frames);
+    bool close();
+
+    std::uint64_t framesWritten() const { return frames_; }
+
+private:
+    std::FILE* file_ = nullptr;
+    unsigned int channels_ = 0;
+    std::uint64_t frames_ = 0;
+    bool failed_ = false;
+};
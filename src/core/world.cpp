@@ -0,0 +1,461 @@
+#include "world.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+
+#include "policies.hpp"
+#include "profiler.hpp"
+
+namespace {
+
+// Labels the step's sections for the profiler, named after the sections of
+// the original bubble loop.
+enum StepSection {
+    SecMovement, SecSlowPop, SecBroadphase, SecNarrowphase, SecPairRules, SecSolve, SecSleep,
+    SecCompact,
+    SecCount
+};
+
+const char* const kSectionNames[SecCount] = {
+    "Movement + walls", "Global slow-pop", "Broadphase", "Narrowphase",
+    "Pair pop + merge", "Contact solve", "Sleeping", "Compaction",
+};
+
+// Adds the time since the previous lap to a phase total (for the benchmark)
+// and to a profiler section. Does nothing, not even read the clock, unless
+// phase timing or the profiler is on.
+class PhaseClock {
+public:
+    PhaseClock(bool timePhases, double* totals)
+        : totals_(timePhases ? totals : nullptr) {
+#ifndef PHYS_NO_PROFILE
+        profile_ = Profiler::get().enabled();
+        if (profile_) {
+            static int ids[SecCount] = { -1 };
+            if (ids[0] < 0) {
+                for (int s = 0; s < SecCount; s++) ids[s] = Profiler::get().section(kSectionNames[s]);
+            }
+            ids_ = ids;
+        }
+#endif
+        if (totals_ || profile_) last_ = std::chrono::steady_clock::now();
+    }
+
+    void lap(Phase p, StepSection section) {
+        if (!totals_ && !profile_) return;
+        auto now = std::chrono::steady_clock::now();
+        if (totals_) totals_[static_cast<int>(p)] += std::chrono::duration<double>(now - last_).count();
+        if (profile_) Profiler::get().record(ids_[section], last_, now);
+        last_ = now;
+    }
+
+private:
+    double* totals_;
+    bool profile_ = false;
+    const int* ids_ = nullptr;
+    std::chrono::steady_clock::time_point last_;
+};
+
+} // namespace
+
+const char* phaseName(Phase p) {
+    switch (p) {
+        case Phase::Integrate:   return "integrate";
+        case Phase::Broadphase:  return "broadphase";
+        case Phase::Narrowphase: return "narrowphase";
+        case Phase::Solve:       return "solve";
+        case Phase::Bookkeeping: return "bookkeeping";
+        case Phase::Count:       break;
+    }
+    return "?";
+}
+
+World::World(const WorldConfig& config)
+    : config_(config), rng_(config.seed), pool_(new ThreadPool(config.threads)) {}
+
+void World::addBody(const Body& b) {
+    Body copy = b;
+    copy.id = nextId_++;
+    bodies_.push(copy);
+    gridCurrent_ = false;
+}
+
+void World::restore(const WorldConfig& config, BodyStore&& bodies, const WorldStats& stats,
+                    double time, std::uint32_t nextId, const std::vector<CachedImpulse>& impulses) {
+    WorldConfig kept = config;
+    kept.simd = config_.simd;
+    kept.threads = config_.threads;
+    kept.timePhases = config_.timePhases;
+
+    config_ = kept;
+    bodies_ = std::move(bodies);
+    stats_ = stats;
+    rng_ = CounterRng(config_.seed);
+    time_ = time;
+    nextId_ = nextId;
+    events_.clear();
+    solver_.restoreCache(impulses);
+    gridCurrent_ = false;
+
+    sleeping_ = 0;
+    for (std::size_t i = 0; i < bodies_.size(); i++) {
+        if (bodies_.asleep(i)) sleeping_++;
+    }
+}
+
+// The pair rules are fixed for a world's life, so the whole step is
+// compiled once per combination and picked here, as integrateBodies() picks
+// its loop.
+void World::step(float dt) {
+    if (config_.bubbleRules) stepWith<BubblePops, AreaMerges>(dt);
+    else                     stepWith<NoPops, NoMerges>(dt);
+}
+
+template <class Pops, class Merges>
+void World::stepWith(float dt) {
+    const std::size_t n = bodies_.size();
+
+    // Worst-case sizes for this step: a body dies at most once and a merge
+    // consumes two. With these reserved, a step only allocates when the body
+    // count grows or contacts outgrow the 4n headroom.
+    alive_.assign(n, 1);
+    dead_.clear();
+    dead_.reserve(n);
+    merged_.clear();
+    merged_.reserve(n / 2 + 1);
+    events_.reserve(events_.size() + n);
+    contacts_.reserve(4 * n);
+
+    PhaseClock clock(config_.timePhases, stats_.phaseSeconds);
+
+    integrate(dt);
+    clock.lap(Phase::Integrate, SecMovement);
+
+    slowPop<Pops>();
+    clock.lap(Phase::Bookkeeping, SecSlowPop);
+
+    // ---- Collision handling ----
+    buildGrid();
+    clock.lap(Phase::Broadphase, SecBroadphase);
+
+    narrowphase_.find(bodies_, grid_, *pool_, contacts_, config_.sleeping);
+    if (config_.ccd && !config_.periodic) {
+        const std::vector<Contact>& hits = sweeper_.hits();
+        contacts_.insert(contacts_.end(), hits.begin(), hits.end());
+        stats_.sweptHits += hits.size();
+    }
+    stats_.contacts += contacts_.size();
+    stats_.pairTests += narrowphase_.pairTests();
+    PROF_COUNT("pair tests", narrowphase_.pairTests());
+    PROF_COUNT("contacts", contacts_.size());
+    clock.lap(Phase::Narrowphase, SecNarrowphase);
+
+    applyContactEvents<Pops, Merges>();
+    if (config_.sleeping) {
+        wakeTouched();
+    }
+    clock.lap(Phase::Bookkeeping, SecPairRules);
+
+    SolverParams solver;
+    solver.restitution = config_.restitutionBall;
+    solver.iterations = config_.solverIterations;
+    solver.warmStart = config_.warmStart;
+    solver.restingSpeed = config_.restingSpeed;
+    solver.friction = config_.friction;
+    if (config_.periodic) {
+        solver.wrapWidth = config_.width;
+        solver.wrapHeight = config_.height;
+    } else {
+        solver.width = config_.width;
+        solver.height = config_.height;
+    }
+    solver_.solve(bodies_, contacts_, alive_, solver, *pool_);
+    clock.lap(Phase::Solve, SecSolve);
+
+    if (config_.sleeping) {
+        updateSleep(dt);
+    }
+    clock.lap(Phase::Bookkeeping, SecSleep);
+
+    compact();
+    clock.lap(Phase::Bookkeeping, SecCompact);
+
+    time_ += dt;
+    stats_.steps++;
+    gridCurrent_ = true;
+}
+
+void World::savePrevious() {
+    bodies_.px.assign(bodies_.x.begin(), bodies_.x.end());
+    bodies_.py.assign(bodies_.y.begin(), bodies_.y.end());
+}
+
+void World::run(int steps, float dt) {
+    for (int s = 0; s < steps; s++) {
+        step(dt);
+        events_.clear();
+    }
+}
+
+// ---- Movement + walls ----
+void World::integrate(float dt) {
+    IntegrateParams p;
+    p.dt = dt;
+    p.gravity = config_.gravity;
+    p.width = config_.width;
+    p.height = config_.height;
+    p.restitution = config_.restitutionWall;
+    p.sleeping = config_.sleeping;
+    p.restingSpeed = config_.solverIterations > 0 ? config_.restingSpeed : 0.f;
+    p.periodic = config_.periodic;
+    if (config_.ccd && !config_.periodic) {
+        sweeper_.integrate(bodies_, p, config_.restitutionBall, config_.simd);
+    } else {
+        integrateBodies(bodies_, p, config_.simd);
+    }
+}
+
+void World::pop(std::size_t i) {
+    events_.push_back({ EventType::Pop, bodies_.x[i], bodies_.y[i], bodies_.radius[i], bodies_.color[i] });
+    kill(i);
+    stats_.pops++;
+}
+
+// ---- Global slow-pop ----
+template <class Pops>
+void World::slowPop() {
+    if constexpr (Pops::enabled) {
+        const BodyStore& s = bodies_;
+        const BubbleRules& rules = config_.rules;
+        for (std::size_t i = 0; i < s.size(); i++) {
+            float speed = std::sqrt(s.vx[i] * s.vx[i] + s.vy[i] * s.vy[i]);
+
+            if (s.age[i] > rules.slowPopAge && speed < rules.slowPopSpeed &&
+                rng_.below(rules.slowPopOdds, RngStream::SlowPop, stats_.steps, s.id[i]) == 0) {
+                pop(i);
+            }
+        }
+    }
+}
+
+void World::buildGrid() {
+    const BodyStore& s = bodies_;
+
+    float maxRadius = 0.f;
+    for (float r : s.radius) {
+        maxRadius = std::max(maxRadius, r);
+    }
+    if (config_.periodic) {
+        grid_.buildPeriodic(s.x.data(), s.y.data(), s.size(), maxRadius, config_.width, config_.height);
+    } else {
+        grid_.build(s.x.data(), s.y.data(), s.size(), maxRadius);
+    }
+    if (config_.sleeping) {
+        grid_.markQuiet(s.flags.data(), BodyAsleep);
+    }
+}
+
+// Pair pops and merges, decided serially in contact order. Bodies that pop
+// or merge are marked dead and their remaining contacts are skipped.
+template <class Pops, class Merges>
+void World::applyContactEvents() {
+    if constexpr (Pops::enabled || Merges::enabled) {
+        const BodyStore& s = bodies_;
+        const BubbleRules& rules = config_.rules;
+
+        for (const Contact& c : contacts_) {
+            const std::uint32_t i = c.a;
+            const std::uint32_t j = c.b;
+            if (!alive_[i] || !alive_[j]) continue;
+
+            // keyed by the pair's ids, so the roll doesn't depend on visit order
+            const std::uint32_t idA = s.id[i];
+            const std::uint32_t idB = s.id[j];
+
+            if constexpr (Pops::enabled) {
+                float speedA = std::sqrt(s.vx[i] * s.vx[i] + s.vy[i] * s.vy[i]);
+                float speedB = std::sqrt(s.vx[j] * s.vx[j] + s.vy[j] * s.vy[j]);
+
+                if (s.age[i] > rules.pairPopAge && s.age[j] > rules.pairPopAge &&
+                    speedA < rules.pairPopSpeed && speedB < rules.pairPopSpeed &&
+                    rng_.below(rules.pairPopOdds, RngStream::PairPop, stats_.steps, idA, idB) == 0) {
+                    pop(i);
+                    pop(j);
+                    continue;
+                }
+            }
+
+            if constexpr (Merges::enabled) {
+                bool pairCanMerge = (s.canMerge(i) && s.canMerge(j));
+                bool doMerge = pairCanMerge &&
+                               rng_.below(rules.mergeOdds, RngStream::Merge, stats_.steps, idA, idB) == 0;
+
+                if (doMerge) {
+                    Body m;
+                    if (config_.periodic) {
+                        // average across the seam, then back into the world
+                        const float W = config_.width, H = config_.height;
+                        Body b = s.get(j);
+                        b.x = s.x[i] + wrapDelta(b.x - s.x[i], W);
+                        b.y = s.y[i] + wrapDelta(b.y - s.y[i], H);
+                        m = Merges::merge(s.get(i), b);
+                        if (m.x < 0.f)      m.x += W;
+                        else if (m.x >= W)  m.x -= W;
+                        if (m.y < 0.f)      m.y += H;
+                        else if (m.y >= H)  m.y -= H;
+                    } else {
+                        m = Merges::merge(s, i, j);
+                    }
+                    merged_.push_back({ i, m });
+                    events_.push_back({ EventType::Merge, m.x, m.y, m.radius, m.color });
+                    stats_.merges++;
+
+                    // i is reused for the merged body at compaction, so only j dies
+                    alive_[i] = 0;
+                    kill(j);
+                }
+            }
+        }
+    }
+}
+
+// ---- Sleeping ----
+// A sleeping body hit by an awake one faster than sleepSpeed wakes up; a
+// pile that gets hit hard wakes one layer of contacts per step. Slower
+// touches leave it asleep, and the iterative solver treats it as immovable.
+// The single-pass solver has no such notion, so there any touch wakes.
+void World::wakeTouched() {
+    BodyStore& s = bodies_;
+    const bool anyTouch = config_.solverIterations == 0;
+    for (const Contact& c : contacts_) {
+        if (s.asleep(c.a) == s.asleep(c.b)) continue;
+        float vn = (s.vx[c.b] - s.vx[c.a]) * c.nx + (s.vy[c.b] - s.vy[c.a]) * c.ny;
+        if (anyTouch || vn < -config_.sleepSpeed) {
+            s.wake(s.asleep(c.a) ? c.a : c.b);
+        }
+    }
+}
+
+// Bodies slower than sleepSpeed build up sleepTime. Awake bodies joined by
+// contacts form islands, and an island sleeps once all its members have been
+// slow for sleepDelay: their velocities are zeroed, and until something wakes
+// them they get no gravity and their contacts with each other are never
+// looked for. A sleeping neighbour is ground, not part of the island.
+void World::updateSleep(float dt) {
+    BodyStore& s = bodies_;
+    const std::uint32_t n = static_cast<std::uint32_t>(s.size());
+    const float slow2 = config_.sleepSpeed * config_.sleepSpeed;
+
+    island_.resize(n);
+    for (std::uint32_t i = 0; i < n; i++) {
+        island_[i] = i;
+        if (s.asleep(i)) continue;
+        float v2 = s.vx[i] * s.vx[i] + s.vy[i] * s.vy[i];
+        s.sleepTime[i] = v2 < slow2 ? s.sleepTime[i] + dt : 0.f;
+    }
+
+    // union-find with path halving; the lower index becomes the root, so
+    // islands come out the same whatever the contact order
+    auto root = [&](std::uint32_t i) {
+        while (island_[i] != i) {
+            island_[i] = island_[island_[i]];
+            i = island_[i];
+        }
+        return i;
+    };
+    for (const Contact& c : contacts_) {
+        if (!alive_[c.a] || !alive_[c.b] || s.asleep(c.a) || s.asleep(c.b)) continue;
+        std::uint32_t ra = root(c.a);
+        std::uint32_t rb = root(c.b);
+        if (ra < rb)      island_[rb] = ra;
+        else if (rb < ra) island_[ra] = rb;
+    }
+
+    islandTime_.assign(n, std::numeric_limits<float>::max());
+    for (std::uint32_t i = 0; i < n; i++) {
+        if (!alive_[i]) continue;
+        std::uint32_t r = root(i);
+        islandTime_[r] = std::min(islandTime_[r], s.sleepTime[i]);
+    }
+
+    sleeping_ = 0;
+    for (std::uint32_t i = 0; i < n; i++) {
+        if (!alive_[i]) continue;
+        if (!s.asleep(i) && islandTime_[root(i)] >= config_.sleepDelay) {
+            s.flags[i] |= BodyAsleep;
+            s.vx[i] = 0.f;
+            s.vy[i] = 0.f;
+        }
+        if (s.asleep(i)) sleeping_++;
+    }
+}
+
+void World::kill(std::size_t i) {
+    alive_[i] = 0;
+    dead_.push_back(static_cast<std::uint32_t>(i));
+}
+
+// Merged bodies are written over their first parent, then the dead are
+// swap-removed from the highest index down (so a swapped-in body is never one
+// still waiting to be removed). Only slots that changed are touched: a step
+// costs O(pops + merges) here, however many bodies there are.
+void World::compact() {
+    for (Merged& m : merged_) {
+        m.body.id = nextId_++;
+        bodies_.set(m.slot, m.body);
+    }
+    std::sort(dead_.begin(), dead_.end(), std::greater<std::uint32_t>());
+    for (std::uint32_t i : dead_) {
+        bodies_.swapRemove(i);
+    }
+}
+
+// Bodies are found where the grid binned them. Only the contact solver
+// moves a body after binning, so bodies in contacts that were binned away
+// from the rectangle are tested on their own. Compaction moved bodies into
+// the slots of the dead, and merges replaced their first parent: those
+// slots (alive_ == 0) no longer hold what the grid binned there and are
+// tested on their own too.
+void World::query(float minX, float minY, float maxX, float maxY, std::vector<std::uint32_t>& out) const {
+    const BodyStore& s = bodies_;
+    const std::size_t n = s.size();
+    auto overlaps = [&](std::uint32_t i) {
+        const float r = s.radius[i];
+        return s.x[i] + r >= minX && s.x[i] - r <= maxX && s.y[i] + r >= minY && s.y[i] - r <= maxY;
+    };
+
+    if (!gridCurrent_) {
+        for (std::uint32_t i = 0; i < n; i++) {
+            if (overlaps(i)) out.push_back(i);
+        }
+        return;
+    }
+
+    const UniformGrid::CellRange cells = grid_.cellsNear(minX, minY, maxX, maxY);
+    grid_.forEachIn(cells, [&](std::uint32_t i) {
+        if (i < n && alive_[i] && overlaps(i)) out.push_back(i);
+    });
+
+    // a body can be in many contacts; each is reported once
+    const std::size_t found = out.size();
+    auto moved = [&](std::uint32_t i) {
+        if (i < n && alive_[i] && !grid_.binnedIn(cells, i) && overlaps(i)) out.push_back(i);
+    };
+    for (const Contact& c : contacts_) {
+        moved(c.a);
+        moved(c.b);
+    }
+    std::sort(out.begin() + found, out.end());
+    out.erase(std::unique(out.begin() + found, out.end()), out.end());
+
+    for (std::uint32_t i : dead_) {
+        if (i < n && overlaps(i)) out.push_back(i);
+    }
+    for (const Merged& m : merged_) {
+        if (m.slot < n && overlaps(m.slot)) out.push_back(m.slot);
+    }
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "body_store.hpp"
+#include "ccd.hpp"
+#include "contacts.hpp"
+#include "kernels.hpp"
+#include "rng.hpp"
+#include "thread_pool.hpp"
+#include "uniform_grid.hpp"
+
+// Headless simulation core shared by the bouncy ball and bubble sims.
+// Positions are circle centers in world units (pixels), velocities are
+// units per second. Nothing in here depends on SFML.
+
+enum class EventType { Pop, Merge };
+
+// Something a renderer may want to react to (pop rings, sounds).
+// Pops carry the popped body, merges carry the newly created one.
+struct SimEvent {
+    EventType type;
+    float x, y;
+    float radius;
+    Rgba color;
+};
+
+// Thresholds and odds of the bubble rules. Odds are per step: a rule fires
+// one step in `odds` while its conditions hold.
+struct BubbleRules {
+    float slowPopAge = 0.5f;            // seconds; old, slow bubbles pop by themselves
+    float slowPopSpeed = 15.f;          // units / s
+    std::uint32_t slowPopOdds = 5;
+    float pairPopAge = 0.7f;            // two old, slow bubbles that touch pop together
+    float pairPopSpeed = 20.f;
+    std::uint32_t pairPopOdds = 6;
+    std::uint32_t mergeOdds = 120;      // touching bubbles that may both merge
+};
+
+struct WorldConfig {
+    float width  = 800.f;
+    float height = 600.f;
+    float restitutionBall = 0.8f;   // 1.0 = elastic
+    float restitutionWall = 0.8f;
+    float gravity = 0.f;            // units / s^2, +y is down
+    bool  bubbleRules = false;      // slow-pop, pair pop and merge
+    BubbleRules rules;
+    SimdLevel simd = bestSimdLevel();
+    int   threads = 0;              // collision threads, 0 = all cores
+    std::uint64_t seed = 1;         // spawning and the pop/merge rules
+    bool  timePhases = false;       // fill WorldStats::phaseSeconds
+    bool  ccd = false;              // swept movement, see ccd.hpp
+    int   solverIterations = 0;     // 0 = single pass, else sequential impulses (contacts.hpp)
+    bool  warmStart = true;         // iterative solver: start from last step's impulses
+    float restingSpeed = 20.f;      // iterative solver: slower impacts, walls included, don't bounce
+    float friction = 0.3f;          // iterative solver: sliding friction, times the normal impulse
+    bool  sleeping = false;         // settled islands drop out until something wakes them
+    float sleepSpeed = 20.f;        // units / s; slower bodies count as settled, faster hits wake
+    float sleepDelay = 0.5f;        // seconds an island must stay settled before it sleeps
+    bool  periodic = false;         // no walls: bodies leaving one side come back on the other (no ccd)
+};
+
+// Parts of a step, for timing.
+enum class Phase {
+    Integrate,      // movement + walls
+    Broadphase,     // grid rebuild
+    Narrowphase,    // contact search
+    Solve,          // impulses + positional correction
+    Bookkeeping,    // slow-pop, pair pops, merges, sleeping, compaction
+    Count
+};
+
+const char* phaseName(Phase p);
+
+struct WorldStats {
+    std::uint64_t steps = 0;
+    std::uint64_t pops = 0;
+    std::uint64_t merges = 0;
+    std::uint64_t contacts = 0;
+    std::uint64_t pairTests = 0;    // candidate pairs the grid produced
+    std::uint64_t sweptHits = 0;    // body-body impacts found by CCD
+    double phaseSeconds[static_cast<int>(Phase::Count)] = {};  // if timePhases
+};
+
+class World {
+public:
+    explicit World(const WorldConfig& config);
+
+    void addBody(const Body& b);
+
+    // Replaces the whole simulation state, for loading snapshots. This
+    // world's SIMD level, thread count and phase timing setting are kept.
+    void restore(const WorldConfig& config, BodyStore&& bodies, const WorldStats& stats,
+                 double time, std::uint32_t nextId, const std::vector<CachedImpulse>& impulses);
+
+    // Advances the simulation by dt seconds. Events produced are appended to
+    // events() until clearEvents() is called.
+    void step(float dt);
+
+    // Copies current centers into the px/py arrays, the "previous" state
+    // renderers interpolate from. FixedTimestep calls this before each step.
+    void savePrevious();
+
+    // Batch stepping for headless runs; events are discarded.
+    void run(int steps, float dt);
+
+    const WorldConfig& config() const { return config_; }
+    const BodyStore& bodies() const { return bodies_; }
+    const std::vector<SimEvent>& events() const { return events_; }
+    const WorldStats& stats() const { return stats_; }
+    const CounterRng& rng() const { return rng_; }
+    double time() const { return time_; }
+    std::uint32_t nextId() const { return nextId_; }
+    std::size_t sleepingCount() const { return sleeping_; }
+
+    // Appends the index of every body overlapping the rectangle, for
+    // renderers that only draw what is on screen. After a step this walks
+    // the step's grid, so it costs about as much as the bodies it finds
+    // (plus the step's pops and merges), however big the world is; before
+    // the first step and after addBody() it scans every body.
+    void query(float minX, float minY, float maxX, float maxY, std::vector<std::uint32_t>& out) const;
+
+    // Contact impulses carried over to warm-start the next step.
+    const std::vector<CachedImpulse>& impulseCache() const { return solver_.cache(); }
+
+    void clearEvents() { events_.clear(); }
+
+private:
+    template <class Pops, class Merges> void stepWith(float dt);
+    void integrate(float dt);
+    template <class Pops> void slowPop();
+    void buildGrid();
+    template <class Pops, class Merges> void applyContactEvents();
+    void wakeTouched();
+    void updateSleep(float dt);
+    void compact();
+    void pop(std::size_t i);
+    void kill(std::size_t i);
+
+    WorldConfig config_;
+    BodyStore bodies_;
+    std::vector<SimEvent> events_;
+    WorldStats stats_;
+    CounterRng rng_;
+    double time_ = 0.0;
+    std::uint32_t nextId_ = 1;
+    std::size_t sleeping_ = 0;
+    bool gridCurrent_ = false;      // grid_ and the step scratch below describe bodies_
+
+    // per-step scratch, kept around to avoid reallocating every step
+    std::vector<char> alive_;
+    std::vector<std::uint32_t> dead_;
+    struct Merged {
+        std::uint32_t slot;     // a parent's index, reused for the merged body
+        Body body;
+    };
+    std::vector<Merged> merged_;
+    std::vector<Contact> contacts_;
+    std::vector<std::uint32_t> island_;     // union-find parent per body
+    std::vector<float> islandTime_;         // per island root: least settled member's sleepTime
+    UniformGrid grid_;
+    Narrowphase narrowphase_;
+    ContactSolver solver_;
+    SweptIntegrator sweeper_;
+    std::unique_ptr<ThreadPool> pool_;
+};
@@ -0,0 +1,848 @@
+#include "world_batch.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    #define PHYS_X86 1
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+    #define PHYS_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+#include "policies.hpp"
+
+namespace {
+
+const std::size_t kLanes = WorldBatch::kLanes;
+
+// One group's arrays and per-lane parameters, as the kernels see them.
+// Every array is [slot * kLanes + lane]; the parameters are [lane].
+struct LaneArrays {
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    float* age;
+    const float* radius;
+    std::size_t slots;          // slots to process
+
+    const float* width;
+    const float* height;
+    const float* wallBounce;    // -restitution
+    const float* gravityDt;     // gravity * dt
+    const std::uint32_t* hasGravity;    // all ones or 0
+    const float* popAge;
+    const float* popSpeed;
+};
+
+// ---- Movement, walls and the slow-pop test ----
+// The same arithmetic as integrateBodies() in the same order, so a lane
+// moves exactly like the World it came from; lanes without gravity don't
+// add a zero. Afterwards flag(i, lanes) is called for every slot where some
+// lane has an old, slow body, the ones World's slow-pop rolls for.
+template <class F>
+void integrateScalar(const LaneArrays& a, float dt, F&& flag) {
+    for (std::size_t i = 0; i < a.slots; i++) {
+        std::uint32_t lanes = 0;
+        for (std::size_t l = 0; l < kLanes; l++) {
+            const std::size_t k = i * kLanes + l;
+            const float r = a.radius[k];
+            a.age[k] += dt;
+            if (a.hasGravity[l]) a.vy[k] += a.gravityDt[l];
+            a.x[k] += a.vx[k] * dt;
+            a.y[k] += a.vy[k] * dt;
+
+            if (a.x[k] < r) {
+                a.x[k] = r;
+                a.vx[k] = a.vx[k] * a.wallBounce[l];
+            }
+            else if (a.x[k] + r > a.width[l]) {
+                a.x[k] = a.width[l] - r;
+                a.vx[k] = a.vx[k] * a.wallBounce[l];
+            }
+
+            if (a.y[k] < r) {
+                a.y[k] = r;
+                a.vy[k] = a.vy[k] * a.wallBounce[l];
+            }
+            else if (a.y[k] + r > a.height[l]) {
+                a.y[k] = a.height[l] - r;
+                a.vy[k] = a.vy[k] * a.wallBounce[l];
+            }
+
+            float speed = std::sqrt(a.vx[k] * a.vx[k] + a.vy[k] * a.vy[k]);
+            if (a.age[k] > a.popAge[l] && speed < a.popSpeed[l]) lanes |= 1u << l;
+        }
+        if (lanes) flag(static_cast<std::uint32_t>(i), lanes);
+    }
+}
+
+// ---- Pair tests ----
+// Tests every slot against every later one in all lanes at once and calls
+// flag(i, j, lanes) for pairs that overlap in some lane. NaN positions in
+// empty slots fail the test by themselves.
+template <class F>
+void touchingScalar(const LaneArrays& a, F&& flag) {
+    for (std::size_t i = 0; i < a.slots; i++) {
+        for (std::size_t j = i + 1; j < a.slots; j++) {
+            std::uint32_t lanes = 0;
+            for (std::size_t l = 0; l < kLanes; l++) {
+                const std::size_t p = i * kLanes + l;
+                const std::size_t q = j * kLanes + l;
+                float dx = a.x[q] - a.x[p];
+                float dy = a.y[q] - a.y[p];
+                float minDist = a.radius[p] + a.radius[q];
+                if (dx * dx + dy * dy < minDist * minDist) lanes |= 1u << l;
+            }
+            if (lanes) flag(static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j), lanes);
+        }
+    }
+}
+
+#if PHYS_X86
+
+// 8 lanes are two registers here: h = 0 and h = 4
+template <class F>
+void integrateSse2(const LaneArrays& a, float dt, F&& flag) {
+    const __m128 vdt = _mm_set1_ps(dt);
+
+    auto select = [](__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    };
+
+    auto axis = [&](__m128& pos, __m128& vel, __m128 r, __m128 limit, __m128 ne) {
+        __m128 lo = _mm_cmplt_ps(pos, r);
+        __m128 hi = _mm_andnot_ps(lo, _mm_cmpgt_ps(_mm_add_ps(pos, r), limit));
+        pos = select(lo, r, pos);
+        pos = select(hi, _mm_sub_ps(limit, r), pos);
+        vel = select(_mm_or_ps(lo, hi), _mm_mul_ps(vel, ne), vel);
+    };
+
+    for (std::size_t i = 0; i < a.slots; i++) {
+        std::uint32_t lanes = 0;
+        for (std::size_t h = 0; h < kLanes; h += 4) {
+            const std::size_t k = i * kLanes + h;
+            __m128 x  = _mm_load_ps(&a.x[k]);
+            __m128 y  = _mm_load_ps(&a.y[k]);
+            __m128 vx = _mm_load_ps(&a.vx[k]);
+            __m128 vy = _mm_load_ps(&a.vy[k]);
+            __m128 r  = _mm_load_ps(&a.radius[k]);
+            __m128 age = _mm_add_ps(_mm_load_ps(&a.age[k]), vdt);
+            _mm_store_ps(&a.age[k], age);
+
+            __m128 g = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(&a.hasGravity[h])));
+            vy = select(g, _mm_add_ps(vy, _mm_load_ps(&a.gravityDt[h])), vy);
+            x = _mm_add_ps(x, _mm_mul_ps(vx, vdt));
+            y = _mm_add_ps(y, _mm_mul_ps(vy, vdt));
+
+            __m128 ne = _mm_load_ps(&a.wallBounce[h]);
+            axis(x, vx, r, _mm_load_ps(&a.width[h]), ne);
+            axis(y, vy, r, _mm_load_ps(&a.height[h]), ne);
+
+            _mm_store_ps(&a.x[k], x);
+            _mm_store_ps(&a.y[k], y);
+            _mm_store_ps(&a.vx[k], vx);
+            _mm_store_ps(&a.vy[k], vy);
+
+            __m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+            __m128 slow = _mm_and_ps(_mm_cmpgt_ps(age, _mm_load_ps(&a.popAge[h])),
+                                     _mm_cmplt_ps(speed, _mm_load_ps(&a.popSpeed[h])));
+            lanes |= static_cast<std::uint32_t>(_mm_movemask_ps(slow)) << h;
+        }
+        if (lanes) flag(static_cast<std::uint32_t>(i), lanes);
+    }
+}
+
+template <class F>
+void touchingSse2(const LaneArrays& a, F&& flag) {
+    for (std::size_t i = 0; i < a.slots; i++) {
+        const float* xi = &a.x[i * kLanes];
+        const float* yi = &a.y[i * kLanes];
+        const float* ri = &a.radius[i * kLanes];
+        const __m128 x0 = _mm_load_ps(xi), x1 = _mm_load_ps(xi + 4);
+        const __m128 y0 = _mm_load_ps(yi), y1 = _mm_load_ps(yi + 4);
+        const __m128 r0 = _mm_load_ps(ri), r1 = _mm_load_ps(ri + 4);
+
+        for (std::size_t j = i + 1; j < a.slots; j++) {
+            const std::size_t q = j * kLanes;
+            __m128 dx0 = _mm_sub_ps(_mm_load_ps(&a.x[q]), x0);
+            __m128 dy0 = _mm_sub_ps(_mm_load_ps(&a.y[q]), y0);
+            __m128 m0  = _mm_add_ps(r0, _mm_load_ps(&a.radius[q]));
+            __m128 dx1 = _mm_sub_ps(_mm_load_ps(&a.x[q + 4]), x1);
+            __m128 dy1 = _mm_sub_ps(_mm_load_ps(&a.y[q + 4]), y1);
+            __m128 m1  = _mm_add_ps(r1, _mm_load_ps(&a.radius[q + 4]));
+
+            __m128 hit0 = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(dx0, dx0), _mm_mul_ps(dy0, dy0)), _mm_mul_ps(m0, m0));
+            __m128 hit1 = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(dx1, dx1), _mm_mul_ps(dy1, dy1)), _mm_mul_ps(m1, m1));
+            int lanes = _mm_movemask_ps(hit0) | (_mm_movemask_ps(hit1) << 4);
+            if (lanes) flag(static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j), static_cast<std::uint32_t>(lanes));
+        }
+    }
+}
+
+template <class F>
+__attribute__((target("avx2")))
+void integrateAvx2(const LaneArrays& a, float dt, F&& flag) {
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 W  = _mm256_load_ps(a.width);
+    const __m256 H  = _mm256_load_ps(a.height);
+    const __m256 ne = _mm256_load_ps(a.wallBounce);
+    const __m256 gdt = _mm256_load_ps(a.gravityDt);
+    const __m256 hasG = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(a.hasGravity)));
+    const __m256 popAge = _mm256_load_ps(a.popAge);
+    const __m256 popSpeed = _mm256_load_ps(a.popSpeed);
+
+    for (std::size_t i = 0; i < a.slots; i++) {
+        const std::size_t k = i * kLanes;
+        __m256 x  = _mm256_load_ps(&a.x[k]);
+        __m256 y  = _mm256_load_ps(&a.y[k]);
+        __m256 vx = _mm256_load_ps(&a.vx[k]);
+        __m256 vy = _mm256_load_ps(&a.vy[k]);
+        __m256 r  = _mm256_load_ps(&a.radius[k]);
+        __m256 age = _mm256_add_ps(_mm256_load_ps(&a.age[k]), vdt);
+        _mm256_store_ps(&a.age[k], age);
+
+        // (no lambda here: it wouldn't inherit the avx2 target)
+        vy = _mm256_blendv_ps(vy, _mm256_add_ps(vy, gdt), hasG);
+        x = _mm256_add_ps(x, _mm256_mul_ps(vx, vdt));
+        y = _mm256_add_ps(y, _mm256_mul_ps(vy, vdt));
+
+        __m256 loX = _mm256_cmp_ps(x, r, _CMP_LT_OQ);
+        __m256 hiX = _mm256_andnot_ps(loX, _mm256_cmp_ps(_mm256_add_ps(x, r), W, _CMP_GT_OQ));
+        x  = _mm256_blendv_ps(x, r, loX);
+        x  = _mm256_blendv_ps(x, _mm256_sub_ps(W, r), hiX);
+        vx = _mm256_blendv_ps(vx, _mm256_mul_ps(vx, ne), _mm256_or_ps(loX, hiX));
+
+        __m256 loY = _mm256_cmp_ps(y, r, _CMP_LT_OQ);
+        __m256 hiY = _mm256_andnot_ps(loY, _mm256_cmp_ps(_mm256_add_ps(y, r), H, _CMP_GT_OQ));
+        y  = _mm256_blendv_ps(y, r, loY);
+        y  = _mm256_blendv_ps(y, _mm256_sub_ps(H, r), hiY);
+        vy = _mm256_blendv_ps(vy, _mm256_mul_ps(vy, ne), _mm256_or_ps(loY, hiY));
+
+        _mm256_store_ps(&a.x[k], x);
+        _mm256_store_ps(&a.y[k], y);
+        _mm256_store_ps(&a.vx[k], vx);
+        _mm256_store_ps(&a.vy[k], vy);
+
+        __m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)));
+        __m256 slow = _mm256_and_ps(_mm256_cmp_ps(age, popAge, _CMP_GT_OQ),
+                                    _mm256_cmp_ps(speed, popSpeed, _CMP_LT_OQ));
+        int lanes = _mm256_movemask_ps(slow);
+        if (lanes) flag(static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(lanes));
+    }
+}
+
+template <class F>
+__attribute__((target("avx2")))
+void touchingAvx2(const LaneArrays& a, F&& flag) {
+    for (std::size_t i = 0; i < a.slots; i++) {
+        const __m256 xi = _mm256_load_ps(&a.x[i * kLanes]);
+        const __m256 yi = _mm256_load_ps(&a.y[i * kLanes]);
+        const __m256 ri = _mm256_load_ps(&a.radius[i * kLanes]);
+
+        for (std::size_t j = i + 1; j < a.slots; j++) {
+            const std::size_t q = j * kLanes;
+            __m256 dx = _mm256_sub_ps(_mm256_load_ps(&a.x[q]), xi);
+            __m256 dy = _mm256_sub_ps(_mm256_load_ps(&a.y[q]), yi);
+            __m256 m  = _mm256_add_ps(ri, _mm256_load_ps(&a.radius[q]));
+            __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            int lanes = _mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(m, m), _CMP_LT_OQ));
+            if (lanes) flag(static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j), static_cast<std::uint32_t>(lanes));
+        }
+    }
+}
+
+#endif // PHYS_X86
+
+#if PHYS_NEON
+
+// one bit per lane, like _mm_movemask_ps
+std::uint32_t laneBits(uint32x4_t mask) {
+    const std::uint32_t bitValues[4] = { 1, 2, 4, 8 };
+    uint32x4_t bits = vandq_u32(mask, vld1q_u32(bitValues));
+    uint32x2_t half = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+    return vget_lane_u32(half, 0) | vget_lane_u32(half, 1);
+}
+
+template <class F>
+void integrateNeon(const LaneArrays& a, float dt, F&& flag) {
+    const float32x4_t vdt = vdupq_n_f32(dt);
+
+    auto axis = [&](float32x4_t& pos, float32x4_t& vel, float32x4_t r, float32x4_t limit, float32x4_t ne) {
+        uint32x4_t lo = vcltq_f32(pos, r);
+        uint32x4_t hi = vbicq_u32(vcgtq_f32(vaddq_f32(pos, r), limit), lo);
+        pos = vbslq_f32(lo, r, pos);
+        pos = vbslq_f32(hi, vsubq_f32(limit, r), pos);
+        vel = vbslq_f32(vorrq_u32(lo, hi), vmulq_f32(vel, ne), vel);
+    };
+
+    for (std::size_t i = 0; i < a.slots; i++) {
+        std::uint32_t lanes = 0;
+        for (std::size_t h = 0; h < kLanes; h += 4) {
+            const std::size_t k = i * kLanes + h;
+            float32x4_t x  = vld1q_f32(&a.x[k]);
+            float32x4_t y  = vld1q_f32(&a.y[k]);
+            float32x4_t vx = vld1q_f32(&a.vx[k]);
+            float32x4_t vy = vld1q_f32(&a.vy[k]);
+            float32x4_t r  = vld1q_f32(&a.radius[k]);
+            float32x4_t age = vaddq_f32(vld1q_f32(&a.age[k]), vdt);
+            vst1q_f32(&a.age[k], age);
+
+            uint32x4_t g = vld1q_u32(&a.hasGravity[h]);
+            vy = vbslq_f32(g, vaddq_f32(vy, vld1q_f32(&a.gravityDt[h])), vy);
+            x = vaddq_f32(x, vmulq_f32(vx, vdt));
+            y = vaddq_f32(y, vmulq_f32(vy, vdt));
+
+            float32x4_t ne = vld1q_f32(&a.wallBounce[h]);
+            axis(x, vx, r, vld1q_f32(&a.width[h]), ne);
+            axis(y, vy, r, vld1q_f32(&a.height[h]), ne);
+
+            vst1q_f32(&a.x[k], x);
+            vst1q_f32(&a.y[k], y);
+            vst1q_f32(&a.vx[k], vx);
+            vst1q_f32(&a.vy[k], vy);
+
+            float32x4_t speed = vsqrtq_f32(vaddq_f32(vmulq_f32(vx, vx), vmulq_f32(vy, vy)));
+            uint32x4_t slow = vandq_u32(vcgtq_f32(age, vld1q_f32(&a.popAge[h])),
+                                        vcltq_f32(speed, vld1q_f32(&a.popSpeed[h])));
+            lanes |= laneBits(slow) << h;
+        }
+        if (lanes) flag(static_cast<std::uint32_t>(i), lanes);
+    }
+}
+
+template <class F>
+void touchingNeon(const LaneArrays& a, F&& flag) {
+    for (std::size_t i = 0; i < a.slots; i++) {
+        const float* xi = &a.x[i * kLanes];
+        const float* yi = &a.y[i * kLanes];
+        const float* ri = &a.radius[i * kLanes];
+        const float32x4_t x0 = vld1q_f32(xi), x1 = vld1q_f32(xi + 4);
+        const float32x4_t y0 = vld1q_f32(yi), y1 = vld1q_f32(yi + 4);
+        const float32x4_t r0 = vld1q_f32(ri), r1 = vld1q_f32(ri + 4);
+
+        for (std::size_t j = i + 1; j < a.slots; j++) {
+            const std::size_t q = j * kLanes;
+            float32x4_t dx0 = vsubq_f32(vld1q_f32(&a.x[q]), x0);
+            float32x4_t dy0 = vsubq_f32(vld1q_f32(&a.y[q]), y0);
+            float32x4_t m0  = vaddq_f32(r0, vld1q_f32(&a.radius[q]));
+            float32x4_t dx1 = vsubq_f32(vld1q_f32(&a.x[q + 4]), x1);
+            float32x4_t dy1 = vsubq_f32(vld1q_f32(&a.y[q + 4]), y1);
+            float32x4_t m1  = vaddq_f32(r1, vld1q_f32(&a.radius[q + 4]));
+
+            // vmulq + vaddq, not vmlaq: a fused multiply-add would round differently
+            uint32x4_t hit0 = vcltq_f32(vaddq_f32(vmulq_f32(dx0, dx0), vmulq_f32(dy0, dy0)), vmulq_f32(m0, m0));
+            uint32x4_t hit1 = vcltq_f32(vaddq_f32(vmulq_f32(dx1, dx1), vmulq_f32(dy1, dy1)), vmulq_f32(m1, m1));
+            std::uint32_t lanes = laneBits(hit0) | (laneBits(hit1) << 4);
+            if (lanes) flag(static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j), lanes);
+        }
+    }
+}
+
+#endif // PHYS_NEON
+
+} // namespace
+
+// ---- Storage ----
+
+void WorldBatch::Group::grow(std::size_t newSlots) {
+    const std::size_t n = newSlots * kLanes;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    x.resize(n, nan);
+    y.resize(n, nan);
+    vx.resize(n, nan);
+    vy.resize(n, nan);
+    radius.resize(n, 0.f);
+    invMass.resize(n, 0.f);
+    age.resize(n, 0.f);
+    flags.resize(n, 0);
+    id.resize(n, 0);
+    color.resize(n);
+    slots = newSlots;
+    slowPops.reserve(slots);
+}
+
+Body WorldBatch::bodyAt(const Group& grp, std::size_t lane, std::size_t i) const {
+    const std::size_t k = grp.at(i, lane);
+    Body b;
+    b.x = grp.x[k];
+    b.y = grp.y[k];
+    b.vx = grp.vx[k];
+    b.vy = grp.vy[k];
+    b.radius = grp.radius[k];
+    b.age = grp.age[k];
+    b.canMerge = grp.flags[k] & BodyCanMerge;
+    b.id = grp.id[k];
+    b.color = grp.color[k];
+    return b;
+}
+
+// As BodyStore::set().
+void WorldBatch::setBody(Group& grp, std::size_t lane, std::size_t i, const Body& b) {
+    const std::size_t k = grp.at(i, lane);
+    grp.x[k] = b.x;
+    grp.y[k] = b.y;
+    grp.vx[k] = b.vx;
+    grp.vy[k] = b.vy;
+    grp.radius[k] = b.radius;
+    grp.invMass[k] = 1.f / massOf(b.radius);
+    grp.age[k] = b.age;
+    grp.flags[k] = b.canMerge ? BodyCanMerge : 0;
+    grp.id[k] = b.id;
+    grp.color[k] = b.color;
+}
+
+WorldBatch::WorldBatch(int threads, SimdLevel simd)
+    : simd_(simd), pool_(new ThreadPool(threads)) {}
+
+bool WorldBatch::add(const World& world) {
+    const WorldConfig& cfg = world.config();
+    if (cfg.ccd || cfg.solverIterations > 0 || cfg.sleeping || cfg.periodic) {
+        std::cerr << "WorldBatch: swept collision, the iterative solver, sleeping and periodic worlds aren't supported\n";
+        return false;
+    }
+
+    if (groups_.empty() || groups_.back().lanes == kLanes) groups_.emplace_back();
+    Group& grp = groups_.back();
+    const std::size_t lane = grp.lanes++;
+
+    const BodyStore& s = world.bodies();
+    const std::size_t n = s.size();
+    if (n > grp.slots) grp.grow(n);
+    for (std::size_t i = 0; i < n; i++) {
+        const std::size_t k = grp.at(i, lane);
+        grp.x[k] = s.x[i];
+        grp.y[k] = s.y[i];
+        grp.vx[k] = s.vx[i];
+        grp.vy[k] = s.vy[i];
+        grp.radius[k] = s.radius[i];
+        grp.invMass[k] = s.invMass[i];
+        grp.age[k] = s.age[i];
+        grp.flags[k] = s.flags[i];
+        grp.id[k] = s.id[i];
+        grp.color[k] = s.color[i];
+    }
+    grp.count[lane] = static_cast<std::uint32_t>(n);
+    grp.used = std::max(grp.used, n);
+
+    grp.width[lane] = cfg.width;
+    grp.height[lane] = cfg.height;
+    grp.wallBounce[lane] = -cfg.restitutionWall;
+    grp.gravity[lane] = cfg.gravity;
+    grp.popAge[lane] = cfg.bubbleRules ? cfg.rules.slowPopAge : std::numeric_limits<float>::infinity();
+    grp.popSpeed[lane] = cfg.rules.slowPopSpeed;
+
+    members_.emplace_back();
+    Member& m = members_.back();
+    m.config = cfg;
+    m.stats = world.stats();
+    m.rng = world.rng();
+    m.time = world.time();
+    m.nextId = world.nextId();
+
+    // worst cases, as World::step() reserves them
+    m.alive.reserve(n);
+    m.dead.reserve(n);
+    m.merged.reserve(n / 2 + 1);
+    m.events.reserve(n);
+    m.found.reserve(4 * n);
+    m.contacts.reserve(4 * n);
+    m.used.reserve(n);
+    m.colorOf.reserve(4 * n);
+    m.order.reserve(4 * n);
+    return true;
+}
+
+std::size_t WorldBatch::bodyCount(std::size_t k) const {
+    return groups_[k / kLanes].count[k % kLanes];
+}
+
+Body WorldBatch::body(std::size_t k, std::size_t i) const {
+    return bodyAt(groups_[k / kLanes], k % kLanes, i);
+}
+
+void WorldBatch::copyTo(std::size_t k, World& world) const {
+    const Group& grp = groups_[k / kLanes];
+    const std::size_t lane = k % kLanes;
+    const Member& m = members_[k];
+
+    BodyStore s;
+    s.reserve(grp.count[lane]);
+    for (std::size_t i = 0; i < grp.count[lane]; i++) {
+        s.push(bodyAt(grp, lane, i));
+    }
+    world.restore(m.config, std::move(s), m.stats, m.time, m.nextId, {});
+}
+
+void WorldBatch::clearEvents() {
+    for (Member& m : members_) m.events.clear();
+}
+
+// ---- Stepping ----
+
+void WorldBatch::step(float dt) {
+    pool_->parallelFor(groups_.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t g = begin; g < end; g++) {
+            stepGroup(g, dt);
+        }
+    });
+}
+
+void WorldBatch::run(int steps, float dt) {
+    for (int s = 0; s < steps; s++) {
+        step(dt);
+        clearEvents();
+    }
+}
+
+// World::step(), for kLanes worlds at once: the same phases in the same
+// order, with the per-body ones vectorized across lanes and the per-contact
+// ones run for each lane that has something to do.
+void WorldBatch::stepGroup(std::size_t g, float dt) {
+    Group& grp = groups_[g];
+    Member* members = &members_[g * kLanes];
+
+    for (std::size_t lane = 0; lane < grp.lanes; lane++) {
+        Member& m = members[lane];
+        m.touched = false;
+        m.found.clear();
+        m.events.reserve(m.events.size() + grp.count[lane]);
+    }
+
+    integrate(grp, dt);
+
+    // slow-pop, in slot order like World's loop over bodies
+    for (const Group::Flagged& f : grp.slowPops) {
+        for (std::uint32_t lanes = f.lanes; lanes; lanes &= lanes - 1) {
+            const std::size_t lane = __builtin_ctz(lanes);
+            Member& m = members[lane];
+            if (f.i >= grp.count[lane]) continue;
+            const std::size_t k = grp.at(f.i, lane);
+            if (m.rng.below(m.config.rules.slowPopOdds, RngStream::SlowPop, m.stats.steps, grp.id[k]) == 0) {
+                pop(grp, lane, m, f.i);
+            }
+        }
+    }
+
+    findTouching(grp);
+    for (const Group::Flagged& f : grp.touching) {
+        for (std::uint32_t lanes = f.lanes; lanes; lanes &= lanes - 1) {
+            const std::size_t lane = __builtin_ctz(lanes);
+            const std::size_t p = grp.at(f.i, lane);
+            const std::size_t q = grp.at(f.j, lane);
+
+            // as Narrowphase::find() does it
+            float dx = grp.x[q] - grp.x[p];
+            float dy = grp.y[q] - grp.y[p];
+            float minDist = grp.radius[p] + grp.radius[q];
+            float dist = std::sqrt(dx * dx + dy * dy);
+            if (!(dist > 0 && dist < minDist)) continue;
+
+            Member::Keyed c;
+            c.contact = { f.i, f.j, dx / dist, dy / dist, minDist - dist };
+            members[lane].found.push_back(c);
+        }
+    }
+
+    std::size_t used = 0;
+    for (std::size_t lane = 0; lane < grp.lanes; lane++) {
+        Member& m = members[lane];
+        m.contacts.clear();
+        if (!m.found.empty()) sortContacts(grp, lane, m);
+        m.stats.contacts += m.contacts.size();
+
+        if (!m.contacts.empty()) {
+            if (m.config.bubbleRules) applyContactEvents(grp, lane, m);
+            solve(grp, lane, m);
+        }
+        if (m.touched) compact(grp, lane, m);
+
+        m.time += dt;
+        m.stats.steps++;
+        used = std::max<std::size_t>(used, grp.count[lane]);
+    }
+    grp.used = used;
+}
+
+void WorldBatch::integrate(Group& grp, float dt) {
+    alignas(32) float gravityDt[kLanes];
+    alignas(32) std::uint32_t hasGravity[kLanes];
+    for (std::size_t l = 0; l < kLanes; l++) {
+        gravityDt[l] = grp.gravity[l] * dt;
+        hasGravity[l] = grp.gravity[l] != 0.f ? 0xffffffffu : 0u;
+    }
+
+    LaneArrays a = { grp.x.data(), grp.y.data(), grp.vx.data(), grp.vy.data(), grp.age.data(),
+                     grp.radius.data(), grp.used, grp.width, grp.height, grp.wallBounce,
+                     gravityDt, hasGravity, grp.popAge, grp.popSpeed };
+
+    grp.slowPops.clear();
+    auto flag = [&](std::uint32_t i, std::uint32_t lanes) { grp.slowPops.push_back({ i, 0, lanes }); };
+
+    switch (simd_) {
+#if PHYS_X86
+        case SimdLevel::Avx2: integrateAvx2(a, dt, flag); break;
+        case SimdLevel::Sse2: integrateSse2(a, dt, flag); break;
+#endif
+#if PHYS_NEON
+        case SimdLevel::Neon: integrateNeon(a, dt, flag); break;
+#endif
+        default: integrateScalar(a, dt, flag); break;
+    }
+}
+
+void WorldBatch::findTouching(Group& grp) {
+    LaneArrays a = {};
+    a.x = grp.x.data();
+    a.y = grp.y.data();
+    a.radius = grp.radius.data();
+    a.slots = grp.used;
+
+    grp.touching.clear();
+    auto flag = [&](std::uint32_t i, std::uint32_t j, std::uint32_t lanes) {
+        grp.touching.push_back({ i, j, lanes });
+    };
+
+    switch (simd_) {
+#if PHYS_X86
+        case SimdLevel::Avx2: touchingAvx2(a, flag); break;
+        case SimdLevel::Sse2: touchingSse2(a, flag); break;
+#endif
+#if PHYS_NEON
+        case SimdLevel::Neon: touchingNeon(a, flag); break;
+#endif
+        default: touchingScalar(a, flag); break;
+    }
+}
+
+// Puts a lane's contacts in the order World's Narrowphase finds them: it
+// walks UniformGrid cells row by row, and in each cell emits the pairs
+// inside it, then the pairs with the right, lower-left, lower and
+// lower-right neighbour, each in body index order. So the grid is laid out
+// here exactly as UniformGrid::build() would, for the cells alone. Pairs
+// whose cells the walk never pairs up (possible only by a rounding hair)
+// are dropped, since World wouldn't find them either.
+void WorldBatch::sortContacts(Group& grp, std::size_t lane, Member& m) {
+    const std::size_t n = grp.count[lane];
+    auto x = [&](std::size_t i) { return grp.x[grp.at(i, lane)]; };
+    auto y = [&](std::size_t i) { return grp.y[grp.at(i, lane)]; };
+
+    float maxRadius = 0.f;
+    float minX = x(0), maxX = x(0);
+    float minY = y(0), maxY = y(0);
+    for (std::size_t i = 0; i < n; i++) {
+        maxRadius = std::max(maxRadius, grp.radius[grp.at(i, lane)]);
+        minX = std::min(minX, x(i));
+        maxX = std::max(maxX, x(i));
+        minY = std::min(minY, y(i));
+        maxY = std::max(maxY, y(i));
+    }
+
+    float cell = std::max(2.f * maxRadius, 1e-3f);
+    const double maxCells = 4.0 * static_cast<double>(n) + 64.0;
+    int cols = 0, rows = 0;
+    for (;;) {
+        double c = std::floor((maxX - minX) / cell) + 1.0;
+        double r = std::floor((maxY - minY) / cell) + 1.0;
+        if (c * r <= maxCells) {
+            cols = static_cast<int>(c);
+            rows = static_cast<int>(r);
+            break;
+        }
+        cell *= 2.f;
+    }
+    const float inv = 1.f / cell;
+    auto cellX = [&](std::uint32_t i) { return std::min(static_cast<int>((x(i) - minX) * inv), cols - 1); };
+    auto cellY = [&](std::uint32_t i) { return std::min(static_cast<int>((y(i) - minY) * inv), rows - 1); };
+
+    std::size_t kept = 0;
+    for (Member::Keyed& k : m.found) {
+        const std::uint32_t a = k.contact.a;
+        const std::uint32_t b = k.contact.b;
+        const int ax = cellX(a), ay = cellY(a);
+        const int bx = cellX(b), by = cellY(b);
+        const std::uint32_t cellA = static_cast<std::uint32_t>(ay * cols + ax);
+        const std::uint32_t cellB = static_cast<std::uint32_t>(by * cols + bx);
+
+        // section: 0 inside the cell, then the stencil's right, lower-left,
+        // lower and lower-right neighbours
+        if (cellA == cellB)                          k.cell = cellA, k.section = 0, k.first = a, k.second = b;
+        else if (ay == by && bx == ax + 1)           k.cell = cellA, k.section = 1, k.first = a, k.second = b;
+        else if (ay == by && ax == bx + 1)           k.cell = cellB, k.section = 1, k.first = b, k.second = a;
+        else if (by == ay + 1 && std::abs(bx - ax) <= 1) {
+            k.cell = cellA, k.section = static_cast<std::uint32_t>(3 + bx - ax), k.first = a, k.second = b;
+        }
+        else if (ay == by + 1 && std::abs(ax - bx) <= 1) {
+            k.cell = cellB, k.section = static_cast<std::uint32_t>(3 + ax - bx), k.first = b, k.second = a;
+        }
+        else continue;
+        m.found[kept++] = k;
+    }
+    m.found.resize(kept);
+
+    std::sort(m.found.begin(), m.found.end(), [](const Member::Keyed& p, const Member::Keyed& q) {
+        if (p.cell != q.cell) return p.cell < q.cell;
+        if (p.section != q.section) return p.section < q.section;
+        if (p.first != q.first) return p.first < q.first;
+        return p.second < q.second;
+    });
+    for (const Member::Keyed& k : m.found) m.contacts.push_back(k.contact);
+}
+
+// ---- Per-world rules, as in World ----
+
+void WorldBatch::touch(Group& grp, std::size_t lane, Member& m) {
+    if (m.touched) return;
+    m.alive.assign(grp.count[lane], 1);
+    m.dead.clear();
+    m.merged.clear();
+    m.touched = true;
+}
+
+void WorldBatch::pop(Group& grp, std::size_t lane, Member& m, std::uint32_t i) {
+    touch(grp, lane, m);
+    const std::size_t k = grp.at(i, lane);
+    m.events.push_back({ EventType::Pop, grp.x[k], grp.y[k], grp.radius[k], grp.color[k] });
+    m.alive[i] = 0;
+    m.dead.push_back(i);
+    m.stats.pops++;
+}
+
+void WorldBatch::applyContactEvents(Group& grp, std::size_t lane, Member& m) {
+    touch(grp, lane, m);
+    const BubbleRules& rules = m.config.rules;
+
+    for (const Contact& c : m.contacts) {
+        const std::uint32_t i = c.a;
+        const std::uint32_t j = c.b;
+        if (!m.alive[i] || !m.alive[j]) continue;
+
+        const std::size_t p = grp.at(i, lane);
+        const std::size_t q = grp.at(j, lane);
+        const std::uint32_t idA = grp.id[p];
+        const std::uint32_t idB = grp.id[q];
+
+        float speedA = std::sqrt(grp.vx[p] * grp.vx[p] + grp.vy[p] * grp.vy[p]);
+        float speedB = std::sqrt(grp.vx[q] * grp.vx[q] + grp.vy[q] * grp.vy[q]);
+
+        if (grp.age[p] > rules.pairPopAge && grp.age[q] > rules.pairPopAge &&
+            speedA < rules.pairPopSpeed && speedB < rules.pairPopSpeed &&
+            m.rng.below(rules.pairPopOdds, RngStream::PairPop, m.stats.steps, idA, idB) == 0) {
+            pop(grp, lane, m, i);
+            pop(grp, lane, m, j);
+            continue;
+        }
+
+        bool pairCanMerge = (grp.flags[p] & BodyCanMerge) && (grp.flags[q] & BodyCanMerge);
+        if (pairCanMerge && m.rng.below(rules.mergeOdds, RngStream::Merge, m.stats.steps, idA, idB) == 0) {
+            Body merged = AreaMerges::merge(bodyAt(grp, lane, i), bodyAt(grp, lane, j));
+            m.merged.push_back({ i, merged });
+            m.events.push_back({ EventType::Merge, merged.x, merged.y, merged.radius, merged.color });
+            m.stats.merges++;
+
+            m.alive[i] = 0;
+            m.alive[j] = 0;
+            m.dead.push_back(j);
+        }
+    }
+}
+
+// ContactSolver's single pass: greedy coloring in contact order, then one
+// impulse and half the overlap per contact, color by color.
+void WorldBatch::solve(Group& grp, std::size_t lane, Member& m) {
+    touch(grp, lane, m);
+    const int kMaskColors = 64;
+    const std::uint8_t kSkipped = 0xff;
+    const std::size_t n = m.contacts.size();
+
+    m.used.assign(grp.count[lane], 0);
+    m.colorOf.resize(n);
+    std::array<std::uint32_t, kMaskColors + 2> colorStart = {};
+    for (std::size_t k = 0; k < n; k++) {
+        const Contact& c = m.contacts[k];
+        if (!m.alive[c.a] || !m.alive[c.b]) {
+            m.colorOf[k] = kSkipped;
+            continue;
+        }
+        std::uint64_t taken = m.used[c.a] | m.used[c.b];
+        int color = kMaskColors;
+        if (~taken) {
+            color = __builtin_ctzll(~taken);
+            m.used[c.a] |= std::uint64_t(1) << color;
+            m.used[c.b] |= std::uint64_t(1) << color;
+        }
+        m.colorOf[k] = static_cast<std::uint8_t>(color);
+        colorStart[color + 1]++;
+    }
+    for (int c = 1; c < kMaskColors + 2; c++) {
+        colorStart[c] += colorStart[c - 1];
+    }
+    m.order.resize(colorStart.back());
+    for (std::size_t k = 0; k < n; k++) {
+        if (m.colorOf[k] != kSkipped) m.order[colorStart[m.colorOf[k]]++] = static_cast<std::uint32_t>(k);
+    }
+
+    const float e = m.config.restitutionBall;
+    for (std::uint32_t k : m.order) {
+        const Contact& c = m.contacts[k];
+        const std::size_t i = grp.at(c.a, lane);
+        const std::size_t j = grp.at(c.b, lane);
+        const float mi = grp.invMass[i];
+        const float mj = grp.invMass[j];
+        const float share = 1.f / (mi + mj);
+
+        float velAlongNormal = (grp.vx[j] - grp.vx[i]) * c.nx + (grp.vy[j] - grp.vy[i]) * c.ny;
+        if (velAlongNormal < 0) {
+            float jImpulse = -(1 + e) * velAlongNormal * share;
+            grp.vx[i] -= jImpulse * c.nx * mi;
+            grp.vy[i] -= jImpulse * c.ny * mi;
+            grp.vx[j] += jImpulse * c.nx * mj;
+            grp.vy[j] += jImpulse * c.ny * mj;
+        }
+
+        float correction = c.penetration * share;
+        grp.x[i] -= correction * c.nx * mi;
+        grp.y[i] -= correction * c.ny * mi;
+        grp.x[j] += correction * c.nx * mj;
+        grp.y[j] += correction * c.ny * mj;
+    }
+}
+
+// As World::compact(): merged bodies over their first parent, then the dead
+// swap-removed from the highest index down. The emptied last slot goes back
+// to NaN.
+void WorldBatch::compact(Group& grp, std::size_t lane, Member& m) {
+    for (Member::Merged& merged : m.merged) {
+        merged.body.id = m.nextId++;
+        setBody(grp, lane, merged.slot, merged.body);
+    }
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    std::sort(m.dead.begin(), m.dead.end(), std::greater<std::uint32_t>());
+    for (std::uint32_t i : m.dead) {
+        const std::size_t last = grp.count[lane] - 1;
+        const std::size_t to = grp.at(i, lane);
+        const std::size_t from = grp.at(last, lane);
+        if (i != last) {
+            grp.x[to] = grp.x[from];
+            grp.y[to] = grp.y[from];
+            grp.vx[to] = grp.vx[from];
+            grp.vy[to] = grp.vy[from];
+            grp.radius[to] = grp.radius[from];
+            grp.invMass[to] = grp.invMass[from];
+            grp.age[to] = grp.age[from];
+            grp.flags[to] = grp.flags[from];
+            grp.id[to] = grp.id[from];
+            grp.color[to] = grp.color[from];
+        }
+        grp.x[from] = grp.y[from] = grp.vx[from] = grp.vy[from] = nan;
+        grp.count[lane]--;
+    }
+}
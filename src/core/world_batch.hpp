@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "body_store.hpp"
+#include "contacts.hpp"
+#include "kernels.hpp"
+#include "thread_pool.hpp"
+#include "world.hpp"
+
+// Many small worlds stepped in lockstep, for ensembles: thousands of
+// 100-bubble worlds that differ in seed or parameters.
+//
+// Worlds are stored interleaved, kLanes to a group: a group keeps each body
+// field as one array indexed [slot * kLanes + lane], so slot i of all its
+// worlds sits in one SIMD register. Movement, walls, the slow-pop test and
+// the pair tests then advance a whole group per instruction. Small worlds
+// are tested pair by pair (every slot against every later slot, which at
+// 100 bodies is cheaper than building a grid), and the few pairs that touch
+// are handed to their own world, which applies pops, merges and impulses
+// with scalar code, as World does.
+//
+// A member behaves exactly like the World it was added from: contacts are
+// put back into the order World's grid walk finds them in, so every member
+// ends up bit-identical to a World stepped on its own, events included
+// (stats().pairTests stays 0: there is no grid). Members can have different
+// sizes, parameters and seeds; the batch only needs them to share dt. Swept
+// collision, the iterative solver, sleeping and periodic worlds aren't
+// supported.
+class WorldBatch {
+public:
+    static const std::size_t kLanes = 8;
+
+    // threads <= 0 uses every hardware thread; groups are stepped in parallel.
+    explicit WorldBatch(int threads = 1, SimdLevel simd = bestSimdLevel());
+
+    // Adds a copy of world's current state as member size(). Returns false,
+    // saying why on stderr, if its config uses something the batch can't do.
+    bool add(const World& world);
+
+    std::size_t size() const { return members_.size(); }
+
+    // Advances every member by dt. Events are appended to events(k) until
+    // clearEvents() is called.
+    void step(float dt);
+
+    // Batch stepping; events are discarded.
+    void run(int steps, float dt);
+
+    const WorldConfig& config(std::size_t k) const { return members_[k].config; }
+    const WorldStats& stats(std::size_t k) const { return members_[k].stats; }
+    double time(std::size_t k) const { return members_[k].time; }
+    const std::vector<SimEvent>& events(std::size_t k) const { return members_[k].events; }
+    void clearEvents();
+
+    std::size_t bodyCount(std::size_t k) const;
+    Body body(std::size_t k, std::size_t i) const;
+
+    // Member k's whole state, for snapshots, rendering or a closer look.
+    void copyTo(std::size_t k, World& world) const;
+
+private:
+    struct Group {
+        std::size_t slots = 0;          // bodies each lane has room for
+        std::size_t used = 0;           // slots holding a body in some lane
+        std::size_t lanes = 0;          // members in this group
+        std::uint32_t count[kLanes] = {};
+
+        // [slot * kLanes + lane]; x, y, vx and vy are NaN past a lane's
+        // count, so empty slots never touch or pop anything
+        AlignedVector<float> x, y, vx, vy, radius, invMass, age;
+        std::vector<std::uint8_t> flags;
+        std::vector<std::uint32_t> id;
+        std::vector<Rgba> color;
+
+        // per-lane parameters, read by the kernels
+        alignas(32) float width[kLanes] = {};
+        alignas(32) float height[kLanes] = {};
+        alignas(32) float wallBounce[kLanes] = {};  // -restitutionWall
+        alignas(32) float gravity[kLanes] = {};
+        alignas(32) float popAge[kLanes] = {};      // slow-pop test; +inf without bubble rules
+        alignas(32) float popSpeed[kLanes] = {};
+
+        // per-step scratch: slots with a lane flagged, and the lanes as a bit mask
+        struct Flagged {
+            std::uint32_t i, j;
+            std::uint32_t lanes;
+        };
+        std::vector<Flagged> slowPops;
+        std::vector<Flagged> touching;
+
+        std::size_t at(std::size_t slot, std::size_t lane) const { return slot * kLanes + lane; }
+        void grow(std::size_t slots);
+    };
+
+    struct Member {
+        WorldConfig config;
+        WorldStats stats;
+        CounterRng rng;
+        double time = 0.0;
+        std::uint32_t nextId = 1;
+        std::vector<SimEvent> events;
+
+        // per-step scratch, as in World
+        bool touched = false;           // alive/dead/merged are set up for this step
+        std::vector<char> alive;
+        std::vector<std::uint32_t> dead;
+        struct Merged {
+            std::uint32_t slot;
+            Body body;
+        };
+        std::vector<Merged> merged;
+        struct Keyed {
+            std::uint32_t cell, section, first, second;    // where World's grid walk finds it
+            Contact contact;
+        };
+        std::vector<Keyed> found;
+        std::vector<Contact> contacts;
+        std::vector<std::uint64_t> used;        // coloring, per body
+        std::vector<std::uint8_t> colorOf;      // coloring, per contact
+        std::vector<std::uint32_t> order;
+    };
+
+    void stepGroup(std::size_t g, float dt);
+    void integrate(Group& grp, float dt);
+    void findTouching(Group& grp);
+    void sortContacts(Group& grp, std::size_t lane, Member& m);
+    void applyContactEvents(Group& grp, std::size_t lane, Member& m);
+    void solve(Group& grp, std::size_t lane, Member& m);
+    void compact(Group& grp, std::size_t lane, Member& m);
+    void touch(Group& grp, std::size_t lane, Member& m);
+    void pop(Group& grp, std::size_t lane, Member& m, std::uint32_t i);
+
+    Body bodyAt(const Group& grp, std::size_t lane, std::size_t i) const;
+    void setBody(Group& grp, std::size_t lane, std::size_t i, const Body& b);
+
+    SimdLevel simd_;
+    std::vector<Group> groups_;
+    std::vector<Member> members_;
+    std::unique_ptr<ThreadPool> pool_;
+};
@@ -1,18 +1,41 @@
 #include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/scenario_file.hpp"
+#include "core/scenarios.hpp"
 
 using namespace std;
 
-void runBouncyBubble(bool shader);
-void runBouncyBall(bool gravity);
+int runBouncyBubble(bool shader, const WorldConfig& config, int count);
+int runBouncyBall(const WorldConfig& config, int count);
+
+// ./physicSims [balls | balls-gravity | bubbles | bubbles-shader | scenario.json]
+// A scenario file (see core/scenario_file.hpp) sets the world and the body
+// count; the window runs its first scenario at the sim's own step rate.
+int main(int argc, char** argv) {
+    string arg = argc > 1 ? argv[1] : "bubbles";
+    bool shader = (arg == "bubbles-shader");
+    if (shader) arg = "bubbles";
+
+    Scenario sc;
+    if (simConfig(arg, sc.config)) {
+        sc.name = sc.sim = arg;
+    } else {
+        vector<Scenario> scenarios;
+        string error;
+        if (!loadScenarios(arg, scenarios, &error)) {
+            cerr << error << "\n";
+            return 1;
+        }
+        if (scenarios.empty()) {
+            cerr << arg << " has no scenarios\n";
+            return 1;
+        }
+        sc = scenarios.front();
+    }
 
-int main() {
-    // cout << "Running Bouncy Balls" << endl;
-    // runBouncyBall(false);
-    // cout << "Running Bouncy Balls with Gravity" << endl;
-    // runBouncyBall(true);
-    cout << "Running Bouncy Bubbles" << endl;
-    runBouncyBubble(false);
-    // cout << "Running Bouncy Bubbles with Shaders" << endl;
-    // runBouncyBubble(true);
-    return 0;
-}
\ No newline at end of file
+    cout << "Running " << sc.name << (shader ? " with shaders" : "") << endl;
+    if (sc.config.bubbleRules) return runBouncyBubble(shader, sc.config, sc.count);
+    return runBouncyBall(sc.config, sc.count);
+}
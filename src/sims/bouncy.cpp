@@ -3,61 +3,39 @@
 #include <vector>
 #include <cmath>
 #include "math_helpers.cpp"
+#include "camera.hpp"
+#include "profiler_overlay.hpp"
+#include "../core/contacts.hpp"
+#include "../core/profiler.hpp"
+#include "../core/scenarios.hpp"
 
 using namespace std;
 
-struct Ball {
-    sf::CircleShape shape;
-    sf::Vector2f velocity;
-    float radius;
-};
+int runBouncyBall(const WorldConfig& config, int count) {
+    World world(config);
+    spawnBouncyBalls(world, count);
 
-int runBouncyBall() {
-    float sc = 1;
-    const unsigned int WINDOW_WIDTH  = 800 * sc;
-    const unsigned int WINDOW_HEIGHT = 600 * sc;
+    const sf::Vector2f worldSize(world.config().width, world.config().height);
+    const sf::Vector2u windowSize = windowSizeFor(worldSize.x, worldSize.y);
 
     sf::RenderWindow window(
-        sf::VideoMode({WINDOW_WIDTH, WINDOW_HEIGHT}),
-        "Inelastic Bouncy Balls"
+        sf::VideoMode(windowSize),
+        config.gravity > 0.f ? "Inelastic Bouncy Balls with Gravity" : "Inelastic Bouncy Balls"
     );
     window.setFramerateLimit(80);
 
-    const float restitution_ball = 0.8f; // inelastic (1.0 = elastic)
-    const float restitution_wall = 0.8f;
-
-    std::vector<Ball> balls;
-
-    auto makeBall = [&](sf::Vector2f pos, sf::Vector2f vel, sf::Color col) {
-        Ball b;
-        int r = rand() % (3 - 1 + 1) + 1;
-        b.radius = r * 10.f;
-        b.shape = sf::CircleShape(b.radius);
-        b.shape.setFillColor(col);
-        b.shape.setPosition(pos);
-        r = rand() % 10 + 1;
-        int sign = (rand() % 2 == 0) ? 1 : -1;
-        b.velocity = sign * r * vel * 10;
-        balls.push_back(b);
-    };
-
-    
-    int n = rand() % 80 + 20; 
-    int radius = 20;
-
-    for(int i = 0; i < n; i++) {
-        int rand_x  = rand() % (WINDOW_WIDTH  - 2*radius) + radius;
-        int rand_y  = rand() % (WINDOW_HEIGHT - 2*radius) + radius;
-
-        int rand_vx = (rand() % 200 + 100) * (rand() % 2 ? 1 : -1);
-        int rand_vy = (rand() % 200 + 100) * (rand() % 2 ? 1 : -1);
-        makeBall(sf::Vector2f(static_cast<float>(rand_x),  static_cast<float>(rand_y)),
-                sf::Vector2f(static_cast<float>(rand_vx), static_cast<float>(rand_vy)),
-                sf::Color(std::rand() % 128 + 128, std::rand() % 128 + 128, std::rand() % 128 + 128, 255)
-        );
-    }
+    FixedTimestep stepper(bouncyBallSteps());
 
+    // F1 toggles the timing overlay; PHYS_PROFILE_DUMP / PHYS_TRACE work too
+    Profiler::get().configureFromEnv();
+    ProfilerOverlay overlay;
 
+    // one unit circle, placed and scaled per ball: setRadius() would rebuild
+    // its points every time
+    sf::CircleShape shape(1.f);
+    shape.setOrigin(sf::Vector2f(1.f, 1.f));
+    Camera camera(worldSize, windowSize);
+    std::vector<std::uint32_t> visible;
     sf::Clock clock;
 
     while (window.isOpen()) {
@@ -67,80 +45,74 @@ int runBouncyBall() {
             if (event->is<sf::Event::Closed>()) {
                 window.close();
             }
-        }
-
-        float dt = clock.restart().asSeconds();
-
-        // ----- Move & wall collisions -----
-        for (auto& b : balls) {
-            sf::Vector2f pos = b.shape.getPosition();
-            pos += b.velocity * dt;
-
-            // Wall collisions
-            if (pos.x < 0) {
-                pos.x = 0;
-                b.velocity.x = -b.velocity.x * restitution_wall;
-            } 
-            else if (pos.x + 2*b.radius > WINDOW_WIDTH) {
-                pos.x = WINDOW_WIDTH - 2*b.radius;
-                b.velocity.x = -b.velocity.x * restitution_wall;
+            else if (camera.handle(*event, window)) {
             }
-
-            if (pos.y < 0) {
-                pos.y = 0;
-                b.velocity.y = -b.velocity.y * restitution_wall;
-            } 
-            else if (pos.y + 2*b.radius > WINDOW_HEIGHT) {
-                pos.y = WINDOW_HEIGHT - 2*b.radius;
-                b.velocity.y = -b.velocity.y * restitution_wall;
+            else if (const auto* key = event->getIf<sf::Event::KeyPressed>()) {
+                if (key->code == sf::Keyboard::Key::F1) overlay.toggle();
             }
-
-            b.shape.setPosition(pos);
         }
 
-        // ----- Ball-to-ball collisions -----
-        for (int i = 0; i < balls.size(); i++) {
-            for (int j = i + 1; j < balls.size(); j++) {
-                Ball& A = balls[i];
-                Ball& B = balls[j];
-
-                sf::Vector2f posA = A.shape.getPosition() + sf::Vector2f(A.radius,A.radius);
-                sf::Vector2f posB = B.shape.getPosition() + sf::Vector2f(B.radius,B.radius);
-
-                sf::Vector2f delta = posB - posA;
-                float dist = length(delta);
-                float minDist = A.radius + B.radius;
-
-                if (dist > 0 && dist < minDist) {
-
-                    // Normal vector
-                    sf::Vector2f n = delta / dist;
+        float dt = clock.restart().asSeconds();
 
-                    // Relative velocity
-                    sf::Vector2f rel = B.velocity - A.velocity;
-                    float velAlongNormal = dot(rel, n);
+        camera.update(dt);
+        stepper.advance(world, dt);
+        world.clearEvents();
+        const float alpha = stepper.alpha();
 
-                    if (velAlongNormal < 0) {
-                        float j = -(1 + restitution_ball) * velAlongNormal / 2.f;
-                        sf::Vector2f impulse = j * n;
-                        A.velocity -= impulse;
-                        B.velocity += impulse;
+        // ----- Render -----
+        window.clear(sf::Color::Black);
+        {
+            PROF_SCOPE("Render");
+            const BodyStore& bodies = world.bodies();
+            const bool periodic = world.config().periodic;
+            const sf::FloatRect view = camera.visible();
+            window.setView(camera.view());
+
+            // only the balls near the view, with a margin for the ones drawn
+            // a step behind where they are
+            const sf::Vector2f pad = view.size * 0.1f;
+            visible.clear();
+            world.query(view.position.x - pad.x, view.position.y - pad.y,
+                        view.position.x + view.size.x + pad.x, view.position.y + view.size.y + pad.y, visible);
+
+            Rgba last{ 0, 0, 0, 0 };
+            shape.setFillColor(sf::Color::Transparent);
+            for (const std::uint32_t i : visible) {
+                float r = bodies.radius[i];
+                // sleeping balls don't move: nothing to interpolate
+                float x = bodies.x[i], y = bodies.y[i];
+                if (!bodies.asleep(i)) {
+                    // the short way round, so a ball crossing a periodic
+                    // world's edge doesn't sweep across the whole world
+                    float dx = x - bodies.px[i];
+                    float dy = y - bodies.py[i];
+                    if (periodic) {
+                        dx = wrapDelta(dx, world.config().width);
+                        dy = wrapDelta(dy, world.config().height);
                     }
-
-                    // Positional correction to avoid overlap
-                    float penetration = minDist - dist;
-                    sf::Vector2f correction = 0.5f * penetration * n;
-                    A.shape.move(-correction);
-                    B.shape.move( correction);
+                    x = bodies.px[i] + dx * alpha;
+                    y = bodies.py[i] + dy * alpha;
                 }
+                if (x + r < view.position.x || x - r > view.position.x + view.size.x ||
+                    y + r < view.position.y || y - r > view.position.y + view.size.y) continue;
+
+                shape.setPosition(sf::Vector2f(x, y));
+                shape.setScale(sf::Vector2f(r, r));
+                const Rgba& c = bodies.color[i];
+                if (c.r != last.r || c.g != last.g || c.b != last.b || c.a != last.a) {
+                    shape.setFillColor(sf::Color(c.r, c.g, c.b, c.a));
+                    last = c;
+                }
+                window.draw(shape);
             }
         }
-
-        // ----- Render -----
-        window.clear(sf::Color::Black);
-        for (auto& b : balls)
-            window.draw(b.shape);
-        window.display();
+        window.setView(window.getDefaultView());
+        overlay.draw(window);
+        {
+            PROF_SCOPE("Display");
+            window.display();
+        }
+        PROF_FRAME();
     }
 
     return 0;
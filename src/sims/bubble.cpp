@@ -1,81 +1,141 @@
 #include <SFML/Graphics.hpp>
-#include <SFML/Audio.hpp>
 #include <optional>
 #include <vector>
 #include <cmath>
 #include <cstdint>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <thread>
 #include "math_helpers.cpp"   // has dot(), length(), vec ops
+#include "bubble_batch.hpp"
+#include "camera.hpp"
+#include "pop_stream.hpp"
+#include "profiler_overlay.hpp"
+#include "../core/profiler.hpp"
+#include "../core/pool.hpp"
+#include "../core/scenarios.hpp"
+#include "../core/snapshot.hpp"
+#include "../core/spsc_ring.hpp"
+#include "../core/triple_buffer.hpp"
 
 using namespace std;
 
-struct ActiveSound {
-    sf::Sound sound;
-    float age;
-
-    ActiveSound(const sf::SoundBuffer& buffer, float volume)
-        : sound(buffer), age(0.f)
-    {
-        sound.setVolume(volume);
-        sound.play();
-    }
-};
-
+// Plain data only; rings are drawn as part of the frame's BubbleBatch.
 struct PopRing {
-    sf::CircleShape shape;
+    sf::Vector2f center;
+    sf::Color color;
     float baseRadius = 0.f;
     float age = 0.f;
     float lifetime = 0.35f;
 };
 
-struct Bubble {
-    sf::CircleShape main;
-    sf::CircleShape shine;
-    sf::Vector2f velocity;
-    float radius;
-    bool canMerge;
-    float age;
+static sf::Color toColor(const Rgba& c) {
+    return sf::Color(c.r, c.g, c.b, c.a);
+}
 
-    Bubble(float r, sf::Vector2f pos, sf::Vector2f vel, sf::Color col) {
-        radius = r;
-        canMerge = true;
-        age = 0.f;
+// Highlight position drifts with the bubble's place on screen so the
+// light appears to come from one direction: from 25 degrees up at the
+// top-left corner to 80 at the bottom-right. The direction depends only on
+// how far along that diagonal the bubble is, so it is looked up instead of
+// taking a cos and a sin per bubble per frame.
+class ShineTable {
+public:
+    ShineTable() {
+        const float baseDeg = 25.f;
+        const float topDeg  = 80.f;
+        for (int k = 0; k < kSize; k++) {
+            float t = static_cast<float>(k) / (kSize - 1);
+            float angleRad = (baseDeg + t * (topDeg - baseDeg)) * 3.14159265f / 180.f;
+            dir_[k] = sf::Vector2f(std::cos(angleRad), -std::sin(angleRad));
+        }
+    }
 
-        main = sf::CircleShape(radius);
-        main.setFillColor(col);
-        main.setPosition(pos);
+    // view is the world rectangle on screen, invSize 1 / its size.
+    sf::Vector2f center(sf::Vector2f center, float radius, const sf::FloatRect& view, sf::Vector2f invSize) const {
+        float t = ((center.x - view.position.x) * invSize.x + (center.y - view.position.y) * invSize.y) * 0.5f;
+        int k = std::clamp(static_cast<int>(t * (kSize - 1) + 0.5f), 0, kSize - 1);
 
         float shineR = radius * 0.35f;
-        shine = sf::CircleShape(shineR);
-        shine.setFillColor(sf::Color(220, 240, 255, 180));
-
-        velocity = vel;
+        float dist = radius - shineR * 1.2f;
+        return center + dir_[k] * dist;
     }
 
-    void updateShine(const sf::Vector2u& windowSize) {
-        sf::Vector2f pos = main.getPosition();
-        sf::Vector2f center = pos + sf::Vector2f(radius, radius);
+private:
+    static const int kSize = 1024;      // a step is 0.05 degrees
+    sf::Vector2f dir_[kSize];
+};
 
-        float nx = center.x / static_cast<float>(windowSize.x);
-        float ny = center.y / static_cast<float>(windowSize.y);
-        float t = (nx + ny) * 0.5f;
+// Whether a disc of radius r at c shows in the view at all.
+static bool onScreen(sf::Vector2f c, float r, const sf::FloatRect& view) {
+    return c.x + r >= view.position.x && c.x - r <= view.position.x + view.size.x &&
+           c.y + r >= view.position.y && c.y - r <= view.position.y + view.size.y;
+}
 
-        const float baseDeg = 25.f;
-        const float topDeg  = 80.f;
-        float angleDeg = baseDeg + t * (topDeg - baseDeg);
-        float angleRad = angleDeg * 3.14159265f / 180.f;
+// The part of the world worth copying out for drawing: what the camera
+// shows, with room to pan before the next capture.
+struct CaptureRect {
+    float minX = 0.f, minY = 0.f, maxX = 0.f, maxY = 0.f;
+};
 
-        float shineR = radius * 0.35f;
-        float dist = radius - shineR * 1.2f;
+static CaptureRect captureRectFor(const sf::FloatRect& view) {
+    const sf::Vector2f pad = view.size * 0.25f;
+    return { view.position.x - pad.x, view.position.y - pad.y,
+             view.position.x + view.size.x + pad.x, view.position.y + view.size.y + pad.y };
+}
 
-        sf::Vector2f dir(std::cos(angleRad), -std::sin(angleRad));
+// What drawing needs of one physics step, copied out of the world so the
+// renderer can read it while the world moves on. Only bodies the camera
+// can see are copied, so a frame costs what is on screen, not what is in
+// the world. The vectors keep their capacity from frame to frame.
+struct BubbleFrame {
+    std::vector<std::uint32_t> index;                   // scratch: world.query() result
+    std::vector<float> px, py, x, y, radius;
+    std::vector<Rgba> color;
+    float alpha = 0.f;                                  // stepper.alpha() at capture
+    std::chrono::steady_clock::time_point captured;
+};
 
-        sf::Vector2f shineCenter = center + dir * dist;
-        shine.setPosition(shineCenter - sf::Vector2f(shineR, shineR));
+static void captureFrame(const World& world, const CaptureRect& rect, float alpha, BubbleFrame& f) {
+    f.index.clear();
+    world.query(rect.minX, rect.minY, rect.maxX, rect.maxY, f.index);
+
+    const BodyStore& b = world.bodies();
+    const std::size_t n = f.index.size();
+    f.px.resize(n);
+    f.py.resize(n);
+    f.x.resize(n);
+    f.y.resize(n);
+    f.radius.resize(n);
+    f.color.resize(n);
+
+    // a body that wrapped around a periodic world this step is drawn where
+    // it is, not slid across the world
+    const WorldConfig& cfg = world.config();
+    const float halfW = cfg.periodic ? cfg.width * 0.5f : INFINITY;
+    const float halfH = cfg.periodic ? cfg.height * 0.5f : INFINITY;
+    for (std::size_t k = 0; k < n; k++) {
+        const std::uint32_t i = f.index[k];
+        f.x[k] = b.x[i];
+        f.y[k] = b.y[i];
+        f.px[k] = std::fabs(b.x[i] - b.px[i]) > halfW ? b.x[i] : b.px[i];
+        f.py[k] = std::fabs(b.y[i] - b.py[i]) > halfH ? b.y[i] : b.py[i];
+        f.radius[k] = b.radius[i];
+        f.color[k] = b.color[i];
     }
-};
-int runBouncyBubble(bool shader) {
+    f.alpha = alpha;
+    f.captured = std::chrono::steady_clock::now();
+}
+
+// PHYS_PIPELINE=0/1; on by default when there is a second core to run on.
+static bool pipelineFromEnv() {
+    if (const char* p = std::getenv("PHYS_PIPELINE")) return std::atoi(p) != 0;
+    return std::thread::hardware_concurrency() > 1;
+}
+
+int runBouncyBubble(bool shader, const WorldConfig& config, int count) {
     // ---------- Shader ----------
     sf::Shader bubbleShader;
     bool useShader = false;
@@ -90,361 +150,279 @@ int runBouncyBubble(bool shader) {
         }
     }
 
-    float sc = 1.2f;
-    const unsigned int WINDOW_WIDTH  = static_cast<unsigned int>(1200 * sc);
-    const unsigned int WINDOW_HEIGHT = static_cast<unsigned int>(900  * sc);
-    const float WINDOW_WIDTH_F  = static_cast<float>(WINDOW_WIDTH);
-    const float WINDOW_HEIGHT_F = static_cast<float>(WINDOW_HEIGHT);
+    // PHYS_LOAD=<file> resumes a snapshot saved with F5 instead of spawning
+    World world(config);
+    std::vector<PopRingState> savedRings;
+    const char* loadPath = std::getenv("PHYS_LOAD");
+    if (!loadPath || !*loadPath || !loadSnapshot(loadPath, world, &savedRings)) {
+        spawnBubbles(world, count);
+        savedRings.clear();
+    }
+
+    // the world can be far bigger than the window; the camera shows part of it
+    const sf::Vector2f worldSize(world.config().width, world.config().height);
+    const sf::Vector2u windowSize = windowSizeFor(worldSize.x, worldSize.y);
 
     sf::RenderWindow window(
-        sf::VideoMode({WINDOW_WIDTH, WINDOW_HEIGHT}),
+        sf::VideoMode(windowSize),
         "Inelastic Bouncy Bubbles"
     );
     window.setFramerateLimit(100);
 
-    const float restitution_ball = 0.8f;
-    const float restitution_wall = 0.8f;
-
-    std::vector<Bubble>  bubbles;
-    std::vector<PopRing> popRings;
+    Pool<PopRing> popRings;
+    popRings.reserve(512);
+    for (const PopRingState& r : savedRings) {
+        PopRing ring;
+        ring.center = sf::Vector2f(r.x, r.y);
+        ring.color = toColor(r.color);
+        ring.baseRadius = r.baseRadius;
+        ring.age = r.age;
+        ring.lifetime = r.lifetime;
+        popRings.add(ring);
+    }
 
     // ---------- Audio ----------
-    sf::SoundBuffer popBuffer;
-    if (!popBuffer.loadFromFile("assets/pop.wav")) {
+    // pops go to one mixed stream; a burst of them costs a few queue pushes
+    AudioClip popClip;
+    if (!loadWav("assets/pop.wav", popClip)) {
         std::cerr << "Failed to load pop sound\n";
     }
 
-    std::vector<ActiveSound> activeSounds;
-
-    auto makeBubble = [&](sf::Vector2f pos, sf::Vector2f vel) {
-        int ri = rand() % 20 + 5;
-        float r = static_cast<float>(ri);
-
-        int style = rand() % 3;
-        int R, G, B, A;
-
-        switch (style) {
-            case 0: {
-                int base = rand() % 50 + 180;
-                R = base;
-                G = base + 10;
-                B = rand() % 20 + (255 - 20 + 1);
-                A = rand() % 40 + 140;
-                break;
-            }
-            case 1: {
-                R = rand() % 60 + 80;
-                G = rand() % 80 + 170;
-                B = 255;
-                A = rand() % 40 + 140;
-                break;
-            }
-            case 2: {
-                R = rand() % 60 + 40;
-                G = rand() % 80 + 80;
-                B = rand() % 55 + 200;
-                A = rand() % 40 + 140;
-                break;
-            }
-        }
-
-        sf::Color col(
-            static_cast<std::uint8_t>(R),
-            static_cast<std::uint8_t>(G),
-            static_cast<std::uint8_t>(B),
-            static_cast<std::uint8_t>(A)
-        );
-
-        bubbles.emplace_back(r, pos, vel, col);
-    };
+    PopMixer popMixer(popClip);
+    std::optional<PopStream> popStream;
+    if (!popClip.samples.empty()) {
+        popStream.emplace(popMixer);
+        popStream->play();
+    }
 
-    auto makePopRing = [&](const Bubble& b) {
+    auto makePopRing = [&](const SimEvent& e) {
         PopRing ring;
 
-        ring.baseRadius = b.radius * 1.10f;
-        ring.shape = sf::CircleShape(ring.baseRadius);
-        ring.shape.setOrigin(sf::Vector2f(ring.baseRadius, ring.baseRadius));
-
-        sf::Vector2f center = b.main.getPosition() + sf::Vector2f(b.radius, b.radius);
-        ring.shape.setPosition(center);
-
-        sf::Color c = b.main.getFillColor();
-        c.a = 200;
-        ring.shape.setFillColor(sf::Color(0, 0, 0, 0));
-        ring.shape.setOutlineColor(c);
-        ring.shape.setOutlineThickness(3.f);
+        ring.baseRadius = e.radius * 1.10f;
+        ring.center = sf::Vector2f(e.x, e.y);
+        ring.color = toColor(e.color);
+        ring.color.a = 200;
 
         ring.age = 0.f;
         ring.lifetime = 0.35f;
-        popRings.push_back(ring);
+        popRings.add(ring);
+    };
 
-        if (popBuffer.getSampleCount() > 0) {
-            activeSounds.emplace_back(popBuffer, 60.f);
+    FixedTimestep stepper(bouncyBubbleSteps());
+    const float stepDt = stepper.config().stepDt;
+
+    Camera camera(worldSize, windowSize);
+
+    BubbleBatch batch;
+    const ShineTable shines;
+    const sf::Color shineColor(220, 240, 255, 180);
+
+    // F1 toggles the timing overlay; PHYS_PROFILE_DUMP / PHYS_TRACE work too
+    Profiler::get().configureFromEnv();
+    ProfilerOverlay overlay;
+
+    // F5 writes bubbles.snap in the background
+    SnapshotWriter snapshots;
+    auto copyRings = [&]() {
+        savedRings.clear();
+        for (const auto& ring : popRings) {
+            PopRingState r;
+            r.x = ring.center.x;
+            r.y = ring.center.y;
+            r.baseRadius = ring.baseRadius;
+            r.age = ring.age;
+            r.lifetime = ring.lifetime;
+            r.color = Rgba{ ring.color.r, ring.color.g, ring.color.b, ring.color.a };
+            savedRings.push_back(r);
+        }
+    };
+    auto writeSnapshot = [&]() {
+        if (snapshots.save("bubbles.snap", world, savedRings)) {
+            std::cout << "Saving bubbles.snap" << std::endl;
         }
     };
 
-    int n = rand() % 20 + 100;
-    int radius = 20;
+    // ---------- Pipeline ----------
+    // With PHYS_PIPELINE on, the world lives on a sim thread that steps it in
+    // real time and publishes a BubbleFrame after each step; this thread only
+    // draws the newest one, so a slow draw never holds physics back and a
+    // frame costs max(sim, render) rather than their sum. Pops reach the
+    // mixer straight from the sim thread and come here through a queue, so
+    // skipped frames don't lose rings. World's sections, recorded on the sim
+    // thread, land in whichever frame follows; its whole stepping time also
+    // shows up as the "sim thread us" counter.
+    const bool pipelined = pipelineFromEnv();
+    TripleBuffer<BubbleFrame> frames;
+    TripleBuffer<CaptureRect> views;            // the other way: what the camera shows
+    SpscRing<SimEvent> pops(4096);
+    std::atomic<bool> running{ true };
+    std::atomic<bool> saveRequested{ false };   // savedRings is the sim thread's while set
+    std::atomic<std::uint64_t> simNanos{ 0 };
+
+    auto publishStep = [&]() {
+        for (const SimEvent& e : world.events()) {
+            if (e.type == EventType::Pop) {
+                popMixer.post(popSound(e, world.config().width));
+                pops.push(e);
+            }
+        }
+        world.clearEvents();
+        views.update();
+        captureFrame(world, views.front(), stepper.alpha(), frames.back());
+        frames.publish();
+    };
 
-    for (int i = 0; i < n; i++) {
-        int rand_x  = rand() % (WINDOW_WIDTH  - 2 * radius) + radius;
-        int rand_y  = rand() % (WINDOW_HEIGHT - 2 * radius) + radius;
-        int rand_vx = (rand() % 200 + 100) * (rand() % 2 ? 1 : -1);
-        int rand_vy = (rand() % 200 + 100) * (rand() % 2 ? 1 : -1);
+    views.back() = captureRectFor(camera.visible());
+    views.publish();
+    views.update();
+    captureFrame(world, views.front(), stepper.alpha(), frames.back());
+    frames.publish();
+
+    std::thread simThread;
+    if (pipelined) {
+        std::cout << "Physics on its own thread (PHYS_PIPELINE=0 to turn off)" << std::endl;
+        simThread = std::thread([&]() {
+            using Clock = std::chrono::steady_clock;
+            Clock::time_point last = Clock::now();
+            while (running.load(std::memory_order_acquire)) {
+                if (saveRequested.load(std::memory_order_acquire)) {
+                    writeSnapshot();
+                    saveRequested.store(false, std::memory_order_release);
+                }
 
-        makeBubble(
-            sf::Vector2f(static_cast<float>(rand_x),  static_cast<float>(rand_y)),
-            sf::Vector2f(static_cast<float>(rand_vx), static_cast<float>(rand_vy))
-        );
-    }
+                const Clock::time_point now = Clock::now();
+                const float dt = std::chrono::duration<float>(now - last).count();
+                last = now;
+                if (stepper.advance(world, dt) > 0) publishStep();
+                simNanos.fetch_add(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - now).count()),
+                    std::memory_order_relaxed);
 
-    for (auto& b : bubbles) {
-        b.updateShine(window.getSize());
+                // sleep until the next step is due
+                std::this_thread::sleep_for(std::chrono::duration<float>((1.f - stepper.alpha()) * stepDt));
+            }
+        });
     }
 
     sf::Clock clock;
-    float elapsedTime = 0.f;
 
     while (window.isOpen()) {
         while (const std::optional event = window.pollEvent()) {
             if (event->is<sf::Event::Closed>()) {
                 window.close();
             }
-        }
-
-        float dt = clock.restart().asSeconds();
-        elapsedTime += dt;
-
-        for (auto& b : bubbles) {
-            b.age += dt;
-        }
-
-        // ---- Movement + walls ----
-        for (auto& b : bubbles) {
-            sf::Vector2f pos = b.main.getPosition();
-            pos += b.velocity * dt;
-
-            if (pos.x < 0) {
-                pos.x = 0;
-                b.velocity.x = -b.velocity.x * restitution_wall;
+            else if (camera.handle(*event, window)) {
             }
-            else if (pos.x + 2 * b.radius > WINDOW_WIDTH) {
-                pos.x = WINDOW_WIDTH - 2 * b.radius;
-                b.velocity.x = -b.velocity.x * restitution_wall;
-            }
-
-            if (pos.y < 0) {
-                pos.y = 0;
-                b.velocity.y = -b.velocity.y * restitution_wall;
-            }
-            else if (pos.y + 2 * b.radius > WINDOW_HEIGHT) {
-                pos.y = WINDOW_HEIGHT - 2 * b.radius;
-                b.velocity.y = -b.velocity.y * restitution_wall;
-            }
-
-            b.main.setPosition(pos);
-        }
-
-        // ---- Global slow-pop ----
-        {
-            std::vector<Bubble> stillMoving;
-            stillMoving.reserve(bubbles.size());
-
-            for (auto& b : bubbles) {
-                float speed = length(b.velocity);
-
-                if (b.age > 0.5f && speed < 15.f && (rand() % 5 == 0)) {
-                    makePopRing(b);
-                } else {
-                    stillMoving.push_back(b);
+            else if (const auto* key = event->getIf<sf::Event::KeyPressed>()) {
+                if (key->code == sf::Keyboard::Key::F1) overlay.toggle();
+                if (key->code == sf::Keyboard::Key::F5) {
+                    if (!pipelined) {
+                        copyRings();
+                        writeSnapshot();
+                    } else if (!saveRequested.load(std::memory_order_acquire)) {
+                        copyRings();
+                        saveRequested.store(true, std::memory_order_release);
+                    }
                 }
             }
-
-            bubbles.swap(stillMoving);
         }
 
-        // ---- Collision handling ----
-        std::vector<bool> alive(bubbles.size(), true);
-        std::vector<Bubble> mergedToAdd;
-
-        for (std::size_t i = 0; i < bubbles.size(); i++) {
-            if (!alive[i]) continue;
-
-            for (std::size_t j = i + 1; j < bubbles.size(); j++) {
-                if (!alive[j]) continue;
-
-                Bubble& A = bubbles[i];
-                Bubble& B = bubbles[j];
-
-                sf::Vector2f centerA = A.main.getPosition() + sf::Vector2f(A.radius, A.radius);
-                sf::Vector2f centerB = B.main.getPosition() + sf::Vector2f(B.radius, B.radius);
-
-                sf::Vector2f delta = centerB - centerA;
-                float dist = length(delta);
-                float minDist = A.radius + B.radius;
-
-                if (dist > 0 && dist < minDist) {
-                    float speedA = length(A.velocity);
-                    float speedB = length(B.velocity);
-
-                    if (A.age > 0.7f && B.age > 0.7f && speedA < 20.f && speedB < 20.f && (rand() % 6 == 0)) {
-                        makePopRing(A);
-                        makePopRing(B);
-
-                        alive[i] = false;
-                        alive[j] = false;
-                        continue;
-                    }
-
-                    bool pairCanMerge = (A.canMerge && B.canMerge);
-                    bool doMerge = pairCanMerge && (rand() % 120 == 0);
-
-                    if (doMerge) {
-                        float newRadius = A.radius + B.radius;
-
-                        float wA = A.radius;
-                        float wB = B.radius;
-                        float wSum = wA + wB;
-
-                        sf::Vector2f newCenter = (centerA * wA + centerB * wB) * (1.f / wSum);
-                        sf::Vector2f newPos    = newCenter - sf::Vector2f(newRadius, newRadius);
-                        sf::Vector2f newVel    = (A.velocity * wA + B.velocity * wB) * (1.f / wSum);
-
-                        sf::Color cA = A.main.getFillColor();
-                        sf::Color cB = B.main.getFillColor();
-
-                        auto blendChannel = [&](std::uint8_t a, std::uint8_t b) -> std::uint8_t {
-                            float ca = static_cast<float>(a);
-                            float cb = static_cast<float>(b);
-                            float v  = (ca * wA + cb * wB) / wSum;
-                            if (v < 0.f)   v = 0.f;
-                            if (v > 255.f) v = 255.f;
-                            return static_cast<std::uint8_t>(v);
-                        };
-
-                        sf::Color newCol(
-                            blendChannel(cA.r, cB.r),
-                            blendChannel(cA.g, cB.g),
-                            blendChannel(cA.b, cB.b),
-                            blendChannel(cA.a, cB.a)
-                        );
-
-                        mergedToAdd.emplace_back(newRadius, newPos, newVel, newCol);
-                        mergedToAdd.back().canMerge = false;
-
-                        alive[i] = false;
-                        alive[j] = false;
-                        continue;
-                    }
-
-                    // normal collision
-                    sf::Vector2f n = delta / dist;
-                    sf::Vector2f rel = B.velocity - A.velocity;
-                    float velAlongNormal = dot(rel, n);
+        float dt = clock.restart().asSeconds();
 
-                    if (velAlongNormal < 0) {
-                        float jImpulse = -(1 + restitution_ball) * velAlongNormal / 2.f;
-                        sf::Vector2f impulse = jImpulse * n;
-                        A.velocity -= impulse;
-                        B.velocity += impulse;
-                    }
+        camera.update(dt);
+        const sf::FloatRect view = camera.visible();
+        views.back() = captureRectFor(view);
+        views.publish();
 
-                    float penetration = minDist - dist;
-                    sf::Vector2f correction = 0.5f * penetration * n;
-                    A.main.move(-correction);
-                    B.main.move( correction);
-                }
-            }
+        if (!pipelined && stepper.advance(world, dt) > 0) {
+            publishStep();
+        }
+        frames.update();
+        const BubbleFrame& frame = frames.front();
+
+        // how far between the frame's previous and current positions to draw;
+        // when pipelined, the stepper belongs to the sim thread
+        float alpha;
+        if (pipelined) {
+            PROF_COUNT("sim thread us", simNanos.exchange(0, std::memory_order_relaxed) / 1000);
+            const float since = std::chrono::duration<float>(std::chrono::steady_clock::now() - frame.captured).count();
+            alpha = std::min(frame.alpha + since / stepDt, 1.f);
+        } else {
+            alpha = stepper.alpha();
         }
 
         {
-            std::vector<Bubble> newList;
-            newList.reserve(bubbles.size() + mergedToAdd.size());
-
-            for (std::size_t i = 0; i < bubbles.size(); ++i) {
-                if (alive[i]) newList.push_back(bubbles[i]);
-            }
-            for (auto& nb : mergedToAdd) {
-                newList.push_back(nb);
+            PROF_SCOPE("Pop events");
+            SimEvent e;
+            while (pops.pop(e)) {
+                makePopRing(e);
             }
-            bubbles.swap(newList);
         }
 
         // ---- Pop ring animation ----
-        for (auto& ring : popRings) {
-            ring.age += dt;
-            float t = ring.age / ring.lifetime;
-            if (t > 1.f) t = 1.f;
-
-            float currentRadius = ring.baseRadius * (1.f + 0.4f * t);
-            ring.shape.setRadius(currentRadius);
-            ring.shape.setOrigin(sf::Vector2f(currentRadius, currentRadius));
-
-            sf::Color oc = ring.shape.getOutlineColor();
-            oc.a = static_cast<std::uint8_t>((1.f - t) * 200.f);
-            ring.shape.setOutlineColor(oc);
-        }
-
-        popRings.erase(
-            std::remove_if(popRings.begin(), popRings.end(),
-                           [](const PopRing& r) { return r.age >= r.lifetime; }),
-            popRings.end()
-        );
-
-        // ---- Sound lifetime ----
-        for (auto& as : activeSounds) {
-            as.age += dt;
-        }
-        const float maxSoundAge = 1.0f;
-        activeSounds.erase(
-            std::remove_if(activeSounds.begin(), activeSounds.end(),
-                           [maxSoundAge](const ActiveSound& as) {
-                               return as.age >= maxSoundAge;
-                           }),
-            activeSounds.end()
-        );
-
-        // ---- Update shines ----
-        for (auto& b : bubbles) {
-            b.updateShine(window.getSize());
+        {
+            PROF_SCOPE("Pop ring animation");
+            for (auto& ring : popRings) {
+                ring.age += dt;
+            }
+            popRings.removeIf([](const PopRing& r) { return r.age >= r.lifetime; });
         }
 
             window.clear(sf::Color(180, 220, 255));
             // window.clear(sf::Color::White);
 
-        for (auto& b : bubbles) {
-            if (useShader) {
-                sf::Vector2f center = b.main.getPosition() + sf::Vector2f(b.radius, b.radius);
-                sf::Color col = b.main.getFillColor();
-
-                bubbleShader.setUniform("u_radius", b.radius);
-                bubbleShader.setUniform("u_center", center);  // window coords
-                bubbleShader.setUniform(
-                    "u_color",
-                    sf::Glsl::Vec4(
-                        col.r / 255.f,
-                        col.g / 255.f,
-                        col.b / 255.f,
-                        col.a / 255.f
-                    )
-                );
-                bubbleShader.setUniform("u_time", elapsedTime);
-
-                window.draw(b.main, &bubbleShader);   // shaded body
-            } else {
-                window.draw(b.main);                  // plain body
+        // one vertex array, one draw: bodies, then shines, rings on top
+        {
+            PROF_SCOPE("Render");
+            batch.clear();
+
+            // Bodies and rings entirely off screen cost nothing. Zoomed out,
+            // shines under a few pixels across and the rings are left out.
+            const sf::Vector2f invSize(1.f / view.size.x, 1.f / view.size.y);
+            const float pixels = camera.scale();
+            const float minShineRadius = 4.f / pixels;
+            const bool drawRings = pixels >= 0.35f;
+
+            for (std::size_t i = 0; i < frame.x.size(); i++) {
+                float radius = frame.radius[i];
+                sf::Vector2f center(frame.px[i] + (frame.x[i] - frame.px[i]) * alpha,
+                                    frame.py[i] + (frame.y[i] - frame.py[i]) * alpha);
+                if (!onScreen(center, radius, view)) continue;
+
+                batch.addBody(center, radius, toColor(frame.color[i]));
+                if (radius >= minShineRadius) {
+                    batch.addShine(shines.center(center, radius, view, invSize), radius * 0.35f, shineColor);
+                }
+            }
+
+            for (const auto& ring : popRings) {
+                if (!drawRings) break;
+                float t = std::min(ring.age / ring.lifetime, 1.f);
+                float radius = ring.baseRadius * (1.f + 0.4f * t);
+
+                sf::Color oc = ring.color;
+                oc.a = static_cast<std::uint8_t>((1.f - t) * 200.f);
+                if (oc.a == 0 || !onScreen(ring.center, radius + 3.f, view)) continue;
+                batch.addRing(ring.center, radius, 3.f, oc);
             }
 
-            window.draw(b.shine);                     // highlight on top
+            window.setView(camera.view());
+            batch.draw(window, useShader ? &bubbleShader : nullptr);
         }
 
+        window.setView(window.getDefaultView());
+        overlay.draw(window);
 
-        // pop rings on top
-        for (auto& r : popRings) {
-            window.draw(r.shape);
+        {
+            PROF_SCOPE("Display");
+            window.display();
         }
+        PROF_FRAME();
+    }
 
-        window.display();
+    if (simThread.joinable()) {
+        running.store(false, std::memory_order_release);
+        simThread.join();
     }
     return 0;
 }
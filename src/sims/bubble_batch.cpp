@@ -0,0 +1,128 @@
+#include "bubble_batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+const unsigned int kDisc = 64;          // atlas disc size in pixels
+const unsigned int kSolid = 4;
+
+}
+
+BubbleBatch::BubbleBatch()
+    : vertices(sf::PrimitiveType::Triangles) {
+    const unsigned int W = 2 * kDisc + kSolid;
+    std::vector<std::uint8_t> pixels(W * kDisc * 4, 0);
+
+    auto put = [&](unsigned int x, unsigned int y, std::uint8_t a) {
+        std::uint8_t* p = &pixels[(y * W + x) * 4];
+        p[0] = p[1] = p[2] = 255;
+        p[3] = a;
+    };
+
+    // antialiased disc, one pixel of soft edge
+    const float half = kDisc * 0.5f;
+    for (unsigned int y = 0; y < kDisc; y++) {
+        for (unsigned int x = 0; x < kDisc; x++) {
+            float dx = x + 0.5f - half;
+            float dy = y + 0.5f - half;
+            float a = std::clamp(half - std::sqrt(dx * dx + dy * dy), 0.f, 1.f);
+            auto alpha = static_cast<std::uint8_t>(a * 255.f);
+            put(x, y, alpha);
+            put(x + kDisc, y, alpha);
+        }
+    }
+    for (unsigned int y = 0; y < kSolid; y++) {
+        for (unsigned int x = 0; x < kSolid; x++) {
+            put(2 * kDisc + x, y, 255);
+        }
+    }
+
+    for (int s = 0; s <= ringSegments; s++) {
+        float a = 6.2831853f * s / ringSegments;
+        ringDir[s] = sf::Vector2f(std::cos(a), std::sin(a));
+    }
+
+    sf::Image image(sf::Vector2u(W, kDisc), pixels.data());
+    if (atlas.loadFromImage(image)) {
+        atlas.setSmooth(true);
+    }
+}
+
+void BubbleBatch::clear() {
+    used = 0;
+}
+
+void BubbleBatch::addQuad(sf::Vector2f center, float radius, sf::Color color, float atlasX) {
+    if (vertices.getVertexCount() < used + 6) {
+        vertices.resize(std::max<std::size_t>(used + 6, vertices.getVertexCount() * 2));
+    }
+
+    const float x0 = center.x - radius, x1 = center.x + radius;
+    const float y0 = center.y - radius, y1 = center.y + radius;
+    const float u0 = atlasX, u1 = atlasX + kDisc;
+    const float v0 = 0.f,    v1 = static_cast<float>(kDisc);
+
+    sf::Vertex* v = &vertices[used];
+    v[0] = { {x0, y0}, color, {u0, v0} };
+    v[1] = { {x1, y0}, color, {u1, v0} };
+    v[2] = { {x1, y1}, color, {u1, v1} };
+    v[3] = { {x0, y0}, color, {u0, v0} };
+    v[4] = { {x1, y1}, color, {u1, v1} };
+    v[5] = { {x0, y1}, color, {u0, v1} };
+    used += 6;
+}
+
+void BubbleBatch::addBody(sf::Vector2f center, float radius, sf::Color color) {
+    addQuad(center, radius, color, 0.f);
+}
+
+void BubbleBatch::addShine(sf::Vector2f center, float radius, sf::Color color) {
+    addQuad(center, radius, color, static_cast<float>(kDisc));
+}
+
+// Outline drawn outside the circle, like sf::CircleShape's outline.
+void BubbleBatch::addRing(sf::Vector2f center, float radius, float thickness, sf::Color color) {
+    const std::size_t count = ringSegments * 6;
+    if (vertices.getVertexCount() < used + count) {
+        vertices.resize(std::max(used + count, vertices.getVertexCount() * 2));
+    }
+
+    const sf::Vector2f uv(2.f * kDisc + kSolid * 0.5f, kSolid * 0.5f);
+    const float inner = radius;
+    const float outer = radius + thickness;
+
+    sf::Vertex* v = &vertices[used];
+    for (int s = 0; s < ringSegments; s++) {
+        const sf::Vector2f d0 = ringDir[s];
+        const sf::Vector2f d1 = ringDir[s + 1];
+
+        sf::Vector2f i0 = center + d0 * inner, o0 = center + d0 * outer;
+        sf::Vector2f i1 = center + d1 * inner, o1 = center + d1 * outer;
+
+        *v++ = { i0, color, uv };
+        *v++ = { o0, color, uv };
+        *v++ = { o1, color, uv };
+        *v++ = { i0, color, uv };
+        *v++ = { o1, color, uv };
+        *v++ = { i1, color, uv };
+    }
+    used += count;
+}
+
+void BubbleBatch::draw(sf::RenderTarget& target, sf::Shader* shader) {
+    if (used == 0) return;
+
+    sf::RenderStates states;
+    states.texture = &atlas;
+    if (shader) {
+        shader->setUniform("u_texture", sf::Shader::CurrentTexture);
+        shader->setUniform("u_atlas", sf::Glsl::Vec2(static_cast<float>(2 * kDisc + kSolid),
+                                                     static_cast<float>(kDisc)));
+        states.shader = shader;
+    }
+    target.draw(&vertices[0], used, sf::PrimitiveType::Triangles, states);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+// Collects every bubble body, shine and pop ring of a frame into one
+// sf::VertexArray of triangles, drawn with a single draw call.
+//
+// All quads sample a small generated atlas:
+//   [0, D)     body disc
+//   [D, 2D)    shine disc (same image; a separate region so bubble.frag can
+//              tell shines from bodies)
+//   [2D, 2D+4) solid white, used by the ring geometry
+// Per-instance color rides in the vertex color, so with the shader on,
+// bubble.frag shades every body in the same draw.
+class BubbleBatch {
+public:
+    BubbleBatch();
+
+    void clear();
+
+    void addBody(sf::Vector2f center, float radius, sf::Color color);
+    void addShine(sf::Vector2f center, float radius, sf::Color color);
+    void addRing(sf::Vector2f center, float radius, float thickness, sf::Color color);
+
+    // shader may be null; it gets u_texture and u_atlas set here.
+    void draw(sf::RenderTarget& target, sf::Shader* shader);
+
+    std::size_t vertexCount() const { return vertices.getVertexCount(); }
+
+    static const int ringSegments = 32;
+
+private:
+    void addQuad(sf::Vector2f center, float radius, sf::Color color, float atlasX);
+
+    sf::Texture atlas;
+    sf::VertexArray vertices;
+    std::size_t used = 0;
+    sf::Vector2f ringDir[ringSegments + 1];     // unit circle, computed once
+};
@@ -0,0 +1,105 @@
+#include "camera.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const unsigned int kMaxWindowWidth  = 1600;
+const unsigned int kMaxWindowHeight = 1000;
+const float kMinZoom = 1.f / 8.f;       // 8 pixels per world unit
+const float kPanSpeed = 900.f;          // window pixels per second
+
+}
+
+sf::Vector2u windowSizeFor(float worldWidth, float worldHeight) {
+    return sf::Vector2u(std::min(static_cast<unsigned int>(worldWidth), kMaxWindowWidth),
+                        std::min(static_cast<unsigned int>(worldHeight), kMaxWindowHeight));
+}
+
+Camera::Camera(sf::Vector2f worldSize, sf::Vector2u windowSize)
+    : world_(worldSize),
+      window_(static_cast<float>(windowSize.x), static_cast<float>(windowSize.y)) {
+    // one world unit per pixel, from the top-left corner like a window
+    // the size of the world
+    view_.setSize(window_);
+    view_.setCenter(window_ * 0.5f);
+    clamp();
+}
+
+bool Camera::handle(const sf::Event& event, const sf::RenderWindow& window) {
+    if (const auto* wheel = event.getIf<sf::Event::MouseWheelScrolled>()) {
+        if (wheel->wheel != sf::Mouse::Wheel::Vertical) return false;
+        // the point under the cursor stays put
+        const sf::Vector2f before = window.mapPixelToCoords(wheel->position, view_);
+        setZoom(zoom_ * std::pow(0.85f, wheel->delta));
+        const sf::Vector2f after = window.mapPixelToCoords(wheel->position, view_);
+        view_.move(before - after);
+        clamp();
+        return true;
+    }
+    if (const auto* press = event.getIf<sf::Event::MouseButtonPressed>()) {
+        if (press->button != sf::Mouse::Button::Left) return false;
+        dragging_ = true;
+        dragFrom_ = press->position;
+        return true;
+    }
+    if (const auto* release = event.getIf<sf::Event::MouseButtonReleased>()) {
+        if (release->button != sf::Mouse::Button::Left) return false;
+        dragging_ = false;
+        return true;
+    }
+    if (const auto* move = event.getIf<sf::Event::MouseMoved>()) {
+        if (!dragging_) return false;
+        const sf::Vector2i d = move->position - dragFrom_;
+        view_.move(sf::Vector2f(static_cast<float>(-d.x), static_cast<float>(-d.y)) * zoom_);
+        dragFrom_ = move->position;
+        clamp();
+        return true;
+    }
+    if (const auto* resized = event.getIf<sf::Event::Resized>()) {
+        window_ = sf::Vector2f(static_cast<float>(resized->size.x), static_cast<float>(resized->size.y));
+        setZoom(zoom_);
+        clamp();
+        return true;
+    }
+    if (const auto* key = event.getIf<sf::Event::KeyPressed>()) {
+        if (key->code != sf::Keyboard::Key::Home) return false;
+        setZoom(std::max(world_.x / window_.x, world_.y / window_.y));
+        view_.setCenter(world_ * 0.5f);
+        clamp();
+        return true;
+    }
+    return false;
+}
+
+void Camera::update(float dt) {
+    using Key = sf::Keyboard::Key;
+    sf::Vector2f dir;
+    if (sf::Keyboard::isKeyPressed(Key::Left)  || sf::Keyboard::isKeyPressed(Key::A)) dir.x -= 1.f;
+    if (sf::Keyboard::isKeyPressed(Key::Right) || sf::Keyboard::isKeyPressed(Key::D)) dir.x += 1.f;
+    if (sf::Keyboard::isKeyPressed(Key::Up)    || sf::Keyboard::isKeyPressed(Key::W)) dir.y -= 1.f;
+    if (sf::Keyboard::isKeyPressed(Key::Down)  || sf::Keyboard::isKeyPressed(Key::S)) dir.y += 1.f;
+    if (dir.x == 0.f && dir.y == 0.f) return;
+    view_.move(dir * (kPanSpeed * zoom_ * dt));
+    clamp();
+}
+
+sf::FloatRect Camera::visible() const {
+    return sf::FloatRect(view_.getCenter() - view_.getSize() * 0.5f, view_.getSize());
+}
+
+// Zooming out stops once the whole world is in view.
+void Camera::setZoom(float zoom) {
+    const float fit = std::max({ world_.x / window_.x, world_.y / window_.y, 1.f });
+    zoom_ = std::min(std::max(zoom, kMinZoom), fit);
+    view_.setSize(window_ * zoom_);
+}
+
+void Camera::clamp() {
+    const sf::Vector2f size = view_.getSize();
+    sf::Vector2f c = view_.getCenter();
+    c.x = size.x >= world_.x ? world_.x * 0.5f : std::min(std::max(c.x, size.x * 0.5f), world_.x - size.x * 0.5f);
+    c.y = size.y >= world_.y ? world_.y * 0.5f : std::min(std::max(c.y, size.y * 0.5f), world_.y - size.y * 0.5f);
+    view_.setCenter(c);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+// Window size for a world: the whole world when it fits on a common
+// screen, else a screenful of it.
+sf::Vector2u windowSizeFor(float worldWidth, float worldHeight);
+
+// An sf::View over a world that may be much bigger than the window. The
+// mouse wheel zooms about the cursor, dragging with the left button or the
+// arrow keys / WASD pan, Home shows the whole world. The view stays over the
+// world; zoomed out past it, the world is centered.
+class Camera {
+public:
+    Camera(sf::Vector2f worldSize, sf::Vector2u windowSize);
+
+    // Returns true if the event moved the camera.
+    bool handle(const sf::Event& event, const sf::RenderWindow& window);
+    // Keyboard panning; call once per frame.
+    void update(float dt);
+
+    const sf::View& view() const { return view_; }
+
+    // World rectangle the window shows.
+    sf::FloatRect visible() const;
+    // Window pixels per world unit.
+    float scale() const { return 1.f / zoom_; }
+
+private:
+    void setZoom(float zoom);
+    void clamp();
+
+    sf::Vector2f world_;
+    sf::Vector2f window_;
+    sf::View view_;
+    float zoom_ = 1.f;              // world units per pixel
+    bool dragging_ = false;
+    sf::Vector2i dragFrom_;
+};
@@ -0,0 +1,26 @@
+#include "pop_stream.hpp"
+
+namespace {
+
+// ~10 ms at 48 kHz; SFML keeps a few of these queued, which sets the latency
+const std::size_t kChunkFrames = 512;
+
+} // namespace
+
+PopStream::PopStream(PopMixer& mixer) : mixer(mixer), buffer(kChunkFrames * PopMixer::kChannels) {
+    initialize(PopMixer::kChannels, mixer.sampleRate(),
+               { sf::SoundChannel::FrontLeft, sf::SoundChannel::FrontRight });
+}
+
+PopStream::~PopStream() {
+    stop();
+}
+
+// Never runs dry: silence is mixed like anything else, so the stream keeps
+// playing between pops.
+bool PopStream::onGetData(Chunk& data) {
+    mixer.mix(buffer.data(), kChunkFrames);
+    data.samples = buffer.data();
+    data.sampleCount = buffer.size();
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "../core/audio_mixer.hpp"
+
+// Plays a PopMixer through one sf::SoundStream, so every pop shares a single
+// audio source. SFML calls onGetData() on its own streaming thread; that is
+// where the mixing happens, off the frame.
+class PopStream : public sf::SoundStream {
+public:
+    explicit PopStream(PopMixer& mixer);
+    ~PopStream() override;     // stops the stream before the mixer can go away
+
+private:
+    bool onGetData(Chunk& data) override;
+    void onSeek(sf::Time) override {}
+
+    PopMixer& mixer;
+    std::vector<std::int16_t> buffer;
+};
@@ -0,0 +1,103 @@
+#include "profiler_overlay.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "../core/profiler.hpp"
+
+namespace {
+
+const float kBudgetMs = 10.f;       // one 100 Hz frame
+const float kBarWidth = 260.f;
+const float kRowHeight = 16.f;     // without a font
+const unsigned int kTextSize = 12;
+
+const char* const kFonts[] = {
+    "assets/font.ttf",
+    "/System/Library/Fonts/Supplemental/Arial.ttf",
+    "/System/Library/Fonts/Helvetica.ttc",
+    "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+    "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+    "C:/Windows/Fonts/consola.ttf",
+};
+
+}
+
+ProfilerOverlay::ProfilerOverlay() {
+    for (const char* path : kFonts) {
+        if (font_.openFromFile(path)) {
+            hasFont_ = true;
+            text_ = std::make_unique<sf::Text>(font_, "", kTextSize);
+            text_->setFillColor(sf::Color::White);
+            break;
+        }
+    }
+}
+
+void ProfilerOverlay::toggle() {
+    visible_ = !visible_;
+    if (visible_) Profiler::get().setEnabled(true);
+}
+
+void ProfilerOverlay::draw(sf::RenderTarget& target) {
+    if (!visible_) return;
+
+    const auto sections = Profiler::get().sectionStats();
+    const auto counters = Profiler::get().counterStats();
+
+    const float x0 = 10.f, y0 = 10.f;
+    // bars line up with the text rows when there is text
+    const float rowH = hasFont_ ? font_.getLineSpacing(kTextSize) : kRowHeight;
+    const float labelW = hasFont_ ? 230.f : 0.f;
+    const float rows = static_cast<float>(sections.size() + (hasFont_ ? counters.size() : 0));
+
+    rect_.setOutlineThickness(0.f);
+    rect_.setFillColor(sf::Color(0, 0, 0, 170));
+    rect_.setPosition(sf::Vector2f(x0 - 6.f, y0 - 6.f));
+    rect_.setSize(sf::Vector2f(labelW + kBarWidth + 12.f, rows * rowH + 12.f));
+    target.draw(rect_);
+
+    // budget line
+    rect_.setFillColor(sf::Color(255, 80, 80, 200));
+    rect_.setPosition(sf::Vector2f(x0 + labelW + kBarWidth, y0));
+    rect_.setSize(sf::Vector2f(1.f, sections.size() * rowH));
+    target.draw(rect_);
+
+    for (std::size_t i = 0; i < sections.size(); i++) {
+        const auto& s = sections[i];
+        float y = y0 + i * rowH;
+
+        rect_.setOutlineThickness(0.f);
+        rect_.setFillColor(sf::Color(120, 200, 255));
+        rect_.setPosition(sf::Vector2f(x0 + labelW, y + 3.f));
+        rect_.setSize(sf::Vector2f(std::min(static_cast<float>(s.p50) / kBudgetMs, 1.f) * kBarWidth, rowH - 6.f));
+        target.draw(rect_);
+
+        rect_.setFillColor(sf::Color::Transparent);
+        rect_.setOutlineColor(sf::Color(255, 220, 120));
+        rect_.setOutlineThickness(1.f);
+        rect_.setSize(sf::Vector2f(std::min(static_cast<float>(s.p95) / kBudgetMs, 1.f) * kBarWidth, rowH - 6.f));
+        target.draw(rect_);
+    }
+
+    if (!hasFont_) return;
+
+    // text only needs refreshing a few times a second
+    if (lines_.empty() || refresh_.getElapsedTime().asSeconds() > 0.25f) {
+        refresh_.restart();
+        lines_.clear();
+        char buf[128];
+        for (const auto& s : sections) {
+            std::snprintf(buf, sizeof(buf), "%-18s %5.2f / %5.2f ms\n", s.name.c_str(), s.p50, s.p95);
+            lines_ += buf;
+        }
+        for (const auto& c : counters) {
+            std::snprintf(buf, sizeof(buf), "%-18s %9.0f /frame\n", c.name.c_str(), c.mean);
+            lines_ += buf;
+        }
+    }
+
+    text_->setString(lines_);
+    text_->setPosition(sf::Vector2f(x0, y0));
+    target.draw(*text_);
+}
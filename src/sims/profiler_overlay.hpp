@@ -0,0 +1,28 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <memory>
+
+// On-screen view of Profiler data: one bar per section (p50 solid, p95
+// outline) against a frame budget, plus text when a system font is found.
+// Toggle with F1 in the sims.
+class ProfilerOverlay {
+public:
+    ProfilerOverlay();
+
+    bool visible() const { return visible_; }
+    // Showing the overlay also switches the profiler on.
+    void toggle();
+
+    void draw(sf::RenderTarget& target);
+
+private:
+    bool visible_ = false;
+    bool hasFont_ = false;
+    sf::Font font_;
+    std::unique_ptr<sf::Text> text_;
+    sf::RectangleShape rect_;
+    sf::Clock refresh_;
+    std::string lines_;
+};
@@ -0,0 +1,223 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../core/json.hpp"
+#include "../core/scenario_file.hpp"
+#include "../core/scenarios.hpp"
+#include "../core/thread_pool.hpp"
+#include "../core/world_batch.hpp"
+
+// Runs every scenario in a file (see scenario_file.hpp), one world per
+// worker thread, and appends one line of summary metrics per run.
+//
+//   ./physicSimsBatch sweep.json [--out results.jsonl] [--workers N] [--lockstep] [--list]
+//
+// Results are JSON lines, written as each run finishes: the run's scenario
+// with every config field spelled out, then its metrics. Runs already in the
+// output file are skipped, so an interrupted sweep picks up where it
+// stopped when started again. Each world steps on its own thread: the
+// parallelism is across runs, which scales better than splitting one
+// small world's collision search. --list prints the run names and exits.
+//
+// With --lockstep, consecutive runs with the same steps and dt are stepped
+// together in a WorldBatch, up to kLockstepRuns at a time, several small
+// worlds per SIMD instruction. Results are the same bit for bit; wall_ms
+// and us_per_step are then the batch's time shared out evenly. Runs the
+// batch can't do (swept collision, iterative solver, sleeping, periodic)
+// run alone.
+
+using namespace std;
+
+namespace {
+
+// Names of the runs an earlier, possibly interrupted, batch already wrote.
+set<string> finishedRuns(const string& path) {
+    set<string> names;
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        JsonValue r;
+        if (parseJson(line, r)) names.insert(r.get("name", ""));
+    }
+    return names;
+}
+
+const size_t kLockstepRuns = 64;
+
+bool lockstepCapable(const WorldConfig& cfg) {
+    return !cfg.ccd && cfg.solverIterations == 0 && !cfg.sleeping && !cfg.periodic;
+}
+
+JsonValue summarize(const Scenario& sc, const World& world, size_t startBodies, double secs) {
+    const BodyStore& s = world.bodies();
+    double energy = 0.0;
+    for (size_t i = 0; i < s.size(); i++) {
+        energy += 0.5 * massOf(s.radius[i]) * (s.vx[i] * s.vx[i] + s.vy[i] * s.vy[i]);
+    }
+
+    const WorldStats& st = world.stats();
+    const double steps = max(1, sc.steps);
+
+    JsonValue r = scenarioToJson(sc);
+    r.set("start_bodies", static_cast<double>(startBodies));
+    r.set("final_bodies", static_cast<double>(s.size()));
+    r.set("pops", static_cast<double>(st.pops));
+    r.set("merges", static_cast<double>(st.merges));
+    r.set("contacts_per_step", static_cast<double>(st.contacts) / steps);
+    r.set("swept_hits", static_cast<double>(st.sweptHits));
+    r.set("asleep", static_cast<double>(world.sleepingCount()));
+    r.set("kinetic_energy", energy);
+    r.set("wall_ms", secs * 1e3);
+    r.set("us_per_step", secs * 1e6 / steps);
+    return r;
+}
+
+unique_ptr<World> spawnScenario(const Scenario& sc) {
+    WorldConfig cfg = sc.config;
+    cfg.threads = 1;
+    unique_ptr<World> world(new World(cfg));
+    spawnBodies(*world, sc.count);
+    return world;
+}
+
+// Runs todo[begin, end) and returns a result per run, in order.
+vector<JsonValue> runChunk(const vector<const Scenario*>& todo, size_t begin, size_t end) {
+    vector<JsonValue> results;
+    vector<unique_ptr<World>> worlds;
+    vector<size_t> startBodies;
+    for (size_t k = begin; k < end; k++) {
+        worlds.push_back(spawnScenario(*todo[k]));
+        startBodies.push_back(worlds.back()->bodies().size());
+    }
+
+    if (end - begin == 1) {
+        const Scenario& sc = *todo[begin];
+        auto t0 = chrono::steady_clock::now();
+        worlds[0]->run(sc.steps, sc.dt);
+        auto t1 = chrono::steady_clock::now();
+        results.push_back(summarize(sc, *worlds[0], startBodies[0], chrono::duration<double>(t1 - t0).count()));
+        return results;
+    }
+
+    WorldBatch batch;
+    for (const auto& w : worlds) batch.add(*w);
+    auto t0 = chrono::steady_clock::now();
+    batch.run(todo[begin]->steps, todo[begin]->dt);
+    auto t1 = chrono::steady_clock::now();
+    const double share = chrono::duration<double>(t1 - t0).count() / static_cast<double>(end - begin);
+
+    for (size_t k = begin; k < end; k++) {
+        batch.copyTo(k - begin, *worlds[k - begin]);
+        results.push_back(summarize(*todo[k], *worlds[k - begin], startBodies[k - begin], share));
+    }
+    return results;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    string scenarioPath, outPath = "results.jsonl";
+    int workers = 0;
+    bool list = false, lockstep = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string val = i + 1 < argc ? argv[i + 1] : "";
+        if      (arg == "--out")     { outPath = val; i++; }
+        else if (arg == "--workers") { workers = atoi(val.c_str()); i++; }
+        else if (arg == "--list")    { list = true; }
+        else if (arg == "--lockstep") { lockstep = true; }
+        else if (scenarioPath.empty() && arg.rfind("--", 0) != 0) scenarioPath = arg;
+        else {
+            cerr << "Unknown argument '" << arg << "'\n";
+            return 2;
+        }
+    }
+    if (scenarioPath.empty()) {
+        cerr << "Usage: physicSimsBatch <scenarios.json> [--out results.jsonl] [--workers N] [--lockstep] [--list]\n";
+        return 2;
+    }
+
+    vector<Scenario> all;
+    string error;
+    if (!loadScenarios(scenarioPath, all, &error)) {
+        cerr << error << "\n";
+        return 1;
+    }
+    if (list) {
+        for (const Scenario& sc : all) cout << sc.name << "\n";
+        return 0;
+    }
+
+    const set<string> done = finishedRuns(outPath);
+    vector<const Scenario*> todo;
+    for (const Scenario& sc : all) {
+        if (!done.count(sc.name)) todo.push_back(&sc);
+    }
+
+    ofstream out(outPath, ios::app);
+    if (!out) {
+        cerr << "Failed to open " << outPath << "\n";
+        return 1;
+    }
+
+    // chunks of todo, one run each unless stepped in lockstep
+    vector<size_t> chunkStart;
+    for (size_t k = 0; k < todo.size(); k++) {
+        const Scenario& sc = *todo[k];
+        bool joins = false;
+        if (lockstep && !chunkStart.empty() && lockstepCapable(sc.config)) {
+            const Scenario& first = *todo[chunkStart.back()];
+            joins = lockstepCapable(first.config) && first.steps == sc.steps && first.dt == sc.dt &&
+                    k - chunkStart.back() < kLockstepRuns;
+        }
+        if (!joins) chunkStart.push_back(k);
+    }
+    chunkStart.push_back(todo.size());
+    const size_t chunks = chunkStart.size() - 1;
+
+    ThreadPool pool(workers);
+    cout << todo.size() << " runs (" << all.size() - todo.size() << " already in " << outPath
+         << ") on " << pool.size() << " workers\n";
+
+    // runs vary a lot in length, so workers take the next one when free
+    // rather than splitting the list up front
+    atomic<size_t> next{ 0 };
+    size_t finished = 0;
+    mutex outMutex;
+    bool writeFailed = false;
+
+    auto t0 = chrono::steady_clock::now();
+    pool.parallelFor(static_cast<size_t>(pool.size()), [&](size_t, size_t) {
+        for (size_t c; (c = next.fetch_add(1)) < chunks;) {
+            vector<JsonValue> results = runChunk(todo, chunkStart[c], chunkStart[c + 1]);
+
+            lock_guard<mutex> lock(outMutex);
+            for (const JsonValue& r : results) {
+                out << toJson(r, 0) << "\n";
+                finished++;
+                cout << "[" << finished << "/" << todo.size() << "] " << r.get("name", "") << ": "
+                     << r.get("us_per_step", 0.0) << " us/step, "
+                     << r.get("final_bodies", 0.0) << " bodies\n";
+            }
+            out.flush();
+            if (!out) writeFailed = true;
+        }
+    });
+    auto t1 = chrono::steady_clock::now();
+
+    if (writeFailed) {
+        cerr << "Failed to write " << outPath << "\n";
+        return 1;
+    }
+    cout << "done in " << chrono::duration<double>(t1 - t0).count() << " s, results in " << outPath << "\n";
+    return 0;
+}
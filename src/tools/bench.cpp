@@ -0,0 +1,236 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../core/json.hpp"
+#include "../core/scenarios.hpp"
+
+// Headless benchmark for the ball and bubble physics.
+//
+//   ./physicSimsBench [--sims balls,bubbles] [--bodies 100,1000,...]
+//                     [--steps 50,...] [--threads 1,...] [--seed N]
+//                     [--out results.json]
+//                     [--compare baseline.json] [--threshold 0.25]
+//
+// Every (sim, bodies, steps, threads) combination gets a fresh world whose
+// size grows with the body count, so density matches the stock scene. Each
+// phase is reported in ns per body per step. With --compare, the run fails
+// (exit code 1) if any phase is slower than the baseline by more than the
+// threshold.
+
+using namespace std;
+
+namespace {
+
+vector<long> parseList(const string& s) {
+    vector<long> out;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(static_cast<long>(atof(item.c_str())));
+    }
+    return out;
+}
+
+vector<string> parseNames(const string& s) {
+    vector<string> out;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+string resultKey(const JsonValue& r) {
+    ostringstream os;
+    os << r.get("sim", "?") << "/n=" << static_cast<long>(r.get("bodies", 0.0))
+       << "/steps=" << static_cast<long>(r.get("steps", 0.0))
+       << "/threads=" << static_cast<long>(r.get("threads", 0.0));
+    return os.str();
+}
+
+JsonValue runCase(const string& sim, long bodies, long steps, long threads, unsigned long long seed) {
+    bool balls = (sim == "balls");
+    WorldConfig cfg = balls ? bouncyBallConfig(false) : bouncyBubbleConfig();
+
+    // stock scenes hold ~60 balls / ~110 bubbles; keep that density
+    const double stockCount = balls ? 60.0 : 110.0;
+    const double grow = sqrt(max(1.0, bodies / stockCount));
+    cfg.width  = floor(cfg.width  * grow);
+    cfg.height = floor(cfg.height * grow);
+    cfg.threads = static_cast<int>(threads);
+    cfg.seed = seed;
+    cfg.timePhases = true;
+
+    World world(cfg);
+    if (balls) spawnBouncyBalls(world, static_cast<int>(bodies));
+    else       spawnBubbles(world, static_cast<int>(bodies));
+
+    const float dt = 1.f / 100.f;
+    world.run(5, dt);     // warm-up: scratch buffers, caches
+
+    WorldStats before = world.stats();
+    double bodySteps = 0.0;
+
+    auto t0 = chrono::steady_clock::now();
+    for (long s = 0; s < steps; s++) {
+        bodySteps += static_cast<double>(world.bodies().size());
+        world.step(dt);
+        world.clearEvents();
+    }
+    auto t1 = chrono::steady_clock::now();
+
+    if (bodySteps <= 0.0) bodySteps = 1.0;
+    const WorldStats& after = world.stats();
+
+    JsonValue r = JsonValue::makeObject();
+    r.set("sim", sim);
+    r.set("bodies", static_cast<double>(bodies));
+    r.set("steps", static_cast<double>(steps));
+    r.set("threads", static_cast<double>(threads));
+    r.set("simd", simdLevelName(cfg.simd));
+
+    JsonValue phases = JsonValue::makeObject();
+    for (int p = 0; p < static_cast<int>(Phase::Count); p++) {
+        double secs = after.phaseSeconds[p] - before.phaseSeconds[p];
+        phases.set(phaseName(static_cast<Phase>(p)), secs * 1e9 / bodySteps);
+    }
+    r.set("ns_per_body_step", phases);
+    r.set("total_ns_per_body_step", chrono::duration<double>(t1 - t0).count() * 1e9 / bodySteps);
+    r.set("contacts_per_step", static_cast<double>(after.contacts - before.contacts) / max(1L, steps));
+    r.set("final_bodies", static_cast<double>(world.bodies().size()));
+    return r;
+}
+
+// Returns the number of regressions.
+int compare(const JsonValue& current, const JsonValue& baseline, double threshold) {
+    // Phases under this many ns/body/step are timer noise, not regressions.
+    const double floorNs = 1.0;
+    int regressions = 0;
+
+    for (const JsonValue& cur : current.array) {
+        const string key = resultKey(cur);
+        const JsonValue* base = nullptr;
+        for (const JsonValue& b : baseline.array) {
+            if (resultKey(b) == key) { base = &b; break; }
+        }
+        if (!base) {
+            cout << "  " << key << ": no baseline\n";
+            continue;
+        }
+
+        const JsonValue* cp = cur.find("ns_per_body_step");
+        const JsonValue* bp = base->find("ns_per_body_step");
+        if (!cp || !bp) continue;
+
+        for (const auto& kv : cp->object) {
+            double now = kv.second.number;
+            double was = bp->get(kv.first, -1.0);
+            if (was < 0.0 || max(now, was) < floorNs) continue;
+
+            double change = (now - was) / max(was, 1e-9);
+            if (change > threshold) {
+                cout << "  REGRESSION " << key << " " << kv.first << ": "
+                     << fixed << setprecision(2) << was << " -> " << now
+                     << " ns/body/step (+" << setprecision(0) << change * 100 << "%)\n";
+                regressions++;
+            }
+        }
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    vector<string> sims = { "balls", "bubbles" };
+    vector<long> bodyCounts = { 100, 1000, 10000, 100000, 1000000 };
+    vector<long> stepCounts = { 50 };
+    vector<long> threadCounts = { 1 };
+    unsigned long long seed = 1;
+    string outPath, comparePath;
+    double threshold = 0.25;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string val = i + 1 < argc ? argv[i + 1] : "";
+        if      (arg == "--sims")      { sims = parseNames(val); i++; }
+        else if (arg == "--bodies")    { bodyCounts = parseList(val); i++; }
+        else if (arg == "--steps")     { stepCounts = parseList(val); i++; }
+        else if (arg == "--threads")   { threadCounts = parseList(val); i++; }
+        else if (arg == "--seed")      { seed = strtoull(val.c_str(), nullptr, 10); i++; }
+        else if (arg == "--out")       { outPath = val; i++; }
+        else if (arg == "--compare")   { comparePath = val; i++; }
+        else if (arg == "--threshold") { threshold = atof(val.c_str()); i++; }
+        else {
+            cerr << "Unknown argument '" << arg << "'\n";
+            return 2;
+        }
+    }
+
+    JsonValue results = JsonValue::makeArray();
+
+    cout << left << setw(10) << "sim" << setw(10) << "bodies" << setw(7) << "steps"
+         << setw(9) << "threads";
+    for (int p = 0; p < static_cast<int>(Phase::Count); p++) {
+        cout << setw(13) << phaseName(static_cast<Phase>(p));
+    }
+    cout << "total (ns/body/step)\n";
+
+    for (const string& sim : sims) {
+        if (sim != "balls" && sim != "bubbles") {
+            cerr << "Unknown sim '" << sim << "' (balls, bubbles)\n";
+            return 2;
+        }
+        for (long n : bodyCounts) {
+            for (long steps : stepCounts) {
+                for (long threads : threadCounts) {
+                    JsonValue r = runCase(sim, n, steps, threads, seed);
+
+                    cout << left << setw(10) << sim << setw(10) << n << setw(7) << steps
+                         << setw(9) << threads << fixed << setprecision(2);
+                    for (const auto& kv : r.find("ns_per_body_step")->object) {
+                        cout << setw(13) << kv.second.number;
+                    }
+                    cout << r.get("total_ns_per_body_step", 0.0) << "\n";
+
+                    results.push(r);
+                }
+            }
+        }
+    }
+
+    if (!outPath.empty()) {
+        ofstream out(outPath);
+        out << toJson(results) << "\n";
+        if (!out) {
+            cerr << "Failed to write " << outPath << "\n";
+            return 2;
+        }
+    }
+
+    if (!comparePath.empty()) {
+        JsonValue baseline;
+        string error;
+        if (!loadJsonFile(comparePath, baseline, &error) || !baseline.isArray()) {
+            cerr << "Failed to read baseline " << comparePath << ": " << error << "\n";
+            return 2;
+        }
+        cout << "Comparing against " << comparePath << " (threshold "
+             << threshold * 100 << "%)\n";
+        int regressions = compare(results, baseline, threshold);
+        if (regressions > 0) {
+            cout << regressions << " phase(s) regressed\n";
+            return 1;
+        }
+        cout << "No regressions\n";
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "bubble_raster.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const Rgba kBackground{ 180, 220, 255, 255 };
+const Rgba kShine{ 220, 240, 255, 180 };
+
+const float kRingLifetime = 0.35f;
+const float kRingThickness = 3.f;
+
+// Alpha of the atlas disc at distance x (0 center, 1 edge): the atlas is
+// 64 px wide with one pixel of soft edge, i.e. 1/32 of the radius.
+float discAlpha(float x) {
+    return std::clamp((1.f - x) * 32.f, 0.f, 1.f);
+}
+
+float smoothstep(float e0, float e1, float x) {
+    float t = std::clamp((x - e0) / (e1 - e0), 0.f, 1.f);
+    return t * t * (3.f - 2.f * t);
+}
+
+// Straight-alpha "over", like sf::BlendAlpha. Colors are 0..1.
+void blend(std::uint8_t* dst, float r, float g, float b, float a) {
+    if (a <= 0.f) return;
+    a = std::min(a, 1.f);
+    auto mix = [a](std::uint8_t d, float s) {
+        float v = std::clamp(s, 0.f, 1.f) * 255.f * a + d * (1.f - a);
+        return static_cast<std::uint8_t>(v + 0.5f);
+    };
+    dst[0] = mix(dst[0], r);
+    dst[1] = mix(dst[1], g);
+    dst[2] = mix(dst[2], b);
+    dst[3] = static_cast<std::uint8_t>(std::min(255.f, a * 255.f + dst[3] * (1.f - a) + 0.5f));
+}
+
+// Calls f(pixel, x, distance) for every pixel whose center is within
+// `reach` of (cx, cy), with x = distance / radius.
+template <class F>
+void forDisc(RasterImage& img, float cx, float cy, float radius, float reach, F&& f) {
+    int x0 = std::max(0, static_cast<int>(std::floor(cx - reach)));
+    int x1 = std::min(img.width - 1, static_cast<int>(std::ceil(cx + reach)));
+    int y0 = std::max(0, static_cast<int>(std::floor(cy - reach)));
+    int y1 = std::min(img.height - 1, static_cast<int>(std::ceil(cy + reach)));
+    const float inv = 1.f / radius;
+
+    for (int py = y0; py <= y1; py++) {
+        float dy = py + 0.5f - cy;
+        std::uint8_t* row = img.pixels.data() + static_cast<std::size_t>(py) * img.width * 4;
+        for (int px = x0; px <= x1; px++) {
+            float dx = px + 0.5f - cx;
+            float d2 = dx * dx + dy * dy;
+            if (d2 > reach * reach) continue;
+            float d = std::sqrt(d2);
+            f(row + px * 4, d * inv, d);
+        }
+    }
+}
+
+void drawBody(RasterImage& img, float cx, float cy, float r, Rgba c, bool shader) {
+    const float cr = c.r / 255.f, cg = c.g / 255.f, cb = c.b / 255.f, ca = c.a / 255.f;
+
+    forDisc(img, cx, cy, r, r, [&](std::uint8_t* p, float x, float) {
+        float tex = discAlpha(x);
+        if (!shader) {
+            blend(p, cr, cg, cb, ca * tex);
+            return;
+        }
+        // bubble.frag, body branch
+        float edge = smoothstep(0.8f, 1.f, x);
+        float glow = 1.f - smoothstep(0.f, 0.6f, x);
+        auto shade = [&](float base) { return base * 1.4f + (base - base * 1.4f) * x + 0.15f * glow; };
+        blend(p, shade(cr), shade(cg), shade(cb), ca * (1.f - 0.6f * edge) * tex);
+    });
+}
+
+void drawShine(RasterImage& img, float cx, float cy, float r) {
+    const float a = kShine.a / 255.f;
+    forDisc(img, cx, cy, r, r, [&](std::uint8_t* p, float x, float) {
+        blend(p, kShine.r / 255.f, kShine.g / 255.f, kShine.b / 255.f, a * discAlpha(x));
+    });
+}
+
+// Band from radius to radius + thickness, a half pixel of coverage ramp on
+// either side. Position and sizes are in pixels.
+void drawRing(RasterImage& img, float cx, float cy, float radius, float thickness, Rgba color) {
+    const float inner = radius, outer = radius + thickness;
+    const float a = color.a / 255.f;
+    forDisc(img, cx, cy, radius, outer + 0.5f, [&](std::uint8_t* p, float, float d) {
+        float cover = std::clamp(d - inner + 0.5f, 0.f, 1.f) * std::clamp(outer - d + 0.5f, 0.f, 1.f);
+        blend(p, color.r / 255.f, color.g / 255.f, color.b / 255.f, a * cover);
+    });
+}
+
+// Same placement as shineCenter() in the bubble sim.
+void shineCenter(float cx, float cy, float radius, float width, float height, float& sx, float& sy) {
+    float t = (cx / width + cy / height) * 0.5f;
+    const float baseDeg = 25.f;
+    const float topDeg  = 80.f;
+    float angleRad = (baseDeg + t * (topDeg - baseDeg)) * 3.14159265f / 180.f;
+
+    float shineR = radius * 0.35f;
+    float dist = radius - shineR * 1.2f;
+    sx = cx + std::cos(angleRad) * dist;
+    sy = cy - std::sin(angleRad) * dist;
+}
+
+} // namespace
+
+bool popRingAt(const SimEvent& pop, float age, RasterRing& out) {
+    if (age < 0.f || age >= kRingLifetime) return false;
+    float t = age / kRingLifetime;
+    out.x = pop.x;
+    out.y = pop.y;
+    out.radius = pop.radius * 1.10f * (1.f + 0.4f * t);
+    out.color = pop.color;
+    out.color.a = static_cast<std::uint8_t>((1.f - t) * 200.f);
+    return true;
+}
+
+RasterView fitView(float worldWidth, float worldHeight,
+                   float x, float y, float w, float h, int width, int height) {
+    RasterView view;
+    view.worldWidth = worldWidth;
+    view.worldHeight = worldHeight;
+    view.scale = std::min(width / w, height / h);
+    view.left = x - (width / view.scale - w) * 0.5f;
+    view.top = y - (height / view.scale - h) * 0.5f;
+    return view;
+}
+
+void rasterizeBubbles(RasterImage& image, const RasterView& view, const TrajectoryFrame& frame,
+                      const std::vector<RasterRing>& rings, bool shader) {
+    std::uint8_t* p = image.pixels.data();
+    for (std::size_t i = 0, n = image.pixels.size(); i < n; i += 4) {
+        p[i] = kBackground.r;
+        p[i + 1] = kBackground.g;
+        p[i + 2] = kBackground.b;
+        p[i + 3] = kBackground.a;
+    }
+
+    const float k = view.scale;
+    // bodies wholly outside the image are skipped before any pixel work
+    auto visible = [&](float cx, float cy, float r) {
+        return cx + r >= 0.f && cx - r <= image.width && cy + r >= 0.f && cy - r <= image.height;
+    };
+    for (std::size_t i = 0; i < frame.size(); i++) {
+        float cx = (frame.x[i] - view.left) * k, cy = (frame.y[i] - view.top) * k, r = frame.radius[i] * k;
+        if (visible(cx, cy, r)) drawBody(image, cx, cy, r, frame.color[i], shader);
+    }
+    for (std::size_t i = 0; i < frame.size(); i++) {
+        float sx, sy;
+        shineCenter(frame.x[i], frame.y[i], frame.radius[i], view.worldWidth, view.worldHeight, sx, sy);
+        float cx = (sx - view.left) * k, cy = (sy - view.top) * k, r = frame.radius[i] * 0.35f * k;
+        if (visible(cx, cy, r)) drawShine(image, cx, cy, r);
+    }
+    for (const RasterRing& ring : rings) {
+        float cx = (ring.x - view.left) * k, cy = (ring.y - view.top) * k, r = ring.radius * k;
+        if (visible(cx, cy, r + kRingThickness * k + 1.f)) drawRing(image, cx, cy, r, kRingThickness * k, ring.color);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../core/recorder.hpp"
+
+// Software renderer for the bubble look, for turning recordings into
+// frames without a window or a GL context. It draws what BubbleBatch draws
+// (bodies, then shines, then pop rings) and, with shader set, shades the
+// bodies the way assets/bubble.frag does. Pure function of its inputs, so
+// any number of frames can be rendered on different threads at once.
+
+struct RasterImage {
+    int width = 0, height = 0;
+    std::vector<std::uint8_t> pixels;     // RGBA, rows top to bottom
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        pixels.resize(static_cast<std::size_t>(w) * h * 4);
+    }
+};
+
+// A pop ring at the moment it is drawn; see popRingAt().
+struct RasterRing {
+    float x, y;
+    float radius;
+    Rgba color;
+};
+
+// Ring for a pop event `age` seconds after it happened, as the bubble sim
+// animates it. Returns false once the ring has faded out.
+bool popRingAt(const SimEvent& pop, float age, RasterRing& out);
+
+// Where the image looks at the world: world point (x, y) lands on pixel
+// ((x - left) * scale, (y - top) * scale). Everything scales with it, as
+// under the live camera's view; the world size places the shines.
+struct RasterView {
+    float left = 0, top = 0;
+    float scale = 1;                      // pixels per world unit
+    float worldWidth = 0, worldHeight = 0;
+};
+
+// Shows `view` (world units) in a width x height image, scaled to fit and
+// centered along the other axis.
+RasterView fitView(float worldWidth, float worldHeight,
+                   float x, float y, float w, float h, int width, int height);
+
+void rasterizeBubbles(RasterImage& image, const RasterView& view, const TrajectoryFrame& frame,
+                      const std::vector<RasterRing>& rings, bool shader);
@@ -0,0 +1,201 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../core/alloc_counter.hpp"
+#include "../core/audio_mixer.hpp"
+#include "../core/profiler.hpp"
+#include "../core/recorder.hpp"
+#include "../core/scenarios.hpp"
+#include "../core/slab_world.hpp"
+#include "../core/snapshot.hpp"
+
+// Runs a sim without a window, at full speed.
+//   ./physicSimsHeadless [balls|balls-gravity|bubbles] [steps] [count] [dt] [threads] [seed]
+// PHYS_PROFILE=1, PHYS_PROFILE_DUMP=<file> and PHYS_TRACE=<file> turn on the
+// profiler; every step then counts as one frame.
+// PHYS_LOAD=<file> starts from a snapshot instead of spawning (the sim name
+// still picks the config it is checked against), PHYS_SAVE=<file> writes one
+// after the run. PHYS_RECORD=<file> records every step (see recorder.hpp).
+// PHYS_CCD=0/1 turns swept collision off or on, whatever the sim's default.
+// PHYS_AUDIO=<file.wav> mixes the pops (assets/pop.wav) the way the bubble
+// sim plays them and writes the result, no audio device needed.
+// PHYS_ITERATIONS=<n> sets the contact solver's iterations (0 = single pass)
+// and PHYS_SLEEP=0/1 turns sleeping off or on.
+// PHYS_PROCESSES=<n> steps the world in n worker processes (see
+// slab_world.hpp), with the same result; it can't be recorded or mixed.
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    string sim = argc > 1 ? argv[1] : "bubbles";
+    int steps  = argc > 2 ? atoi(argv[2]) : 1000;
+    int count  = argc > 3 ? atoi(argv[3]) : -1;
+    float dt   = argc > 4 ? static_cast<float>(atof(argv[4])) : 1.f / 100.f;
+    int threads = argc > 5 ? atoi(argv[5]) : 0;
+    unsigned long long seed = argc > 6 ? strtoull(argv[6], nullptr, 10) : 1;
+
+    WorldConfig cfg;
+    if (!simConfig(sim, cfg)) {
+        cerr << "Unknown sim '" << sim << "' (balls, balls-gravity, bubbles)\n";
+        return 1;
+    }
+    cfg.threads = threads;
+    cfg.seed = seed;
+    if (const char* ccd = getenv("PHYS_CCD")) cfg.ccd = atoi(ccd) != 0;
+    if (const char* it = getenv("PHYS_ITERATIONS")) cfg.solverIterations = atoi(it);
+    if (const char* sleep = getenv("PHYS_SLEEP")) cfg.sleeping = atoi(sleep) != 0;
+
+    World world(cfg);
+    const char* loadPath = getenv("PHYS_LOAD");
+    if (loadPath && *loadPath) {
+        auto l0 = chrono::steady_clock::now();
+        if (!loadSnapshot(loadPath, world)) return 1;
+        auto l1 = chrono::steady_clock::now();
+        cout << "loaded " << world.bodies().size() << " bodies from " << loadPath << " in "
+             << chrono::duration<double>(l1 - l0).count() * 1e3 << " ms\n";
+        if (world.config().bubbleRules != cfg.bubbleRules) {
+            cerr << "Warning: snapshot is not a '" << sim << "' world\n";
+        }
+    }
+    else spawnBodies(world, count);
+
+    const char* recordPath = getenv("PHYS_RECORD");
+    const char* audioPath = getenv("PHYS_AUDIO");
+    const int processes = getenv("PHYS_PROCESSES") ? atoi(getenv("PHYS_PROCESSES")) : 0;
+    if (processes > 0 && ((recordPath && *recordPath) || (audioPath && *audioPath))) {
+        cerr << "PHYS_PROCESSES can't be combined with PHYS_RECORD or PHYS_AUDIO\n";
+        return 1;
+    }
+
+    // With allocation counting compiled in, let scratch buffers reach their
+    // steady-state size first, then require the timed run to allocate nothing.
+    // Worker processes pass messages, which allocate, so they aren't counted.
+    const bool countAllocs = allocationCountingEnabled() && processes == 0;
+    if (countAllocs) {
+        world.run(100, dt);
+    }
+
+    size_t startBodies = world.bodies().size();
+    uint64_t allocsBefore = allocationCount();
+
+    Profiler& profiler = Profiler::get();
+    profiler.configureFromEnv();
+
+    TrajectoryRecorder recorder;
+    if (recordPath && *recordPath) {
+        RecorderOptions options;
+        options.stepDt = dt;
+        if (!recorder.open(recordPath, world, options)) return 1;
+        recorder.record(world);     // the starting state
+    }
+
+    AudioClip popClip;
+    unique_ptr<PopMixer> mixer;
+    WavWriter wav;
+    vector<int16_t> audio;
+    double audioDue = 0.0;      // frames owed to the file, fractional part carried over
+    if (audioPath && *audioPath) {
+        if (!loadWav("assets/pop.wav", popClip)) return 1;
+        mixer.reset(new PopMixer(popClip));
+        if (!wav.open(audioPath, PopMixer::kChannels, mixer->sampleRate())) return 1;
+        audio.resize((static_cast<size_t>(dt * mixer->sampleRate()) + 1) * PopMixer::kChannels);
+    }
+
+    SlabWorld slabs;
+    if (processes > 0 && !slabs.start(world, processes)) return 1;
+
+    auto t0 = chrono::steady_clock::now();
+    if (processes > 0) {
+        for (int s = 0; s < steps; s++) {
+            if (!slabs.step(dt)) return 1;
+            slabs.clearEvents();
+            PROF_FRAME();
+        }
+    } else if (profiler.enabled() || recorder.isOpen() || mixer) {
+        for (int s = 0; s < steps; s++) {
+            world.step(dt);
+            recorder.record(world);
+            if (mixer) {
+                for (const SimEvent& e : world.events()) {
+                    if (e.type == EventType::Pop) mixer->post(popSound(e, world.config().width));
+                }
+                audioDue += static_cast<double>(dt) * mixer->sampleRate();
+                size_t frames = static_cast<size_t>(audioDue);
+                audioDue -= static_cast<double>(frames);
+                mixer->mix(audio.data(), frames);
+                wav.write(audio.data(), frames);
+            }
+            world.clearEvents();
+            PROF_FRAME();
+        }
+    } else {
+        world.run(steps, dt);
+    }
+    auto t1 = chrono::steady_clock::now();
+    if (processes > 0 && !slabs.gather(world)) return 1;
+
+    uint64_t allocs = allocationCount() - allocsBefore;
+
+    double secs = chrono::duration<double>(t1 - t0).count();
+    const WorldStats& st = world.stats();
+
+    cout << sim << ": " << steps << " steps, "
+         << startBodies << " -> " << world.bodies().size() << " bodies, "
+         << st.pops << " pops, " << st.merges << " merges";
+    if (cfg.ccd) cout << ", " << st.sweptHits << " swept hits";
+    if (cfg.sleeping) cout << ", " << world.sleepingCount() << " asleep";
+    cout << "\n";
+    cout << "  " << secs * 1e3 << " ms total, "
+         << secs * 1e6 / (steps > 0 ? steps : 1) << " us/step";
+    if (processes > 0) cout << ", " << slabs.workers() << " worker processes";
+    cout << "\n";
+
+    if (profiler.enabled()) {
+        for (const auto& s : profiler.sectionStats()) {
+            cout << "  " << s.name << ": p50 " << s.p50 << " ms, p95 " << s.p95
+                 << " ms, p99 " << s.p99 << " ms\n";
+        }
+        for (const auto& c : profiler.counterStats()) {
+            cout << "  " << c.name << ": " << c.mean << " per step\n";
+        }
+        profiler.stopTrace();
+    }
+
+    if (recorder.isOpen()) {
+        recorder.close();
+        cout << "  recorded " << recorder.recordedFrames() << " steps ("
+             << recorder.droppedFrames() << " dropped) to " << recordPath << ", "
+             << recorder.bytesWritten() / 1024.0 << " KiB\n";
+    }
+
+    if (mixer) {
+        uint64_t frames = wav.framesWritten();
+        if (!wav.close()) {
+            cerr << "Failed to write " << audioPath << "\n";
+            return 1;
+        }
+        cout << "  mixed " << mixer->posted() << " pops (" << mixer->dropped() << " dropped, "
+             << mixer->stolen() << " voices stolen) into " << audioPath << ", "
+             << static_cast<double>(frames) / mixer->sampleRate() << " s\n";
+    }
+
+    const char* savePath = getenv("PHYS_SAVE");
+    if (savePath && *savePath) {
+        auto w0 = chrono::steady_clock::now();
+        if (!saveSnapshot(savePath, world)) return 1;
+        auto w1 = chrono::steady_clock::now();
+        cout << "  saved snapshot to " << savePath << " in "
+             << chrono::duration<double>(w1 - w0).count() * 1e3 << " ms\n";
+    }
+
+    if (countAllocs) {
+        cout << "  " << allocs << " heap allocations during the run\n";
+        if (allocs > 0) return 2;
+    }
+    return 0;
+}
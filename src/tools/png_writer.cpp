@@ -0,0 +1,220 @@
+#include "png_writer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const std::uint16_t kLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+const std::uint8_t kLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+const std::uint16_t kDistBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+const std::uint8_t kDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+const int kWindow = 32768;
+const int kMaxMatch = 258;
+const int kHashBits = 15;
+
+struct BitWriter {
+    std::vector<std::uint8_t>& out;
+    std::uint32_t bits = 0;
+    int count = 0;
+
+    // value's low n bits, least significant first
+    void put(std::uint32_t value, int n) {
+        bits |= value << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back(static_cast<std::uint8_t>(bits));
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Huffman codes are defined most significant bit first
+    void putCode(std::uint32_t code, int n) {
+        std::uint32_t rev = 0;
+        for (int i = 0; i < n; i++) rev |= ((code >> i) & 1) << (n - 1 - i);
+        put(rev, n);
+    }
+
+    void flush() {
+        if (count > 0) out.push_back(static_cast<std::uint8_t>(bits));
+        bits = 0;
+        count = 0;
+    }
+};
+
+// Fixed literal/length code (RFC 1951, 3.2.6).
+void putSymbol(BitWriter& w, int sym) {
+    if (sym < 144)      w.putCode(0x30 + sym, 8);
+    else if (sym < 256) w.putCode(0x190 + (sym - 144), 9);
+    else if (sym < 280) w.putCode(sym - 256, 7);
+    else                w.putCode(0xC0 + (sym - 280), 8);
+}
+
+void putMatch(BitWriter& w, int length, int distance) {
+    int l = 28;
+    while (kLengthBase[l] > length) l--;
+    putSymbol(w, 257 + l);
+    if (kLengthExtra[l]) w.put(length - kLengthBase[l], kLengthExtra[l]);
+
+    int d = 29;
+    while (kDistBase[d] > distance) d--;
+    w.putCode(d, 5);
+    if (kDistExtra[d]) w.put(distance - kDistBase[d], kDistExtra[d]);
+}
+
+std::uint32_t hash3(const std::uint8_t* p) {
+    std::uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+// zlib stream (RFC 1950) holding one fixed-Huffman deflate block.
+void deflate(const std::vector<std::uint8_t>& in, std::vector<std::uint8_t>& out) {
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    BitWriter w{ out };
+    w.put(1, 1);    // final block
+    w.put(1, 2);    // fixed Huffman
+
+    std::vector<std::int32_t> head(1u << kHashBits, -1);
+    const int n = static_cast<int>(in.size());
+    const std::uint8_t* data = in.data();
+
+    int i = 0;
+    while (i < n) {
+        int bestLen = 0, bestDist = 0;
+        if (i + 3 <= n) {
+            std::uint32_t h = hash3(data + i);
+            int cand = head[h];
+            head[h] = i;
+            if (cand >= 0 && i - cand <= kWindow) {
+                int limit = std::min(kMaxMatch, n - i);
+                int len = 0;
+                while (len < limit && data[cand + len] == data[i + len]) len++;
+                if (len >= 3) {
+                    bestLen = len;
+                    bestDist = i - cand;
+                }
+            }
+        }
+
+        if (bestLen) {
+            putMatch(w, bestLen, bestDist);
+            // index a few positions inside the match so later rows find it
+            int end = i + bestLen;
+            for (int k = i + 1; k < end && k + 3 <= n; k += (bestLen > 32 ? 16 : 1)) {
+                head[hash3(data + k)] = k;
+            }
+            i = end;
+        } else {
+            putSymbol(w, data[i]);
+            i++;
+        }
+    }
+    putSymbol(w, 256);
+    w.flush();
+
+    // Adler-32; 5552 bytes is the most that can be summed before b overflows
+    std::uint32_t a = 1, b = 0;
+    for (std::size_t pos = 0; pos < in.size();) {
+        std::size_t end = std::min(in.size(), pos + 5552);
+        for (; pos < end; pos++) {
+            a += in[pos];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    std::uint32_t adler = (b << 16) | a;
+    for (int s = 24; s >= 0; s -= 8) out.push_back(static_cast<std::uint8_t>(adler >> s));
+}
+
+std::uint32_t crc32(const std::uint8_t* p, std::size_t n, std::uint32_t crc = 0) {
+    static std::uint32_t table[256];
+    static bool ready = [] {
+        for (std::uint32_t k = 0; k < 256; k++) {
+            std::uint32_t c = k;
+            for (int j = 0; j < 8; j++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[k] = c;
+        }
+        return true;
+    }();
+    (void)ready;
+
+    crc = ~crc;
+    for (std::size_t i = 0; i < n; i++) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void putU32(std::vector<std::uint8_t>& out, std::uint32_t v) {
+    for (int s = 24; s >= 0; s -= 8) out.push_back(static_cast<std::uint8_t>(v >> s));
+}
+
+void putChunk(std::vector<std::uint8_t>& out, const char* type, const std::uint8_t* data, std::size_t n) {
+    putU32(out, static_cast<std::uint32_t>(n));
+    std::size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + n);
+    putU32(out, crc32(out.data() + start, n + 4));
+}
+
+} // namespace
+
+void encodePng(const std::uint8_t* pixels, int width, int height, std::vector<std::uint8_t>& out) {
+    // every row gets filter type 0 (none); matches against the row above
+    // do the work a filter would
+    const std::size_t stride = static_cast<std::size_t>(width) * 4;
+    std::vector<std::uint8_t> raw;
+    raw.reserve((stride + 1) * height);
+    for (int y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels + y * stride, pixels + (y + 1) * stride);
+    }
+
+    std::vector<std::uint8_t> z;
+    deflate(raw, z);
+
+    out.clear();
+    const std::uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.insert(out.end(), signature, signature + 8);
+
+    std::vector<std::uint8_t> ihdr;
+    putU32(ihdr, static_cast<std::uint32_t>(width));
+    putU32(ihdr, static_cast<std::uint32_t>(height));
+    const std::uint8_t rest[5] = { 8, 6, 0, 0, 0 };   // 8-bit RGBA, no interlace
+    ihdr.insert(ihdr.end(), rest, rest + 5);
+
+    putChunk(out, "IHDR", ihdr.data(), ihdr.size());
+    putChunk(out, "IDAT", z.data(), z.size());
+    putChunk(out, "IEND", nullptr, 0);
+}
+
+bool writePng(const std::string& path, const std::uint8_t* pixels, int width, int height,
+              std::vector<std::uint8_t>& scratch) {
+    encodePng(pixels, width, height, scratch);
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+    bool ok = std::fwrite(scratch.data(), 1, scratch.size(), f) == scratch.size();
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) std::cerr << "Failed to write " << path << "\n";
+    return ok;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal PNG encoder for 8-bit RGBA images, so tools can write frames
+// without pulling in SFML or libpng. Compression is single-block deflate
+// with the fixed Huffman code and a greedy hash matcher: far from optimal,
+// but the flat backgrounds and repeated rows of a sim frame shrink a lot.
+
+// pixels holds width * height * 4 bytes, rows top to bottom. out is
+// overwritten.
+void encodePng(const std::uint8_t* pixels, int width, int height, std::vector<std::uint8_t>& out);
+
+bool writePng(const std::string& path, const std::uint8_t* pixels, int width, int height,
+              std::vector<std::uint8_t>& scratch);
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../core/recorder.hpp"
+#include "../core/thread_pool.hpp"
+#include "bubble_raster.hpp"
+#include "png_writer.hpp"
+
+// Renders a recording (see PHYS_RECORD in headless.cpp) to images, off-screen
+// and as fast as the cores allow.
+//
+//   ./physicSimsReplay run.traj [--out frames] [--every 2] [--threads 0]
+//                      [--size WxH] [--view x,y,w,h] [--no-shader] [--raw]
+//
+// Writes frames/frame_000000.png, ... one per `every` recorded steps, drawn
+// with the bubble look (bubble.frag shading unless --no-shader). --view picks
+// the world rectangle to show (default the whole world), --size the image
+// size it is scaled to fit (default the view at one pixel per world unit,
+// shrunk to fit 1600x1000 like the live window), so huge worlds never need
+// huge images. --raw writes raw RGBA frames to stdout instead, for piping
+// into a video encoder:
+//   ./physicSimsReplay run.traj --size 1280x720 --raw | ffmpeg -f rawvideo
+//       -pix_fmt rgba -s 1280x720 -r 50 -i - clip.mp4
+// Frames are rendered in parallel, one per thread, and written in order.
+
+using namespace std;
+
+namespace {
+
+// Largest default image, as for the live window (see windowSizeFor()).
+const int kMaxWidth  = 1600;
+const int kMaxHeight = 1000;
+
+struct RecordedPop {
+    uint64_t step;
+    SimEvent event;
+};
+
+// All pops of the recording in step order, decoded a chunk per thread.
+vector<RecordedPop> collectPops(const TrajectoryReader& reader, ThreadPool& pool) {
+    vector<vector<RecordedPop>> perChunk(reader.chunkCount());
+    pool.parallelFor(reader.chunkCount(), [&](size_t begin, size_t end) {
+        vector<TrajectoryFrame> frames;
+        for (size_t c = begin; c < end; c++) {
+            if (!reader.readChunk(c, frames)) continue;
+            for (const TrajectoryFrame& f : frames) {
+                for (const SimEvent& e : f.events) {
+                    if (e.type == EventType::Pop) perChunk[c].push_back({ f.step, e });
+                }
+            }
+        }
+    });
+
+    vector<RecordedPop> pops;
+    for (auto& v : perChunk) pops.insert(pops.end(), v.begin(), v.end());
+    return pops;
+}
+
+// Rings still animating at `step`: pops from the last ring lifetime.
+void ringsAt(const vector<RecordedPop>& pops, uint64_t step, float stepDt, vector<RasterRing>& out) {
+    out.clear();
+    auto last = upper_bound(pops.begin(), pops.end(), step,
+                            [](uint64_t s, const RecordedPop& p) { return s < p.step; });
+    for (auto it = last; it != pops.begin();) {
+        --it;
+        // the live sim ages a ring by one frame before first drawing it
+        float age = static_cast<float>(step - it->step + 1) * stepDt;
+        RasterRing ring;
+        if (!popRingAt(it->event, age, ring)) break;     // older pops have faded too
+        out.push_back(ring);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    string input;
+    string outDir = "frames";
+    int every = 1;
+    int threads = 0;
+    bool shader = true;
+    bool raw = false;
+    int width = 0, height = 0;                     // 0: from the view
+    float viewX = 0, viewY = 0, viewW = 0, viewH = 0;  // 0 size: the whole world
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        auto value = [&]() -> string { return i + 1 < argc ? argv[++i] : ""; };
+        if (arg == "--out")            outDir = value();
+        else if (arg == "--every")     every = max(1, atoi(value().c_str()));
+        else if (arg == "--threads")   threads = atoi(value().c_str());
+        else if (arg == "--size") {
+            if (sscanf(value().c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                cerr << "--size takes WxH, e.g. 1280x720\n";
+                return 1;
+            }
+        }
+        else if (arg == "--view") {
+            if (sscanf(value().c_str(), "%f,%f,%f,%f", &viewX, &viewY, &viewW, &viewH) != 4 ||
+                viewW <= 0 || viewH <= 0) {
+                cerr << "--view takes x,y,w,h in world units\n";
+                return 1;
+            }
+        }
+        else if (arg == "--no-shader") shader = false;
+        else if (arg == "--raw")       raw = true;
+        else if (!arg.empty() && arg[0] != '-' && input.empty()) input = arg;
+        else {
+            cerr << "Unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+    if (input.empty()) {
+        cerr << "usage: physicSimsReplay <recording> [--out dir] [--every n] [--threads n]\n"
+                "                        [--size WxH] [--view x,y,w,h] [--no-shader] [--raw]\n";
+        return 1;
+    }
+
+    // stdout carries the video in raw mode
+    ostream& log = raw ? cerr : cout;
+
+    TrajectoryReader reader;
+    if (!reader.open(input)) return 1;
+    const TrajectoryInfo& info = reader.info();
+    if (info.width <= 0 || info.height <= 0) {
+        cerr << input << " has no world size\n";
+        return 1;
+    }
+    if (viewW <= 0) {
+        viewW = info.width;
+        viewH = info.height;
+    }
+    if (width <= 0) {
+        float fit = min({ 1.f, kMaxWidth / viewW, kMaxHeight / viewH });
+        width = max(1, static_cast<int>(viewW * fit));
+        height = max(1, static_cast<int>(viewH * fit));
+    }
+    const RasterView view = fitView(info.width, info.height, viewX, viewY, viewW, viewH, width, height);
+
+    if (!raw) {
+        error_code ec;
+        filesystem::create_directories(outDir, ec);
+        if (ec) {
+            cerr << "Failed to create " << outDir << ": " << ec.message() << "\n";
+            return 1;
+        }
+    }
+
+    ThreadPool pool(threads);
+    auto t0 = chrono::steady_clock::now();
+    const vector<RecordedPop> pops = collectPops(reader, pool);
+
+    // one slot per thread: a batch renders pool.size() frames at once
+    const size_t slots = static_cast<size_t>(pool.size());
+    vector<RasterImage> images(slots);
+    vector<vector<RasterRing>> rings(slots);
+    vector<vector<uint8_t>> pngs(slots);
+    for (auto& img : images) img.resize(width, height);
+
+    vector<TrajectoryFrame> frames;
+    vector<const TrajectoryFrame*> batch;
+    batch.reserve(slots);
+    size_t written = 0;
+    atomic<bool> failed{ false };
+
+    auto flush = [&]() {
+        pool.parallelFor(batch.size(), [&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; s++) {
+                ringsAt(pops, batch[s]->step, info.stepDt, rings[s]);
+                rasterizeBubbles(images[s], view, *batch[s], rings[s], shader);
+                if (!raw) {
+                    char name[32];
+                    snprintf(name, sizeof(name), "frame_%06zu.png", written + s);
+                    if (!writePng(outDir + "/" + name, images[s].pixels.data(), width, height, pngs[s])) {
+                        failed = true;
+                    }
+                }
+            }
+        });
+        if (raw) {
+            for (size_t s = 0; s < batch.size(); s++) {
+                const auto& px = images[s].pixels;
+                if (fwrite(px.data(), 1, px.size(), stdout) != px.size()) failed = true;
+            }
+        }
+        written += batch.size();
+        batch.clear();
+    };
+
+    uint64_t index = 0;
+    for (size_t c = 0; c < reader.chunkCount() && !failed; c++) {
+        if (!reader.readChunk(c, frames)) {
+            cerr << "Chunk " << c << " of " << input << " is corrupt, stopping there\n";
+            break;
+        }
+        for (const TrajectoryFrame& f : frames) {
+            if (index++ % every != 0) continue;
+            batch.push_back(&f);
+            if (batch.size() == slots) flush();
+        }
+        // frames is reused by the next chunk
+        if (!batch.empty()) flush();
+    }
+    if (raw) fflush(stdout);
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    log << "rendered " << written << " frames (" << width << "x" << height << ") in "
+        << secs << " s, " << (secs > 0 ? written / secs : 0.0) << " frames/s on "
+        << pool.size() << " threads\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,516 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/core/contacts.hpp"
+#include "../src/core/scenarios.hpp"
+#include "../src/core/slab_world.hpp"
+#include "../src/core/world_batch.hpp"
+
+// Physics checks, run headless on the stock sims with fixed seeds.
+//
+//   ./physicSimsTests [name filter] [--update-golden] [--no-budgets]
+//
+// Three kinds of test:
+//  - laws: momentum is kept at restitution 1.0, energy is only ever lost at
+//    0.8 and by no more than the restitution allows, and bodies don't stay
+//    overlapped by more than a tolerance;
+//  - engines: every fast path (SIMD, threads, the grid, WorldBatch,
+//    SlabWorld) gives the same result, bit for bit, as the reference path:
+//    scalar kernels on one thread, and an all-pairs contact search;
+//  - golden runs: the stock sims match trajectories stored in tests/golden.
+//    A change that means to change the physics rewrites them with
+//    --update-golden; the diff then shows what moved. Other compilers and
+//    CPUs can round differently, so they are compared with a tolerance.
+//
+// Every test also has a time budget, a few times what it takes on a laptop
+// in an -O2 build; --no-budgets skips those (debug or sanitizer builds).
+// Runs from the repository root; exits 1 if anything failed.
+
+using namespace std;
+
+namespace {
+
+const string kGoldenDir = "tests/golden/";
+
+bool updateGolden = false;
+
+// ---- Harness ----
+
+int failures = 0;           // in the running test
+
+void fail(const string& what) {
+    if (failures < 5) cout << "    " << what << "\n";
+    failures++;
+}
+
+void expect(bool ok, const string& what) {
+    if (!ok) fail(what);
+}
+
+void expectNear(double value, double expected, double tolerance, const string& what) {
+    if (!(std::fabs(value - expected) <= tolerance)) {
+        ostringstream os;
+        os << what << ": " << value << ", expected " << expected << " +- " << tolerance;
+        fail(os.str());
+    }
+}
+
+struct Test {
+    string name;
+    double budgetMs;
+    function<void()> run;
+};
+
+// ---- Helpers ----
+
+World spawned(const WorldConfig& cfg, int count) {
+    World world(cfg);
+    spawnBodies(world, count);
+    return world;
+}
+
+// Reference engine: scalar kernels, one thread.
+WorldConfig reference(WorldConfig cfg) {
+    cfg.simd = SimdLevel::Scalar;
+    cfg.threads = 1;
+    return cfg;
+}
+
+// Balls with no walls (a periodic world) and no gravity: nothing but
+// contacts changes their momentum.
+WorldConfig ballGas(float restitution) {
+    WorldConfig cfg = bouncyBallConfig(false);
+    cfg.width = 1600.f;
+    cfg.height = 1200.f;
+    cfg.restitutionBall = restitution;
+    cfg.ccd = false;
+    cfg.periodic = true;
+    cfg.seed = 11;
+    return cfg;
+}
+
+struct Totals {
+    double px = 0.0, py = 0.0;
+    double momentumScale = 0.0;     // sum of |m v|, for relative tolerances
+    double energy = 0.0;
+};
+
+Totals totals(const World& world) {
+    const BodyStore& s = world.bodies();
+    Totals t;
+    for (size_t i = 0; i < s.size(); i++) {
+        const double m = massOf(s.radius[i]);
+        t.px += m * s.vx[i];
+        t.py += m * s.vy[i];
+        t.momentumScale += m * std::sqrt(double(s.vx[i]) * s.vx[i] + double(s.vy[i]) * s.vy[i]);
+        t.energy += 0.5 * m * (double(s.vx[i]) * s.vx[i] + double(s.vy[i]) * s.vy[i]);
+    }
+    return t;
+}
+
+// Deepest overlap of any pair, as a fraction of the smaller radius.
+double worstOverlap(const World& world) {
+    const BodyStore& s = world.bodies();
+    const WorldConfig& cfg = world.config();
+    double worst = 0.0;
+    for (size_t i = 0; i < s.size(); i++) {
+        for (size_t j = i + 1; j < s.size(); j++) {
+            float dx = s.x[j] - s.x[i];
+            float dy = s.y[j] - s.y[i];
+            if (cfg.periodic) {
+                dx = wrapDelta(dx, cfg.width);
+                dy = wrapDelta(dy, cfg.height);
+            }
+            const double depth = s.radius[i] + s.radius[j] - std::sqrt(double(dx) * dx + double(dy) * dy);
+            worst = std::max(worst, depth / std::min(s.radius[i], s.radius[j]));
+        }
+    }
+    return worst;
+}
+
+bool sameState(const BodyStore& a, const BodyStore& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a.x[i] != b.x[i] || a.y[i] != b.y[i] || a.vx[i] != b.vx[i] || a.vy[i] != b.vy[i] ||
+            a.radius[i] != b.radius[i] || a.id[i] != b.id[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void expectSameRun(const World& reference, const World& other, const string& what) {
+    expect(sameState(reference.bodies(), other.bodies()), what + ": bodies differ from the reference");
+    expect(reference.stats().pops == other.stats().pops && reference.stats().merges == other.stats().merges,
+           what + ": pops or merges differ from the reference");
+}
+
+// ---- Conservation ----
+
+void elasticGasKeepsMomentum() {
+    World world = spawned(ballGas(1.f), 300);
+    const Totals before = totals(world);
+    for (int s = 0; s < 400; s++) {
+        world.step(1.f / 80.f);
+        world.clearEvents();
+    }
+    const Totals after = totals(world);
+    const double tolerance = 1e-5 * before.momentumScale;
+    expectNear(after.px, before.px, tolerance, "x momentum");
+    expectNear(after.py, before.py, tolerance, "y momentum");
+    expectNear(after.energy, before.energy, 1e-4 * before.energy, "kinetic energy at restitution 1");
+    expect(world.stats().contacts > 100, "the gas should collide");
+}
+
+// One head-on hit: the closing speed comes back scaled by the restitution,
+// and the energy lost is exactly what that costs.
+void headOnHit(float restitution) {
+    WorldConfig cfg = reference(bouncyBallConfig(false));
+    cfg.restitutionBall = restitution;
+    cfg.ccd = false;
+    World world(cfg);
+
+    Body a, b;
+    a.x = 300.f; a.y = 300.f; a.vx = 200.f; a.radius = 20.f;
+    b.x = 341.f; b.y = 300.f; b.vx = -100.f; b.radius = 10.f;
+    world.addBody(a);
+    world.addBody(b);
+
+    const Totals before = totals(world);
+    const double ma = massOf(a.radius), mb = massOf(b.radius);
+    const double reduced = ma * mb / (ma + mb);
+    const double closing = 300.0;
+
+    for (int s = 0; s < 40 && world.stats().contacts == 0; s++) world.step(0.001f);
+    expect(world.stats().contacts == 1, "one contact");
+
+    const BodyStore& st = world.bodies();
+    const Totals after = totals(world);
+    const double separating = double(st.vx[1]) - st.vx[0];
+    expectNear(separating, restitution * closing, 1e-3 * closing, "separating speed");
+    expectNear(after.px, before.px, 1e-6 * before.momentumScale, "momentum");
+    const double lost = (1.0 - double(restitution) * restitution) * 0.5 * reduced * closing * closing;
+    expectNear(before.energy - after.energy, lost, 1e-5 * before.energy, "energy lost");
+}
+
+void headOnHits() {
+    headOnHit(1.f);
+    headOnHit(0.8f);
+}
+
+// At restitution 0.8 no step may add energy (the head-on hits above check
+// how much one collision loses).
+void inelasticGasLosesEnergy() {
+    World world = spawned(ballGas(0.8f), 300);
+    const double start = totals(world).energy;
+    double energy = start;
+    for (int s = 0; s < 400; s++) {
+        world.step(1.f / 80.f);
+        world.clearEvents();
+        const double now = totals(world).energy;
+        expect(now <= energy * (1.0 + 1e-6), "step " + to_string(s) + " added energy");
+        energy = now;
+    }
+    expect(energy < 0.95 * start, "collisions at 0.8 should lose energy");
+    expect(energy > 0.0, "the gas should still be moving");
+
+    // the elastic gas from the same start keeps it, so what is lost is the
+    // restitution's doing
+    World elastic = spawned(ballGas(1.f), 300);
+    for (int s = 0; s < 400; s++) elastic.step(1.f / 80.f);
+    expectNear(totals(elastic).energy, start, 1e-4 * start, "elastic energy");
+}
+
+// Two bubbles touching across the seam of a periodic world merge there,
+// not halfway across the world.
+void mergeAcrossSeam() {
+    WorldConfig cfg = reference(WorldConfig());
+    cfg.width = 1000.f;
+    cfg.height = 1000.f;
+    cfg.bubbleRules = true;
+    cfg.rules.mergeOdds = 1;
+    cfg.periodic = true;
+    World world(cfg);
+
+    Body a, b;
+    a.x = 2.f;   a.y = 500.f; a.radius = 5.f;
+    b.x = 995.f; b.y = 500.f; b.radius = 5.f;
+    world.addBody(a);
+    world.addBody(b);
+    world.step(0.01f);
+
+    const BodyStore& s = world.bodies();
+    expect(world.stats().merges == 1 && s.size() == 1, "the pair should merge");
+    if (s.size() != 1) return;
+    expectNear(s.x[0], 998.5, 1e-3, "merged x");
+    expectNear(s.y[0], 500.0, 1e-3, "merged y");
+}
+
+// Overlap that outlives the solver, measured after the opening steps so
+// the spawn's own overlaps are gone. Piles and bubble clusters keep some.
+void overlapStaysSmall(const string& sim, int count, float dt, double tolerance) {
+    WorldConfig cfg;
+    simConfig(sim, cfg);
+    cfg.seed = 3;
+    World world = spawned(cfg, count);
+    double worst = 0.0;
+    for (int s = 0; s < 400; s++) {
+        world.step(dt);
+        world.clearEvents();
+        if (s >= 50) worst = std::max(worst, worstOverlap(world));
+    }
+    expect(worst <= tolerance, sim + ": overlap of " + to_string(worst) + " radii");
+}
+
+void residualOverlap() {
+    overlapStaysSmall("balls", 60, 1.f / 80.f, 0.05);
+    overlapStaysSmall("balls-gravity", 60, 1.f / 80.f, 0.3);
+    overlapStaysSmall("bubbles", 200, 1.f / 100.f, 0.4);
+}
+
+// The stock pile, swept collision and all, comes to rest: slow swept hits
+// mustn't bounce any more than slow contacts do.
+void ballPileSettles() {
+    WorldConfig cfg;
+    simConfig("balls-gravity", cfg);
+    cfg.threads = 1;
+    expect(cfg.ccd && cfg.sleeping, "balls-gravity should sweep and sleep");
+    World world = spawned(cfg, 300);
+    world.run(1500, 1.f / 80.f);
+
+    const BodyStore& s = world.bodies();
+    size_t asleep = 0;
+    for (size_t i = 0; i < s.size(); i++) asleep += s.asleep(i) ? 1 : 0;
+    expect(asleep == s.size(), to_string(asleep) + " of " + to_string(s.size()) + " asleep");
+}
+
+// ---- Engines against the reference ----
+
+void gridFindsEveryPair() {
+    WorldConfig cfg = reference(bouncyBubbleConfig());
+    World world = spawned(cfg, 2000);
+    const BodyStore& s = world.bodies();
+
+    float maxRadius = 0.f;
+    for (float r : s.radius) maxRadius = std::max(maxRadius, r);
+    UniformGrid grid;
+    grid.build(s.x.data(), s.y.data(), s.size(), maxRadius);
+    ThreadPool pool(4);
+    Narrowphase narrowphase;
+    vector<Contact> contacts;
+    narrowphase.find(s, grid, pool, contacts);
+
+    set<pair<uint32_t, uint32_t>> found;
+    for (const Contact& c : contacts) found.insert({ c.a, c.b });
+
+    set<pair<uint32_t, uint32_t>> all;
+    for (uint32_t i = 0; i < s.size(); i++) {
+        for (uint32_t j = i + 1; j < s.size(); j++) {
+            const float dx = s.x[j] - s.x[i];
+            const float dy = s.y[j] - s.y[i];
+            const float minDist = s.radius[i] + s.radius[j];
+            const float d2 = dx * dx + dy * dy;
+            if (d2 >= minDist * minDist) continue;
+            // coincident centers have no normal and are left alone
+            const float dist = std::sqrt(d2);
+            if (dist > 0 && dist < minDist) all.insert({ i, j });
+        }
+    }
+    expect(found.size() == contacts.size(), "a pair was reported twice");
+    expect(found == all, to_string(found.size()) + " contacts found, " + to_string(all.size()) + " overlap");
+}
+
+// Worlds big and crowded enough for the threaded paths: at least
+// kParallelBodies bodies and, in the biggest contact colors, at least
+// kParallelContacts contacts (contacts.cpp). Each SIMD level runs on one
+// thread and on four.
+void fastPathsMatchReference(const string& sim, float width, float height, int count, int steps, float dt) {
+    WorldConfig cfg;
+    simConfig(sim, cfg);
+    cfg.width = width;
+    cfg.height = height;
+    World ref = spawned(reference(cfg), count);
+    ref.run(steps, dt);
+
+    for (SimdLevel level : simdLevels()) {
+        for (int threads : { 1, 4 }) {
+            if (level == SimdLevel::Scalar && threads == 1) continue;   // the reference
+            WorldConfig fast = cfg;
+            fast.simd = level;
+            fast.threads = threads;
+            World world = spawned(fast, count);
+            world.run(steps, dt);
+            expectSameRun(ref, world, sim + " with " + simdLevelName(level) + " on " + to_string(threads) + " threads");
+        }
+    }
+}
+
+void simdAndThreads() {
+    fastPathsMatchReference("balls", 2800.f, 2100.f, 5000, 12, 1.f / 80.f);
+    fastPathsMatchReference("balls-gravity", 2800.f, 2100.f, 5000, 12, 1.f / 80.f);
+    fastPathsMatchReference("bubbles", 1440.f, 1080.f, 10000, 12, 1.f / 100.f);     // stock size
+}
+
+void lockstepBatch() {
+    vector<World> refs;
+    WorldBatch batch;
+    for (uint64_t seed = 1; seed <= 10; seed++) {
+        WorldConfig cfg = seed % 2 ? bouncyBubbleConfig() : bouncyBallConfig(false);
+        cfg.ccd = false;
+        cfg.seed = seed;
+        refs.push_back(spawned(reference(cfg), 100));
+        expect(batch.add(refs.back()), "batch refused a world");
+    }
+    batch.run(300, 1.f / 100.f);
+    for (size_t k = 0; k < refs.size(); k++) {
+        refs[k].run(300, 1.f / 100.f);
+        World member(refs[k].config());
+        batch.copyTo(k, member);
+        expectSameRun(refs[k], member, "batch member " + to_string(k));
+    }
+}
+
+void slabProcesses() {
+    WorldConfig cfg = bouncyBubbleConfig();
+    World ref = spawned(reference(cfg), 2000);
+    const World start = spawned(cfg, 2000);
+    ref.run(200, 1.f / 100.f);
+
+    for (int workers : { 1, 3 }) {
+        SlabWorld slabs;
+        World world(cfg);
+        expect(slabs.start(start, workers), "slab workers didn't start");
+        expect(slabs.run(200, 1.f / 100.f) && slabs.gather(world), "slab workers failed");
+        expectSameRun(ref, world, to_string(workers) + " slab workers");
+    }
+}
+
+// ---- Golden runs ----
+
+// Every `every` steps: a "step <n> <count>" line, then a line per body.
+string trajectory(const string& sim, int count, int steps, int every, float dt) {
+    WorldConfig cfg;
+    simConfig(sim, cfg);
+    cfg.seed = 5;
+    World world = spawned(reference(cfg), count);
+    ostringstream os;
+    char line[160];
+    for (int s = 0; s <= steps; s++) {
+        if (s > 0) {
+            world.step(dt);
+            world.clearEvents();
+        }
+        if (s % every != 0) continue;
+        const BodyStore& b = world.bodies();
+        os << "step " << s << " " << b.size() << "\n";
+        for (size_t i = 0; i < b.size(); i++) {
+            snprintf(line, sizeof(line), "%.9g %.9g %.9g %.9g %.9g\n", b.x[i], b.y[i], b.vx[i], b.vy[i], b.radius[i]);
+            os << line;
+        }
+    }
+    return os.str();
+}
+
+void goldenRun(const string& sim, int count, int steps, int every, float dt) {
+    const string path = kGoldenDir + sim + ".txt";
+    const string run = trajectory(sim, count, steps, every, dt);
+    if (updateGolden) {
+        ofstream out(path);
+        out << run;
+        expect(static_cast<bool>(out), "failed to write " + path);
+        return;
+    }
+
+    ifstream in(path);
+    if (!in) {
+        fail("no " + path + " (run with --update-golden)");
+        return;
+    }
+    istringstream got(run);
+    string want, have;
+    for (int line = 1; getline(in, want); line++) {
+        if (!getline(got, have)) {
+            fail(path + ":" + to_string(line) + ": the run ended early");
+            return;
+        }
+        if (want == have) continue;
+        if (want.rfind("step", 0) == 0 || have.rfind("step", 0) == 0) {
+            fail(path + ":" + to_string(line) + ": '" + have + "', expected '" + want + "'");
+            return;
+        }
+        istringstream a(want), b(have);
+        for (double x, y; a >> x && b >> y;) {
+            if (std::fabs(x - y) > 1e-3 * (1.0 + std::fabs(x))) {
+                fail(path + ":" + to_string(line) + ": '" + have + "', expected '" + want + "'");
+                return;
+            }
+        }
+    }
+    expect(!getline(got, have), path + ": the run went on longer");
+}
+
+void goldenRuns() {
+    goldenRun("balls", 60, 200, 50, 1.f / 80.f);
+    goldenRun("balls-gravity", 60, 200, 50, 1.f / 80.f);
+    goldenRun("bubbles", 150, 200, 50, 1.f / 100.f);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    string filter;
+    bool budgets = true;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if      (arg == "--update-golden") updateGolden = true;
+        else if (arg == "--no-budgets")    budgets = false;
+        else if (filter.empty() && arg.rfind("--", 0) != 0) filter = arg;
+        else {
+            cerr << "Usage: physicSimsTests [name filter] [--update-golden] [--no-budgets]\n";
+            return 2;
+        }
+    }
+
+    const vector<Test> tests = {
+        { "elastic gas keeps momentum",      200, elasticGasKeepsMomentum },
+        { "head-on hits",                    100, headOnHits },
+        { "inelastic gas loses energy",      300, inelasticGasLosesEnergy },
+        { "merge across the seam",            50, mergeAcrossSeam },
+        { "residual overlap",                500, residualOverlap },
+        { "ball pile settles",               800, ballPileSettles },
+        { "grid finds every pair",           200, gridFindsEveryPair },
+        { "SIMD and threads",              20000, simdAndThreads },
+        { "lockstep batch",                  500, lockstepBatch },
+        { "slab processes",                 2000, slabProcesses },
+        { "golden runs",                     200, goldenRuns },
+    };
+
+    int ran = 0, failed = 0;
+    for (const Test& t : tests) {
+        if (!filter.empty() && t.name.find(filter) == string::npos) continue;
+        cout << t.name << "\n";
+        failures = 0;
+        auto t0 = chrono::steady_clock::now();
+        t.run();
+        const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        if (budgets && ms > t.budgetMs) {
+            fail("took " + to_string(ms) + " ms, budget " + to_string(t.budgetMs) + " ms");
+        }
+        cout << "  " << (failures ? "FAILED" : "ok") << " (" << ms << " ms)\n";
+        ran++;
+        if (failures) failed++;
+    }
+    cout << ran - failed << "/" << ran << " passed\n";
+    return failed ? 1 : 0;
+}